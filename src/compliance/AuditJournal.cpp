@@ -0,0 +1,471 @@
+﻿#include "AuditJournal.hpp"
+#include "core/ByteIO.hpp"
+#include "core/Crc32c.hpp"
+#include "core/FileSync.hpp"
+#include "core/XxHash64.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr char kMagic[8] = {'R', 'E', 'I', 'T', 'A', 'U', 'D', '1'};
+    constexpr size_t kFrameHeader = 8;          // u32 载荷长度 + u32 CRC32C
+    constexpr size_t kFixedPayload = 64;        // 定长部分，布局见encodeHeader
+    constexpr uint32_t kMaxPayload = 1u << 26;
+    constexpr size_t kMaxCode = 255;
+
+    using byteio::load;
+    using byteio::store;
+
+    // 载荷定长部分：序号、时刻、输入/规则摘要、三条点位、计算日、成分数
+    void encodeHeader(char* p, const AuditRecordHeader& h) {
+        store(p, h.sequence);
+        store(p + 8, h.timestamp_ns);
+        store(p + 16, h.inputs_hash);
+        store(p + 24, h.rules_hash);
+        store(p + 32, h.levels.price);
+        store(p + 40, h.levels.total_return);
+        store(p + 48, h.levels.net_total_return);
+        store(p + 56, static_cast<int32_t>(h.date));
+        store(p + 60, h.component_count);
+    }
+
+    AuditRecordHeader decodeHeader(const char* p, uint64_t offset) {
+        AuditRecordHeader h;
+        h.sequence = load<uint64_t>(p);
+        h.timestamp_ns = load<int64_t>(p + 8);
+        h.inputs_hash = load<uint64_t>(p + 16);
+        h.rules_hash = load<uint64_t>(p + 24);
+        h.levels.price = load<double>(p + 32);
+        h.levels.total_return = load<double>(p + 40);
+        h.levels.net_total_return = load<double>(p + 48);
+        h.date = load<int32_t>(p + 56);
+        h.component_count = load<uint32_t>(p + 60);
+        h.offset = offset;
+        return h;
+    }
+
+    // 自offset起至文件末尾是否全为零（掉电后文件系统补零的残缺尾部）
+    bool zeroTail(const std::string& path, uint64_t offset) {
+        std::ifstream file(path, std::ios::binary);
+        file.seekg(static_cast<std::streamoff>(offset));
+        char chunk[1 << 16];
+        while (file.read(chunk, sizeof(chunk)) || file.gcount() > 0) {
+            if (std::any_of(chunk, chunk + file.gcount(), [](char c) { return c != 0; })) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // data[from, size)中首个长度合法、完整且CRC32C校验通过的记录帧位置，没有时返回size
+    size_t findFrame(const char* data, size_t size, size_t from) {
+        for (size_t pos = from; pos + kFrameHeader + kFixedPayload <= size; ++pos) {
+            const uint32_t length = load<uint32_t>(data + pos);
+            if (length >= kFixedPayload && length <= kMaxPayload &&
+                length <= size - pos - kFrameHeader &&
+                crc32c(data + pos + kFrameHeader, length) == load<uint32_t>(data + pos + 4)) {
+                return pos;
+            }
+        }
+        return size;
+    }
+
+    // 读取文件[offset, size)
+    std::vector<char> readRange(const std::string& path, uint64_t offset, uint64_t size) {
+        std::vector<char> data(static_cast<size_t>(size - offset));
+        std::ifstream file(path, std::ios::binary);
+        file.seekg(static_cast<std::streamoff>(offset));
+        if (!file.read(data.data(), static_cast<std::streamsize>(data.size()))) {
+            throw std::runtime_error("无法读取审计日志: " + path);
+        }
+        return data;
+    }
+
+    // 整体写出文件并落盘
+    void writeSynced(const std::string& path, const char* data, size_t size) {
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            throw std::runtime_error("无法创建文件: " + path);
+        }
+        bool ok = std::fwrite(data, 1, size, file) == size && syncFile(file);
+        ok = std::fclose(file) == 0 && ok;
+        if (!ok) {
+            std::error_code ec;
+            fs::remove(path, ec);
+            throw std::runtime_error("写入文件失败: " + path);
+        }
+    }
+}
+
+int64_t auditNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+AuditJournalSettings AuditJournalSettings::fromRules(const json& rules) {
+    AuditJournalSettings settings;
+    json cfg = rules.value("audit_journal", json::object());
+    settings.enabled = cfg.value("enabled", settings.enabled);
+    settings.path = cfg.value("path", settings.path);
+    settings.fsync_batch = std::max<size_t>(cfg.value("fsync_batch", settings.fsync_batch), 1);
+    settings.fsync_interval_ms = cfg.value("fsync_interval_ms", settings.fsync_interval_ms);
+    return settings;
+}
+
+AuditJournal::AuditJournal(AuditJournalSettings settings)
+    : m_settings(std::move(settings)) {
+    const std::string& path = m_settings.path;
+    fs::path parent = fs::path(path).parent_path();
+    if (!parent.empty()) {
+        fs::create_directories(parent);
+    }
+
+    uint64_t size = fs::exists(path) ? fs::file_size(path) : 0;
+    if (size < sizeof(kMagic)) {
+        // 新日志或魔数未写完整
+        m_stats.recovered_bytes = size;
+        if (size > 0) {
+            fs::resize_file(path, 0);
+        }
+        size = 0;
+    } else {
+        // 校验已有记录，接续序号并截去残缺尾部
+        AuditJournalReader reader(path);
+        reader.scan([&](const AuditRecordHeader& header) {
+            m_sequence = header.sequence;
+            return true;
+        });
+        if (reader.validEnd() < size) {
+            m_stats.recovered_bytes = size - reader.validEnd();
+            fs::resize_file(path, reader.validEnd());
+        }
+    }
+    m_stats.last_sequence = m_sequence;
+
+    m_file = std::fopen(path.c_str(), "ab");
+    if (!m_file) {
+        throw std::runtime_error("无法打开审计日志: " + path);
+    }
+    if (size == 0) {
+        if (std::fwrite(kMagic, 1, sizeof(kMagic), m_file) != sizeof(kMagic) || !syncFile(m_file)) {
+            std::fclose(m_file);
+            throw std::runtime_error("写入审计日志失败: " + path);
+        }
+        // 新建的日志文件目录项也须落盘，否则掉电后整个文件可能消失
+        if (!syncDirectory(parent.string())) {
+            std::fclose(m_file);
+            throw std::runtime_error("同步目录失败: " + path);
+        }
+    }
+    m_lastSync = Clock::now();
+}
+
+AuditJournal::~AuditJournal() {
+    try {
+        sync();
+    } catch (...) {
+    }
+    std::fclose(m_file);
+}
+
+uint64_t AuditJournal::append(int date, uint64_t inputsHash, uint64_t rulesHash,
+                              const IndexLevels& levels,
+                              const std::vector<Component>& components) {
+    std::lock_guard lock(m_mutex);
+    if (m_broken) {
+        throw std::runtime_error("审计日志此前写入失败，须重新打开: " + m_settings.path);
+    }
+
+    size_t payload = kFixedPayload;
+    for (const auto& comp : components) {
+        if (comp.reit.code.size() > kMaxCode) {
+            throw std::runtime_error("审计记录成分代码过长: " + comp.reit.code);
+        }
+        payload += sizeof(double) + 1 + comp.reit.code.size();
+    }
+    if (payload > kMaxPayload) {
+        throw std::runtime_error("审计记录过大");
+    }
+
+    AuditRecordHeader header;
+    header.sequence = m_sequence + 1;
+    header.timestamp_ns = auditNow();
+    header.date = date;
+    header.component_count = static_cast<uint32_t>(components.size());
+    header.inputs_hash = inputsHash;
+    header.rules_hash = rulesHash;
+    header.levels = levels;
+
+    m_frame.resize(kFrameHeader + payload);
+    char* body = m_frame.data() + kFrameHeader;
+    encodeHeader(body, header);
+    char* p = body + kFixedPayload;
+    for (const auto& comp : components) {
+        store(p, comp.weight);
+        p[sizeof(double)] = static_cast<char>(comp.reit.code.size());
+        std::memcpy(p + sizeof(double) + 1, comp.reit.code.data(), comp.reit.code.size());
+        p += sizeof(double) + 1 + comp.reit.code.size();
+    }
+    store(m_frame.data(), static_cast<uint32_t>(payload));
+    store(m_frame.data() + 4, crc32c(body, payload));
+
+    // 整帧一次写出并交给操作系统；失败时文件尾部可能残缺，不再追加，下次打开时截去
+    if (std::fwrite(m_frame.data(), 1, m_frame.size(), m_file) != m_frame.size() ||
+        std::fflush(m_file) != 0) {
+        m_broken = true;
+        throw std::runtime_error("写入审计日志失败: " + m_settings.path);
+    }
+    m_sequence = header.sequence;
+    ++m_stats.records;
+    ++m_stats.pending;
+    m_stats.bytes += m_frame.size();
+    m_stats.last_sequence = m_sequence;
+
+    if (m_stats.pending >= m_settings.fsync_batch ||
+        Clock::now() - m_lastSync >= std::chrono::milliseconds(m_settings.fsync_interval_ms)) {
+        syncLocked();
+    }
+    return m_sequence;
+}
+
+void AuditJournal::sync() {
+    std::lock_guard lock(m_mutex);
+    syncLocked();
+}
+
+void AuditJournal::syncLocked() {
+    if (m_stats.pending == 0) {
+        return;
+    }
+    if (!syncFile(m_file)) {
+        throw std::runtime_error("同步审计日志失败: " + m_settings.path);
+    }
+    ++m_stats.fsyncs;
+    m_stats.pending = 0;
+    m_lastSync = Clock::now();
+}
+
+AuditJournalStats AuditJournal::stats() const {
+    std::lock_guard lock(m_mutex);
+    return m_stats;
+}
+
+uint64_t AuditJournal::hashInputs(const REITList& reits) {
+    XxHash64 hasher;
+    auto text = [&](const std::string& s) {
+        uint64_t size = s.size();
+        hasher.update(&size, sizeof(size));
+        hasher.update(s.data(), s.size());
+    };
+    for (const auto& reit : reits) {
+        text(reit.code);
+        text(reit.name);
+        text(reit.sector);
+        text(reit.region);
+        const double values[] = {reit.market_cap, reit.dividend_amt,
+                                 reit.occupancy_rate, reit.debt_ratio};
+        hasher.update(values, sizeof(values));
+        hasher.update(&reit.ex_dividend_date, sizeof(reit.ex_dividend_date));
+    }
+    return hasher.digest();
+}
+
+uint64_t AuditJournal::hashRules(const json& rules) {
+    std::string text = rules.dump();
+    return XxHash64::hash(text.data(), text.size());
+}
+
+AuditRepairResult AuditJournal::repair(const std::string& path) {
+    const uint64_t size = fs::file_size(path);
+    std::vector<char> data = readRange(path, 0, size);
+    if (data.size() < sizeof(kMagic) || std::memcmp(data.data(), kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("审计日志格式无效: " + path);
+    }
+
+    // 逐帧复制校验通过的记录，遇到损坏帧时逐字节向后查找下一个有效帧
+    AuditRepairResult result;
+    std::vector<char> repaired(data.begin(), data.begin() + sizeof(kMagic));
+    repaired.reserve(data.size());
+    size_t pos = sizeof(kMagic);
+    while (pos < data.size()) {
+        const size_t next = findFrame(data.data(), data.size(), pos);
+        result.dropped_bytes += next - pos;
+        if (next == data.size()) {
+            break;
+        }
+        const size_t frame = kFrameHeader + load<uint32_t>(data.data() + next);
+        repaired.insert(repaired.end(), data.begin() + next, data.begin() + next + frame);
+        pos = next + frame;
+        ++result.records;
+    }
+    if (result.dropped_bytes == 0) {
+        return result;
+    }
+
+    // 先留下原文件的完整备份，再原子替换为修复后的日志
+    result.backup = path + ".corrupt";
+    for (int n = 1; fs::exists(result.backup); ++n) {
+        result.backup = path + ".corrupt." + std::to_string(n);
+    }
+    writeSynced(result.backup, data.data(), data.size());
+    const std::string tmp = path + ".tmp";
+    writeSynced(tmp, repaired.data(), repaired.size());
+    try {
+        replaceFile(tmp, path);
+    } catch (...) {
+        std::error_code ec;
+        fs::remove(tmp, ec);
+        throw;
+    }
+    return result;
+}
+
+AuditJournalReader::AuditJournalReader(std::string path, size_t bufferSize)
+    : m_path(std::move(path)), m_bufferSize(std::max<size_t>(bufferSize, 1 << 16)) {}
+
+size_t AuditJournalReader::scan(const std::function<bool(const AuditRecordHeader&)>& visit) {
+    std::FILE* file = std::fopen(m_path.c_str(), "rb");
+    if (!file) {
+        throw std::runtime_error("无法打开审计日志: " + m_path);
+    }
+    const uint64_t fileSize = fs::file_size(m_path);
+
+    std::vector<char> buffer(m_bufferSize);
+    uint64_t base = 0;          // buffer[0]对应的文件偏移
+    size_t begin = 0;
+    size_t end = 0;
+
+    // 保证缓冲中至少有need字节可读（不足则整理并续读），文件剩余不足时返回false
+    auto fill = [&](size_t need) {
+        if (end - begin >= need) {
+            return true;
+        }
+        std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+        base += begin;
+        end -= begin;
+        begin = 0;
+        if (need > buffer.size()) {
+            buffer.resize(std::max(need, buffer.size() * 2));
+        }
+        while (end < need) {
+            size_t n = std::fread(buffer.data() + end, 1, buffer.size() - end, file);
+            if (n == 0) {
+                return false;
+            }
+            end += n;
+        }
+        return true;
+    };
+
+    if (!fill(sizeof(kMagic)) || std::memcmp(buffer.data(), kMagic, sizeof(kMagic)) != 0) {
+        std::fclose(file);
+        throw std::runtime_error("审计日志格式无效: " + m_path);
+    }
+    begin = sizeof(kMagic);
+    m_validEnd = sizeof(kMagic);
+
+    size_t visited = 0;
+    bool stopped = false;
+    while (!stopped && fill(kFrameHeader)) {
+        const uint64_t offset = base + begin;
+        const uint32_t length = load<uint32_t>(buffer.data() + begin);
+        const uint32_t checksum = load<uint32_t>(buffer.data() + begin + 4);
+        const uint64_t frameEnd = offset + kFrameHeader + length;
+        const bool validLength = length >= kFixedPayload && length <= kMaxPayload;
+
+        if (!validLength || !fill(kFrameHeader + length) ||
+            crc32c(buffer.data() + begin + kFrameHeader, length) != checksum) {
+            // 其后全为零（文件系统补零）或延伸到文件末尾的帧可能是未写完的残缺尾部，
+            // 但长度字段损坏同样会使帧越过文件末尾：其后仍能找到有效帧时只能是中间数据损坏
+            if (zeroTail(m_path, offset)) {
+                break;
+            }
+            size_t next = 0;
+            if (validLength && frameEnd >= fileSize) {
+                std::vector<char> tail = readRange(m_path, offset, fileSize);
+                next = findFrame(tail.data(), tail.size(), 1);
+                if (next == tail.size()) {
+                    break;
+                }
+            }
+            std::fclose(file);
+            throw std::runtime_error("审计日志校验失败: " + m_path + " 偏移 " + std::to_string(offset) +
+                                     (next ? "，其后偏移 " + std::to_string(offset + next) + " 仍有有效记录" : "") +
+                                     "，须先修复（--audit-repair）");
+        }
+
+        AuditRecordHeader header = decodeHeader(buffer.data() + begin + kFrameHeader, offset);
+        begin += kFrameHeader + length;
+        m_validEnd = frameEnd;
+        ++visited;
+        stopped = !visit(header);
+    }
+    std::fclose(file);
+    return visited;
+}
+
+std::optional<AuditRecord> AuditJournalReader::publishedAt(int64_t timestampNs) {
+    // 系统时钟可能回拨，不依赖时刻单调：取不晚于T的最大时刻
+    std::optional<AuditRecordHeader> best;
+    scan([&](const AuditRecordHeader& header) {
+        if (header.timestamp_ns <= timestampNs &&
+            (!best || header.timestamp_ns > best->timestamp_ns ||
+             (header.timestamp_ns == best->timestamp_ns && header.sequence > best->sequence))) {
+            best = header;
+        }
+        return true;
+    });
+    if (!best) {
+        return std::nullopt;
+    }
+    return read(best->offset);
+}
+
+AuditRecord AuditJournalReader::read(uint64_t offset) {
+    std::ifstream file(m_path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("无法打开审计日志: " + m_path);
+    }
+    file.seekg(static_cast<std::streamoff>(offset));
+    char frame[kFrameHeader];
+    if (!file.read(frame, sizeof(frame))) {
+        throw std::runtime_error("审计记录不存在: 偏移 " + std::to_string(offset));
+    }
+    const uint32_t length = load<uint32_t>(frame);
+    if (length < kFixedPayload || length > kMaxPayload) {
+        throw std::runtime_error("审计记录长度无效: 偏移 " + std::to_string(offset));
+    }
+    std::vector<char> payload(length);
+    if (!file.read(payload.data(), length) ||
+        crc32c(payload.data(), length) != load<uint32_t>(frame + 4)) {
+        throw std::runtime_error("审计日志校验失败: " + m_path +
+                                 " 偏移 " + std::to_string(offset));
+    }
+
+    AuditRecord record;
+    record.header = decodeHeader(payload.data(), offset);
+    record.components.reserve(record.header.component_count);
+    const char* p = payload.data() + kFixedPayload;
+    const char* end = payload.data() + length;
+    for (uint32_t i = 0; i < record.header.component_count; ++i) {
+        if (end - p < static_cast<ptrdiff_t>(sizeof(double) + 1)) {
+            throw std::runtime_error("审计记录成分不完整: 偏移 " + std::to_string(offset));
+        }
+        AuditComponent comp;
+        comp.weight = load<double>(p);
+        size_t codeSize = static_cast<unsigned char>(p[sizeof(double)]);
+        p += sizeof(double) + 1;
+        if (static_cast<size_t>(end - p) < codeSize) {
+            throw std::runtime_error("审计记录成分不完整: 偏移 " + std::to_string(offset));
+        }
+        comp.code.assign(p, codeSize);
+        p += codeSize;
+        record.components.push_back(std::move(comp));
+    }
+    return record;
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include "core/IndexCalculator.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+struct AuditJournalSettings {
+    bool enabled = true;
+    std::string path = "../data/audit.journal";
+    size_t fsync_batch = 16;            // 累计未同步记录数达到该值时fsync（1为逐条同步）
+    uint32_t fsync_interval_ms = 1000;  // 距上次fsync超过该时长时下一条记录立即同步
+
+    // 从规则配置的 "audit_journal" 节解析
+    static AuditJournalSettings fromRules(const json& rules);
+};
+
+// 单条计算记录的定长部分
+struct AuditRecordHeader {
+    uint64_t sequence = 0;          // 记录序号（自1起，跨进程重启连续）
+    int64_t timestamp_ns = 0;       // 发布时刻（系统时钟，Unix纪元纳秒）
+    int date = 0;                   // 计算日（YYYYMMDD）
+    uint32_t component_count = 0;
+    uint64_t inputs_hash = 0;       // 输入行情数据版本（内容XXH64）
+    uint64_t rules_hash = 0;        // 指数规则版本（规则JSON的XXH64）
+    IndexLevels levels;
+    uint64_t offset = 0;            // 记录帧在日志文件中的偏移
+};
+
+struct AuditComponent {
+    std::string code;
+    double weight = 0.0;
+};
+
+struct AuditRecord {
+    AuditRecordHeader header;
+    std::vector<AuditComponent> components;
+};
+
+struct AuditJournalStats {
+    uint64_t records = 0;           // 本进程追加的记录数
+    uint64_t bytes = 0;
+    uint64_t fsyncs = 0;
+    uint64_t pending = 0;           // 已写入但尚未fsync的记录数
+    uint64_t last_sequence = 0;
+    uint64_t recovered_bytes = 0;   // 打开时截去的残缺尾部字节数
+};
+
+struct AuditRepairResult {
+    uint64_t records = 0;           // 保留的有效记录数
+    uint64_t dropped_bytes = 0;     // 丢弃的损坏区段与残缺尾部字节数
+    std::string backup;             // 修复前原文件的备份路径（无需修复时为空）
+};
+
+// 只追加的二进制审计日志：每次发布的指数计算记录一条
+// 文件以8字节魔数开头，其后为记录帧：[u32 载荷长度][u32 载荷CRC32C][载荷]，整数与浮点均为小端
+// 每条记录写入后即交给操作系统（进程崩溃不丢失），fsync按条数/时长成批进行（group commit）
+// 打开已有日志时校验全部记录，掉电导致的残缺尾部被截去后继续追加；
+// 损坏帧之后仍有有效帧时拒绝打开（抛出异常），须先以repair显式修复，不自动截去有效记录
+class AuditJournal {
+public:
+    explicit AuditJournal(AuditJournalSettings settings = {});
+
+    // 同步未落盘的记录后关闭
+    ~AuditJournal();
+
+    AuditJournal(const AuditJournal&) = delete;
+    AuditJournal& operator=(const AuditJournal&) = delete;
+
+    // 追加一条计算记录，返回记录序号（失败抛出异常）
+    uint64_t append(int date, uint64_t inputsHash, uint64_t rulesHash,
+                    const IndexLevels& levels, const std::vector<Component>& components);
+
+    // 立即fsync未同步的记录
+    void sync();
+
+    AuditJournalStats stats() const;
+    const AuditJournalSettings& settings() const { return m_settings; }
+
+    // 输入行情数据的内容摘要（参与计算的全部字段）
+    static uint64_t hashInputs(const REITList& reits);
+
+    // 规则配置的摘要
+    static uint64_t hashRules(const json& rules);
+
+    // 修复损坏的日志：原文件先完整备份，再重写为只含校验通过的记录帧（跳过损坏区段与残缺尾部）
+    // 各记录保留原序号；日志须未被打开，无损坏时不改动文件
+    static AuditRepairResult repair(const std::string& path);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void syncLocked();
+
+    AuditJournalSettings m_settings;
+    mutable std::mutex m_mutex;
+    std::FILE* m_file = nullptr;
+    std::vector<char> m_frame;          // 复用的记录编码缓冲
+    uint64_t m_sequence = 0;
+    Clock::time_point m_lastSync;
+    bool m_broken = false;              // 写入失败后尾部状态未知
+    AuditJournalStats m_stats;
+};
+
+// 审计日志读取器：按大块顺序读取，逐帧校验CRC32C，只解码定长部分
+// 校验失败的帧之后再无有效帧，且该帧延伸到文件末尾或其后全为零时视为掉电残缺部分忽略，否则抛出异常
+class AuditJournalReader {
+public:
+    explicit AuditJournalReader(std::string path, size_t bufferSize = 4 << 20);
+
+    // 顺序扫描全部有效记录，visit返回false时提前停止，返回访问的记录数
+    size_t scan(const std::function<bool(const AuditRecordHeader&)>& visit);
+
+    // 时刻T所发布的记录：发布时刻不晚于T的最新一条（时刻相同取序号大者），T早于首条记录时为空
+    std::optional<AuditRecord> publishedAt(int64_t timestampNs);
+
+    // 读取并解码指定偏移处的完整记录
+    AuditRecord read(uint64_t offset);
+
+    // 最近一次完整扫描得到的有效数据末尾偏移（其后为残缺尾部）
+    uint64_t validEnd() const { return m_validEnd; }
+
+private:
+    std::string m_path;
+    size_t m_bufferSize;
+    uint64_t m_validEnd = 0;
+};
+
+// 当前系统时刻（Unix纪元纳秒）
+int64_t auditNow();
@@ -0,0 +1,179 @@
+﻿#include "BinaryWriter.hpp"
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <string>
+
+template <typename T>
+void BinaryWriter::writeBigEndian(T number) {
+    using U = std::conditional_t<sizeof(T) == 8, uint64_t,
+              std::conditional_t<sizeof(T) == 4, uint32_t,
+              std::conditional_t<sizeof(T) == 2, uint16_t, uint8_t>>>;
+    U bits = std::bit_cast<U>(number);
+    char bytes[sizeof(T)];
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        bytes[i] = static_cast<char>(bits >> (8 * (sizeof(T) - 1 - i)));
+    }
+    m_sink.write(bytes, sizeof(T));
+}
+
+void BinaryWriter::cborHead(uint8_t base, uint64_t size) {
+    if (size <= 0x17) {
+        m_sink.put(static_cast<char>(base + size));
+    } else if (size <= 0xFF) {
+        m_sink.put(static_cast<char>(base + 0x18));
+        writeBigEndian(static_cast<uint8_t>(size));
+    } else if (size <= 0xFFFF) {
+        m_sink.put(static_cast<char>(base + 0x19));
+        writeBigEndian(static_cast<uint16_t>(size));
+    } else if (size <= 0xFFFFFFFF) {
+        m_sink.put(static_cast<char>(base + 0x1A));
+        writeBigEndian(static_cast<uint32_t>(size));
+    } else {
+        m_sink.put(static_cast<char>(base + 0x1B));
+        writeBigEndian(size);
+    }
+}
+
+void BinaryWriter::ubjsonNumber(uint64_t number) {
+    if (number <= static_cast<uint64_t>(std::numeric_limits<int8_t>::max())) {
+        m_sink.put('i');
+        writeBigEndian(static_cast<uint8_t>(number));
+    } else if (number <= std::numeric_limits<uint8_t>::max()) {
+        m_sink.put('U');
+        writeBigEndian(static_cast<uint8_t>(number));
+    } else if (number <= static_cast<uint64_t>(std::numeric_limits<int16_t>::max())) {
+        m_sink.put('I');
+        writeBigEndian(static_cast<int16_t>(number));
+    } else if (number <= static_cast<uint64_t>(std::numeric_limits<int32_t>::max())) {
+        m_sink.put('l');
+        writeBigEndian(static_cast<int32_t>(number));
+    } else if (number <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+        m_sink.put('L');
+        writeBigEndian(static_cast<int64_t>(number));
+    } else {
+        const std::string digits = std::to_string(number);
+        m_sink.put('H');
+        ubjsonNumber(digits.size());
+        m_sink.write(digits);
+    }
+}
+
+void BinaryWriter::beginObject(uint64_t size) {
+    if (m_encoding == Encoding::Ubjson) {
+        m_sink.write("{#", 2);
+        ubjsonNumber(size);
+    } else if (m_encoding == Encoding::Cbor) {
+        cborHead(0xA0, size);
+    } else if (size <= 15) {
+        m_sink.put(static_cast<char>(0x80 | size));
+    } else if (size <= 0xFFFF) {
+        m_sink.put(static_cast<char>(0xDE));
+        writeBigEndian(static_cast<uint16_t>(size));
+    } else {
+        m_sink.put(static_cast<char>(0xDF));
+        writeBigEndian(static_cast<uint32_t>(size));
+    }
+}
+
+void BinaryWriter::beginArray(uint64_t size) {
+    if (m_encoding == Encoding::Ubjson) {
+        m_sink.write("[#", 2);
+        ubjsonNumber(size);
+    } else if (m_encoding == Encoding::Cbor) {
+        cborHead(0x80, size);
+    } else if (size <= 15) {
+        m_sink.put(static_cast<char>(0x90 | size));
+    } else if (size <= 0xFFFF) {
+        m_sink.put(static_cast<char>(0xDC));
+        writeBigEndian(static_cast<uint16_t>(size));
+    } else {
+        m_sink.put(static_cast<char>(0xDD));
+        writeBigEndian(static_cast<uint32_t>(size));
+    }
+}
+
+void BinaryWriter::key(std::string_view name) {
+    if (m_encoding == Encoding::Ubjson) {
+        ubjsonNumber(name.size());
+        m_sink.write(name);
+        return;
+    }
+    value(name);
+}
+
+void BinaryWriter::value(std::string_view text) {
+    const uint64_t size = text.size();
+    if (m_encoding == Encoding::Ubjson) {
+        m_sink.put('S');
+        ubjsonNumber(size);
+    } else if (m_encoding == Encoding::Cbor) {
+        cborHead(0x60, size);
+    } else if (size <= 31) {
+        m_sink.put(static_cast<char>(0xA0 | size));
+    } else if (size <= 0xFF) {
+        m_sink.put(static_cast<char>(0xD9));
+        writeBigEndian(static_cast<uint8_t>(size));
+    } else if (size <= 0xFFFF) {
+        m_sink.put(static_cast<char>(0xDA));
+        writeBigEndian(static_cast<uint16_t>(size));
+    } else {
+        m_sink.put(static_cast<char>(0xDB));
+        writeBigEndian(static_cast<uint32_t>(size));
+    }
+    m_sink.write(text);
+}
+
+void BinaryWriter::value(uint64_t number) {
+    if (m_encoding == Encoding::Ubjson) {
+        ubjsonNumber(number);
+    } else if (m_encoding == Encoding::Cbor) {
+        cborHead(0x00, number);
+    } else if (number < 128) {
+        m_sink.put(static_cast<char>(number));
+    } else if (number <= 0xFF) {
+        m_sink.put(static_cast<char>(0xCC));
+        writeBigEndian(static_cast<uint8_t>(number));
+    } else if (number <= 0xFFFF) {
+        m_sink.put(static_cast<char>(0xCD));
+        writeBigEndian(static_cast<uint16_t>(number));
+    } else if (number <= 0xFFFFFFFF) {
+        m_sink.put(static_cast<char>(0xCE));
+        writeBigEndian(static_cast<uint32_t>(number));
+    } else {
+        m_sink.put(static_cast<char>(0xCF));
+        writeBigEndian(number);
+    }
+}
+
+void BinaryWriter::value(double number) {
+    if (m_encoding == Encoding::Ubjson) {
+        // nlohmann不区分精度，一律写float64（非有限值按位写出，读回不变）
+        m_sink.put('D');
+        writeBigEndian(number);
+        return;
+    }
+    if (m_encoding == Encoding::Cbor && !std::isfinite(number)) {
+        // 半精度 NaN 0xf97e00，±Infinity 0xf97c00 / 0xf9fc00
+        char half[3] = {static_cast<char>(0xF9), static_cast<char>(0x7C), 0};
+        if (std::isnan(number)) {
+            half[1] = static_cast<char>(0x7E);
+        } else if (number < 0) {
+            half[1] = static_cast<char>(0xFC);
+        }
+        m_sink.write(half, sizeof(half));
+        return;
+    }
+
+    bool single = !std::isfinite(number) ||
+                  (number >= std::numeric_limits<float>::lowest() &&
+                   number <= std::numeric_limits<float>::max() &&
+                   static_cast<double>(static_cast<float>(number)) == number);
+    if (single) {
+        m_sink.put(static_cast<char>(m_encoding == Encoding::Cbor ? 0xFA : 0xCA));
+        writeBigEndian(static_cast<float>(number));
+    } else {
+        m_sink.put(static_cast<char>(m_encoding == Encoding::Cbor ? 0xFB : 0xCB));
+        writeBigEndian(number);
+    }
+}
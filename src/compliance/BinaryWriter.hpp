@@ -0,0 +1,51 @@
+#pragma once
+#include "compliance/FileSink.hpp"
+#include <cstdint>
+#include <string_view>
+
+// 流式CBOR/MessagePack/UBJSON写出：直接写入FileSink，不构建DOM，容器须预先给出元素个数
+// 编码选择与 nlohmann::json::to_cbor/to_msgpack 一致（长度与无符号整数取最短形式，
+// 可无损转为单精度的浮点数写为单精度）；UBJSON容器为带元素个数的 `{#`/`[#` 形式、浮点数为float64，
+// 与 to_ubjson(j, true) 一致；同一文档的输出逐字节相同
+class BinaryWriter {
+public:
+    enum class Encoding : uint8_t {
+        Cbor,
+        MsgPack,
+        Ubjson
+    };
+
+    BinaryWriter(FileSink& sink, Encoding encoding) : m_sink(sink), m_encoding(encoding) {}
+
+    // 对象（size个键值对）与数组（size个元素）头
+    void beginObject(uint64_t size);
+    void beginArray(uint64_t size);
+
+    // 对象的键（UBJSON的键不带 'S' 类型标记）
+    void key(std::string_view name);
+
+    void value(std::string_view text);
+    void value(const char* text) { value(std::string_view(text)); }
+    void value(double number);
+    void value(uint64_t number);
+
+    // 键值对简写
+    template <typename T>
+    void field(std::string_view name, const T& v) {
+        key(name);
+        value(v);
+    }
+
+private:
+    // CBOR主类型头：base为主类型首字节（0x00/0x60/0x80/0xA0）
+    void cborHead(uint8_t base, uint64_t size);
+
+    // UBJSON整数：取能容纳的最小有符号类型（i/U/I/l/L），超出int64时为高精度十进制（H）
+    void ubjsonNumber(uint64_t number);
+
+    template <typename T>
+    void writeBigEndian(T number);
+
+    FileSink& m_sink;
+    Encoding m_encoding;
+};
@@ -0,0 +1,154 @@
+﻿#include "BulkReporter.hpp"
+#include "core/IndexHistory.hpp"
+#include "core/ThreadPool.hpp"
+#include "risk/PortfolioRiskService.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string_view>
+
+namespace fs = std::filesystem;
+
+namespace {
+    // 基金代码用作目录名，替换文件名中不允许的字符
+    std::string fundDirectory(const std::string& id) {
+        std::string name = id.empty() ? std::string("_") : id;
+        for (char& c : name) {
+            if (std::string_view("/\\:*?\"<>|").find(c) != std::string_view::npos ||
+                static_cast<unsigned char>(c) < 0x20) {
+                c = '_';
+            }
+        }
+        return name;
+    }
+}
+
+BulkReportSettings BulkReportSettings::fromRules(const json& rules) {
+    BulkReportSettings settings;
+    json cfg = rules.value("bulk_reporting", json::object());
+    settings.output_path = cfg.value("output_path", settings.output_path);
+    settings.threads = cfg.value("threads", settings.threads);
+    settings.buffer_size = std::max<size_t>(cfg.value("buffer_size", settings.buffer_size), 4096);
+    settings.progress_interval_ms = cfg.value("progress_interval_ms", settings.progress_interval_ms);
+    if (cfg.contains("formats")) {
+        settings.formats.clear();
+        for (const auto& name : cfg["formats"]) {
+            settings.formats.push_back(parseReportFormat(name.get<std::string>()));
+        }
+    }
+    return settings;
+}
+
+BulkReporter::BulkReporter(const ComplianceReporter& reporter, BulkReportSettings settings)
+    : m_reporter(reporter), m_settings(std::move(settings)) {}
+
+std::string BulkReporter::reportPath(const std::string& fund, int date, ReportFormat format) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%08d%s", date, reportExtension(format));
+    return (fs::path(m_settings.output_path) / fundDirectory(fund) / name).string();
+}
+
+std::shared_ptr<PortfolioBook> BulkReporter::fundBook(const IndexHistory& history) {
+    auto benchmark = std::make_shared<std::vector<Component>>(history.constituentCount());
+    for (size_t i = 0; i < history.constituentCount(); ++i) {
+        (*benchmark)[i].reit.code = history.code(i);
+    }
+    return std::make_shared<PortfolioBook>(std::move(benchmark));
+}
+
+BulkReportMetrics BulkReporter::run(const IndexHistory& history, const PortfolioBook* funds,
+                                    size_t firstPeriod, size_t lastPeriod,
+                                    const ProgressCallback& progress) const {
+    using Clock = std::chrono::steady_clock;
+    lastPeriod = std::min(lastPeriod, history.periodCount());
+    firstPeriod = std::min(firstPeriod, lastPeriod);
+
+    const size_t fundCount = funds ? funds->size() : 1;
+    std::vector<std::string> fundIds;
+    for (size_t p = 0; p < fundCount; ++p) {
+        fundIds.push_back(funds ? funds->id(p) : std::string(kIndexFund));
+        fs::create_directories(fs::path(m_settings.output_path) / fundDirectory(fundIds.back()));
+    }
+
+    // 日期主序：同时执行的任务读取同一期数据
+    const size_t jobs = (lastPeriod - firstPeriod) * fundCount;
+    const std::vector<int>& dates = history.dates();
+
+    std::optional<ThreadPool> ownPool;
+    if (m_settings.threads > 0) {
+        ownPool.emplace(m_settings.threads);
+    }
+    ThreadPool& pool = ownPool ? *ownPool : ThreadPool::shared();
+    std::vector<std::vector<char>> buffers(pool.size(), std::vector<char>(m_settings.buffer_size));
+
+    std::atomic<size_t> completed{0};
+    std::atomic<size_t> failed{0};
+    std::atomic<uint64_t> files{0};
+    std::atomic<uint64_t> bytes{0};
+    std::mutex errorMutex;
+    std::string firstError;
+
+    const Clock::time_point started = Clock::now();
+    auto snapshot = [&] {
+        BulkReportMetrics metrics;
+        metrics.jobs = jobs;
+        metrics.completed = completed.load(std::memory_order_relaxed);
+        metrics.failed = failed.load(std::memory_order_relaxed);
+        metrics.files = files.load(std::memory_order_relaxed);
+        metrics.bytes = bytes.load(std::memory_order_relaxed);
+        metrics.threads = pool.size();
+        metrics.elapsed_ms = std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+        if (metrics.elapsed_ms > 0.0) {
+            metrics.jobs_per_second = metrics.completed / (metrics.elapsed_ms / 1000.0);
+            metrics.mb_per_second = metrics.bytes / (1024.0 * 1024.0) / (metrics.elapsed_ms / 1000.0);
+        }
+        return metrics;
+    };
+    Clock::time_point lastProgress = started;
+    const auto progressInterval = std::chrono::milliseconds(m_settings.progress_interval_ms);
+
+    pool.parallelFor(0, jobs, 1, [&](size_t begin, size_t end, size_t worker) {
+        std::vector<char>& buffer = buffers[worker];
+        for (size_t j = begin; j < end; ++j) {
+            const size_t t = firstPeriod + j / fundCount;
+            const size_t p = j % fundCount;
+            try {
+                std::vector<Component> components = funds
+                    ? history.componentsAt(t, funds->components() + funds->begin(p),
+                                           funds->weights() + funds->begin(p),
+                                           funds->end(p) - funds->begin(p))
+                    : history.componentsAt(t);
+
+                for (ReportFormat format : m_settings.formats) {
+                    size_t written = m_reporter.writeFile(format, components,
+                                                          reportPath(fundIds[p], dates[t], format),
+                                                          m_reporter.reportDate(dates[t], format),
+                                                          &buffer);
+                    files.fetch_add(1, std::memory_order_relaxed);
+                    bytes.fetch_add(written, std::memory_order_relaxed);
+                }
+            } catch (const std::exception& e) {
+                if (failed.fetch_add(1, std::memory_order_relaxed) == 0) {
+                    std::lock_guard lock(errorMutex);
+                    firstError = fundIds[p] + " " + std::to_string(dates[t]) + ": " + e.what();
+                }
+            }
+            completed.fetch_add(1, std::memory_order_relaxed);
+
+            // 进度只在调用线程中回调
+            if (worker == 0 && progress && Clock::now() - lastProgress >= progressInterval) {
+                lastProgress = Clock::now();
+                progress(snapshot());
+            }
+        }
+    });
+
+    BulkReportMetrics metrics = snapshot();
+    std::lock_guard lock(errorMutex);
+    metrics.first_error = firstError;
+    return metrics;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "compliance/ComplianceReporter.hpp"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class IndexHistory;
+class PortfolioBook;
+
+struct BulkReportSettings {
+    std::string output_path = "../reports/bulk/";
+    std::vector<ReportFormat> formats{ReportFormat::Json};
+    size_t threads = 0;                     // 0为进程共享线程池
+    size_t buffer_size = 1 << 20;           // 每个工作线程复用的写出缓冲
+    uint32_t progress_interval_ms = 1000;
+
+    // 从规则配置的 "bulk_reporting" 节解析
+    static BulkReportSettings fromRules(const json& rules);
+};
+
+// 批量报告进度与吞吐
+struct BulkReportMetrics {
+    size_t jobs = 0;                // (基金, 日期) 任务数
+    size_t completed = 0;           // 已完成任务数（含失败）
+    size_t failed = 0;
+    uint64_t files = 0;
+    uint64_t bytes = 0;
+    size_t threads = 0;
+    double elapsed_ms = 0.0;
+    double jobs_per_second = 0.0;
+    double mb_per_second = 0.0;
+    std::string first_error;
+};
+
+// 批量报告：按 (基金, 日期) 将任务调度到线程池，每个任务从指数历史还原当期成分并写出配置的各格式
+// 文件为 <output_path>/<基金>/<YYYYMMDD><扩展名>，报告日期字段取 ComplianceReporter::reportDate（同当日生成的报告）；
+// 任务经 ComplianceReporter::writeFile 写出（与单份报告同一路径，同日同成分时与当日生成的报告逐字节相同），
+// 每个工作线程复用一块写出缓冲
+class BulkReporter {
+public:
+    using ProgressCallback = std::function<void(const BulkReportMetrics&)>;
+
+    BulkReporter(const ComplianceReporter& reporter, BulkReportSettings settings = {});
+
+    // 生成第[firstPeriod, lastPeriod)期的报告；funds为空时只有一只完全复制指数的基金（kIndexFund）
+    // 基金报告为其持仓中当期在样本内的成分（权重为持仓权重）；单个任务失败计入failed，不中断其余任务
+    // progress在调用线程中按progress_interval_ms回调
+    BulkReportMetrics run(const IndexHistory& history, const PortfolioBook* funds,
+                          size_t firstPeriod, size_t lastPeriod,
+                          const ProgressCallback& progress = {}) const;
+
+    // 任务输出文件
+    std::string reportPath(const std::string& fund, int date, ReportFormat format) const;
+
+    // 以指数历史全部代码（按列顺序）为基准的基金持仓簿，持仓成分序号即历史列号
+    static std::shared_ptr<PortfolioBook> fundBook(const IndexHistory& history);
+
+    static constexpr const char* kIndexFund = "index";
+
+private:
+    const ComplianceReporter& m_reporter;
+    BulkReportSettings m_settings;
+};
@@ -1,107 +1,531 @@
 ﻿#include "ComplianceReporter.hpp"
+#include "compliance/BinaryWriter.hpp"
+#include "compliance/CsvWriter.hpp"
+#include "compliance/JsonWriter.hpp"
+#include "compliance/ReportPipeline.hpp"
+#include "compliance/XbrlWriter.hpp"
+#include "core/IndexHistory.hpp"
+#include <cstdio>
 #include <ctime>
 #include <iomanip>
 #include <sstream>
+#include <algorithm>
 #include <filesystem>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <optional>
 
 namespace fs = std::filesystem;
 
-std::string ComplianceReporter::generateReport(
-    const std::vector<Component>& components) {
+namespace {
+    // 报告中的数值字段：JSON报告以null表示非有限值，读回为NaN（二进制编码直接保存NaN）
+    double reportNumber(const json& item, const char* key) {
+        const json& value = item.at(key);
+        if (value.is_null()) {
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+        return value.get<double>();
+    }
     
-    // 确保报告目录存在
-    fs::create_directories(m_reportPath);
+    // 单只基金申报的默认报告主体
+    const char* const kDefaultEntity = "REITs指数基金管理人";
     
-    // 创建文件名
-    time_t now = time(nullptr);
-    tm* ltm = localtime(&now);
-    std::ostringstream oss;
-    oss << m_reportPath << "REITs_Report_" 
-        << 1900 + ltm->tm_year 
-        << std::setfill('0') << std::setw(2) << ltm->tm_mon + 1
-        << std::setw(2) << ltm->tm_mday << ".json";
+    // localtime在部分平台返回共享静态缓冲，多个报告写出线程并发调用时加锁复制
+    tm localNow() {
+        static std::mutex mutex;
+        time_t now = time(nullptr);
+        std::lock_guard lock(mutex);
+        return *localtime(&now);
+    }
     
-    std::string filename = oss.str();
+    // 一个成分的XBRL上下文与事实（Number为double或已分解的DecimalText，写出相同）
+    template <typename Number>
+    void writeXbrlConstituent(XbrlWriter& writer, const char* id, const std::string& entity,
+                              const std::string& reportDate, const REIT& reit, const Number& weight,
+                              const Number& marketCap, const Number& dividend) {
+        writer.context(id, entity, reportDate, reit.code);
+        writer.fact("ConstituentName", id, reit.name);
+        writer.fact("ConstituentWeight", id, weight, XbrlWriter::kUnitPure);
+        writer.fact("Sector", id, reit.sector);
+        writer.fact("Region", id, reit.region);
+        writer.fact("MarketCapitalisation", id, marketCap, XbrlWriter::kUnitCny);
+        writer.fact("DividendAmount", id, dividend, XbrlWriter::kUnitCny);
+    }
     
-    // 创建JSON结构
-    json report;
-    report["report_date"] = oss.str();
-    report["component_count"] = components.size();
+    // JSON报告：键按字典序写出，与原DOM（std::map）输出一致
+    class JsonReportSink : public ReportFormatSink {
+    public:
+        JsonReportSink(std::unique_ptr<FileSink> file, std::string reportDate)
+            : m_file(std::move(file)), m_writer(*m_file), m_reportDate(std::move(reportDate)) {}
+        
+        const char* name() const override { return "json"; }
+        
+        void begin(size_t componentCount) override {
+            m_writer.beginObject();
+            m_writer.field("component_count", componentCount);
+            m_writer.key("components");
+            m_writer.beginArray();
+        }
+        
+        void write(const ReportRowBatch& batch) override {
+            for (const ReportRow& row : batch.rows) {
+                const REIT& reit = row.component->reit;
+                m_writer.beginObject();
+                m_writer.field("code", reit.code);
+                m_writer.field("dividend", row.dividend);
+                m_writer.field("market_cap", row.market_cap);
+                m_writer.field("name", reit.name);
+                m_writer.field("sector", reit.sector);
+                m_writer.field("weight", row.weight);
+                m_writer.endObject();
+            }
+        }
+        
+        void end() override {
+            m_writer.endArray();
+            m_writer.field("report_date", m_reportDate);
+            m_writer.endObject();
+            m_file->put('\n');
+            m_file->close();
+        }
+        
+    private:
+        std::unique_ptr<FileSink> m_file;
+        JsonWriter m_writer;
+        std::string m_reportDate;
+    };
     
-    json componentsJson = json::array();
-    for (const auto& comp : components) {
-        json compJson;
-        compJson["code"] = comp.reit.code;
-        compJson["name"] = comp.reit.name;
-        compJson["sector"] = comp.reit.sector;
-        compJson["weight"] = comp.weight;
-        compJson["market_cap"] = comp.reit.market_cap;
-        compJson["dividend"] = comp.reit.dividend_amt;
-        
-        componentsJson.push_back(compJson);
-    }
+    class CsvReportSink : public ReportFormatSink {
+    public:
+        explicit CsvReportSink(std::unique_ptr<FileSink> file)
+            : m_file(std::move(file)), m_csv(*m_file) {}
+        
+        const char* name() const override { return "csv"; }
+        
+        void begin(size_t) override {
+            m_csv.row({"Code", "Name", "Sector", "Region", "Weight", "MarketCap", "Dividend", "Occupancy"});
+        }
+        
+        void write(const ReportRowBatch& batch) override {
+            for (const ReportRow& row : batch.rows) {
+                const REIT& reit = row.component->reit;
+                m_csv.field(reit.code);
+                m_csv.field(reit.name);
+                m_csv.field(reit.sector);
+                m_csv.field(reit.region);
+                m_csv.field(row.weight);
+                m_csv.field(row.market_cap);
+                m_csv.field(row.dividend);
+                m_csv.field(row.occupancy);
+                m_csv.endRow();
+            }
+        }
+        
+        void end() override { m_file->close(); }
+        
+    private:
+        std::unique_ptr<FileSink> m_file;
+        CsvWriter m_csv;
+    };
     
-    report["components"] = componentsJson;
+    // 单只基金的XBRL实例（基金序号0）
+    class XbrlReportSink : public ReportFormatSink {
+    public:
+        XbrlReportSink(std::unique_ptr<FileSink> file, std::string schemaRef, std::string reportDate)
+            : m_file(std::move(file)), m_writer(*m_file), m_schemaRef(std::move(schemaRef)),
+              m_reportDate(std::move(reportDate)) {}
+        
+        const char* name() const override { return "xbrl"; }
+        
+        void begin(size_t componentCount) override {
+            m_writer.begin(m_schemaRef);
+            m_writer.context("F0", kDefaultEntity, m_reportDate);
+            m_writer.fact("ConstituentCount", "F0", static_cast<uint64_t>(componentCount),
+                          XbrlWriter::kUnitPure);
+        }
+        
+        void write(const ReportRowBatch& batch) override {
+            char id[48];
+            for (size_t j = 0; j < batch.rows.size(); ++j) {
+                const ReportRow& row = batch.rows[j];
+                snprintf(id, sizeof(id), "F0_C%zu", batch.first + j);
+                writeXbrlConstituent(m_writer, id, m_entity, m_reportDate, row.component->reit,
+                                     row.weight, row.market_cap, row.dividend);
+            }
+        }
+        
+        void end() override {
+            m_writer.end();
+            m_file->close();
+        }
+        
+    private:
+        std::unique_ptr<FileSink> m_file;
+        XbrlWriter m_writer;
+        std::string m_schemaRef;
+        std::string m_reportDate;
+        std::string m_entity = kDefaultEntity;
+    };
     
-    // 写入文件
-    std::ofstream outFile(filename);
-    if (!outFile) {
-        throw std::runtime_error("无法打开报告文件: " + filename);
+    // JSON报告的二进制编码：CBOR/MessagePack/UBJSON由BinaryWriter流式写出（元素个数预先已知）；
+    // BSON的文档与数组以int32总字节数开头，须写完内容才知道，只能逐批累积为文档后在结尾由nlohmann编码
+    class BinaryReportSink : public ReportFormatSink {
+    public:
+        BinaryReportSink(std::unique_ptr<FileSink> file, ReportFormat format, std::string reportDate)
+            : m_file(std::move(file)), m_format(format), m_reportDate(std::move(reportDate)) {
+            if (format == ReportFormat::Cbor) {
+                m_writer.emplace(*m_file, BinaryWriter::Encoding::Cbor);
+            } else if (format == ReportFormat::MsgPack) {
+                m_writer.emplace(*m_file, BinaryWriter::Encoding::MsgPack);
+            } else if (format == ReportFormat::Ubjson) {
+                m_writer.emplace(*m_file, BinaryWriter::Encoding::Ubjson);
+            } else if (!isBinaryReportFormat(format)) {
+                throw std::runtime_error(std::string("非二进制报告格式: ") + reportFormatName(format));
+            }
+        }
+        
+        const char* name() const override { return reportFormatName(m_format); }
+        
+        void begin(size_t componentCount) override {
+            if (m_writer) {
+                // 键按字典序，与nlohmann对象（std::map）一致
+                m_writer->beginObject(3);
+                m_writer->field("component_count", static_cast<uint64_t>(componentCount));
+                m_writer->key("components");
+                m_writer->beginArray(componentCount);
+                return;
+            }
+            m_components = json::array();
+            m_components.get_ref<json::array_t&>().reserve(componentCount);
+        }
+        
+        void write(const ReportRowBatch& batch) override {
+            for (const ReportRow& row : batch.rows) {
+                const REIT& reit = row.component->reit;
+                if (m_writer) {
+                    m_writer->beginObject(6);
+                    m_writer->field("code", reit.code);
+                    m_writer->field("dividend", row.dividend.value);
+                    m_writer->field("market_cap", row.market_cap.value);
+                    m_writer->field("name", reit.name);
+                    m_writer->field("sector", reit.sector);
+                    m_writer->field("weight", row.weight.value);
+                    continue;
+                }
+                m_components.push_back({
+                    {"code", reit.code},
+                    {"dividend", row.dividend.value},
+                    {"market_cap", row.market_cap.value},
+                    {"name", reit.name},
+                    {"sector", reit.sector},
+                    {"weight", row.weight.value}
+                });
+            }
+        }
+        
+        void end() override {
+            if (m_writer) {
+                m_writer->field("report_date", m_reportDate);
+                m_file->close();
+                return;
+            }
+            json report = {
+                {"component_count", m_components.size()},
+                {"components", std::move(m_components)},
+                {"report_date", m_reportDate}
+            };
+            std::vector<std::uint8_t> bytes;
+            json::to_bson(report, bytes);
+            m_file->write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+            m_file->close();
+        }
+        
+    private:
+        std::unique_ptr<FileSink> m_file;
+        ReportFormat m_format;
+        std::string m_reportDate;
+        std::optional<BinaryWriter> m_writer;
+        json m_components;
+    };
+}
+
+const char* reportFormatName(ReportFormat format) {
+    switch (format) {
+    case ReportFormat::Json: return "json";
+    case ReportFormat::Csv: return "csv";
+    case ReportFormat::Xbrl: return "xbrl";
+    case ReportFormat::Cbor: return "cbor";
+    case ReportFormat::MsgPack: return "msgpack";
+    case ReportFormat::Ubjson: return "ubjson";
+    case ReportFormat::Bson: return "bson";
     }
-    
-    outFile << std::setw(4) << report << std::endl;
-    return filename;
+    return "unknown";
+}
+
+ReportFormat parseReportFormat(const std::string& name) {
+    for (ReportFormat format : kReportFormats) {
+        if (name == reportFormatName(format)) {
+            return format;
+        }
+    }
+    throw std::runtime_error("未知报告格式: " + name);
+}
+
+const char* reportExtension(ReportFormat format) {
+    switch (format) {
+    case ReportFormat::Json: return ".json";
+    case ReportFormat::Csv: return ".csv";
+    case ReportFormat::Xbrl: return ".xbrl";
+    case ReportFormat::Cbor: return ".cbor";
+    case ReportFormat::MsgPack: return ".msgpack";
+    case ReportFormat::Ubjson: return ".ubj";
+    case ReportFormat::Bson: return ".bson";
+    }
+    return "";
+}
+
+bool isBinaryReportFormat(ReportFormat format) {
+    return format == ReportFormat::Cbor || format == ReportFormat::MsgPack ||
+           format == ReportFormat::Ubjson || format == ReportFormat::Bson;
+}
+
+std::string ComplianceReporter::reportFilename(int date, ReportFormat format) const {
+    std::ostringstream oss;
+    oss << m_reportPath << "REITs_Report_" << std::setfill('0') << std::setw(8) << date
+        << reportExtension(format);
+    return oss.str();
 }
 
-std::string ComplianceReporter::generateXbrlReport(
+std::string ComplianceReporter::reportDate(int date, ReportFormat format) const {
+    if (format != ReportFormat::Xbrl) {
+        return reportFilename(date, format);
+    }
+    char text[16];
+    snprintf(text, sizeof(text), "%04d-%02d-%02d", date / 10000, date / 100 % 100, date % 100);
+    return text;
+}
+
+std::unique_ptr<ReportFormatSink> ComplianceReporter::makeSink(ReportFormat format,
+                                                               std::unique_ptr<FileSink> file,
+                                                               const std::string& reportDate) const {
+    switch (format) {
+    case ReportFormat::Json:
+        return std::make_unique<JsonReportSink>(std::move(file), reportDate);
+    case ReportFormat::Csv:
+        return std::make_unique<CsvReportSink>(std::move(file));
+    case ReportFormat::Xbrl:
+        return std::make_unique<XbrlReportSink>(std::move(file), m_xbrlSchemaRef, reportDate);
+    default:
+        return std::make_unique<BinaryReportSink>(std::move(file), format, reportDate);
+    }
+}
+
+size_t ComplianceReporter::writeFile(ReportFormat format, const std::vector<Component>& components,
+                                     const std::string& filename, const std::string& reportDate,
+                                     std::vector<char>* buffer) const {
+    auto file = buffer ? std::make_unique<FileSink>(filename, *buffer)
+                       : std::make_unique<FileSink>(filename);
+    const FileSink& out = *file;
+    ReportPipeline pipeline;
+    pipeline.addSink(makeSink(format, std::move(file), reportDate));
+    pipeline.run(components);
+    return out.bytesWritten();
+}
+
+std::string ComplianceReporter::generateReport(
     const std::vector<Component>& components) {
+    return generate(ReportFormat::Json, components);
+}
+
+std::string ComplianceReporter::generate(ReportFormat format,
+                                         const std::vector<Component>& components) {
+    return generate(std::vector<ReportFormat>{format}, components).front();
+}
+
+std::vector<std::string> ComplianceReporter::generate(const std::vector<ReportFormat>& formats,
+                                                      const std::vector<Component>& components) {
+    // 确保报告目录存在
+    fs::create_directories(m_reportPath);
     
-    // XBRL模板（简化版）
-    std::ostringstream xbrl;
-    xbrl << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
-    xbrl << "<xbrl xmlns=\"http://www.xbrl.org/2003/instance\">\n";
-    xbrl << "  <header>\n";
-    xbrl << "    <reportingEntity>REITs指数基金管理人</reportingEntity>\n";
-    time_t now = time(nullptr);
-    xbrl << "    <reportDate>" << std::put_time(std::localtime(&now), "%Y-%m-%d") << "</reportDate>\n";
-    xbrl << "  </header>\n";
-    xbrl << "  <components>\n";
+    tm today = localNow();
+    const int date = (1900 + today.tm_year) * 10000 + (today.tm_mon + 1) * 100 + today.tm_mday;
     
-    for (const auto& comp : components) {
-        xbrl << "    <component>\n";
-        xbrl << "      <reitCode>" << comp.reit.code << "</reitCode>\n";
-        xbrl << "      <weight>" << comp.weight * 100 << "%</weight>\n";
-        xbrl << "      <sector>" << comp.reit.sector << "</sector>\n";
-        xbrl << "      <region>" << comp.reit.region << "</region>\n";
-        xbrl << "    </component>\n";
+    ReportPipeline pipeline;
+    std::vector<std::string> filenames;
+    for (ReportFormat format : formats) {
+        std::string filename = reportFilename(date, format);
+        if (std::find(filenames.begin(), filenames.end(), filename) != filenames.end()) {
+            continue;
+        }
+        pipeline.addSink(makeSink(format, std::make_unique<FileSink>(filename, m_files),
+                                  reportDate(date, format)));
+        filenames.push_back(std::move(filename));
+    }
+    pipeline.run(components);
+    return filenames;
+}
+
+void ComplianceReporter::writeReport(const std::vector<Component>& components,
+                                     const std::string& filename,
+                                     const std::string& reportDate) {
+    writeFile(ReportFormat::Json, components, filename, reportDate);
+}
+
+void ComplianceReporter::writeBinaryReport(const std::vector<Component>& components,
+                                           ReportFormat format, const std::string& filename,
+                                           const std::string& reportDate) {
+    if (!isBinaryReportFormat(format)) {
+        throw std::runtime_error(std::string("非二进制报告格式: ") + reportFormatName(format));
+    }
+    writeFile(format, components, filename, reportDate);
+}
+
+LoadedReport ComplianceReporter::loadReport(const std::string& filename) {
+    std::string extension = fs::path(filename).extension().string();
+    const ReportFormat* format = std::find_if(std::begin(kReportFormats), std::end(kReportFormats),
+        [&](ReportFormat f) { return extension == reportExtension(f); });
+    if (format == std::end(kReportFormats) ||
+        (*format != ReportFormat::Json && !isBinaryReportFormat(*format))) {
+        throw std::runtime_error("无法识别的报告编码: " + filename);
     }
     
-    xbrl << "  </components>\n";
-    xbrl << "</xbrl>";
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("无法打开报告文件: " + filename);
+    }
+    std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(file)),
+                                    std::istreambuf_iterator<char>());
+    
+    json report;
+    switch (*format) {
+    case ReportFormat::Cbor: report = json::from_cbor(bytes); break;
+    case ReportFormat::MsgPack: report = json::from_msgpack(bytes); break;
+    case ReportFormat::Ubjson: report = json::from_ubjson(bytes); break;
+    case ReportFormat::Bson: report = json::from_bson(bytes); break;
+    default: report = json::parse(bytes); break;
+    }
+    
+    LoadedReport loaded;
+    loaded.report_date = report.at("report_date").get<std::string>();
+    const json& components = report.at("components");
+    loaded.components.reserve(components.size());
+    for (const auto& item : components) {
+        Component comp{};
+        comp.reit.code = item.at("code").get<std::string>();
+        comp.reit.name = item.at("name").get<std::string>();
+        comp.reit.sector = item.at("sector").get<std::string>();
+        comp.reit.dividend_amt = reportNumber(item, "dividend");
+        comp.reit.market_cap = reportNumber(item, "market_cap");
+        comp.weight = reportNumber(item, "weight");
+        loaded.components.push_back(std::move(comp));
+    }
+    return loaded;
+}
+
+void ComplianceReporter::writeXbrlReport(const std::vector<Component>& components,
+                                         const std::string& filename,
+                                         const std::string& reportDate) {
+    writeFile(ReportFormat::Xbrl, components, filename, reportDate);
+}
+
+void ComplianceReporter::writeXbrlReport(const std::vector<XbrlFund>& funds,
+                                         const std::string& filename,
+                                         const std::string& reportDate) {
+    FileSink sink(filename);
+    XbrlWriter writer(sink);
+    writer.begin(m_xbrlSchemaRef);
+    for (size_t k = 0; k < funds.size(); ++k) {
+        if (funds[k].components) {
+            writeXbrlFund(writer, k, funds[k].entity, *funds[k].components, reportDate);
+        }
+    }
+    writer.end();
+    sink.close();
+}
+
+void ComplianceReporter::writeXbrlFund(XbrlWriter& writer, size_t fund, const std::string& entity,
+                                       const std::vector<Component>& components,
+                                       const std::string& reportDate) {
+    // 上下文ID：基金为 F<k>，成分为 F<k>_C<i>（按成分代码分部）
+    char id[48];
+    int prefix = snprintf(id, sizeof(id), "F%zu", fund);
+    writer.context(id, entity, reportDate);
+    writer.fact("ConstituentCount", id, static_cast<uint64_t>(components.size()),
+                XbrlWriter::kUnitPure);
     
-    return xbrl.str();
+    for (size_t i = 0; i < components.size(); ++i) {
+        const Component& comp = components[i];
+        snprintf(id + prefix, sizeof(id) - prefix, "_C%zu", i);
+        writeXbrlConstituent(writer, id, entity, reportDate, comp.reit, comp.weight,
+                             comp.reit.market_cap, comp.reit.dividend_amt);
+    }
 }
 
 void ComplianceReporter::exportToCSV(const std::vector<Component>& components, 
                                     const std::string& filename) {
+    writeFile(ReportFormat::Csv, components, filename, "");
+}
+
+void ComplianceReporter::exportToCSV(const IndexHistory& history, const std::string& filename) {
+    FileSink sink(filename);
+    CsvWriter csv(sink);
+    csv.row({"date", "code", "name", "sector", "region", "market_cap", "dividend_amt",
+             "occupancy_rate", "debt_ratio", "weight", "benchmark_weight", "return"});
     
-    std::ofstream csv(filename);
-    if (!csv) {
-        throw std::runtime_error("无法创建CSV文件: " + filename);
+    const std::vector<int>& dates = history.dates();
+    for (size_t t = 0; t < dates.size(); ++t) {
+        const double* marketCap = history.marketCaps(t);
+        const double* dividend = history.dividends(t);
+        const double* occupancy = history.occupancyRates(t);
+        const double* debt = history.debtRatios(t);
+        const double* weight = history.weights(t);
+        const double* benchmark = history.benchmarkWeights(t);
+        const double* ret = history.returns(t);
+        for (size_t i = 0; i < history.constituentCount(); ++i) {
+            if (marketCap[i] <= 0.0) {
+                continue; // 当期不在样本中
+            }
+            csv.field(dates[t]);
+            csv.field(history.code(i));
+            csv.field(history.name(i));
+            csv.field(history.sectors().name(history.sectorId(i)));
+            csv.field(history.regions().name(history.regionId(i)));
+            csv.field(marketCap[i]);
+            csv.field(dividend[i]);
+            csv.field(occupancy[i]);
+            csv.field(debt[i]);
+            csv.field(weight[i]);
+            csv.field(benchmark[i]);
+            csv.field(ret[i]);
+            csv.endRow();
+        }
     }
+    sink.close();
+}
+
+void ComplianceReporter::exportToCSV(const REITList& universe,
+                                     const std::vector<UniverseRank>& ranks,
+                                     const std::string& filename) {
+    FileSink sink(filename);
+    CsvWriter csv(sink);
+    csv.row({"Rank", "Code", "Name", "Sector", "Region", "Score", "Eligible",
+             "MarketCap", "Dividend", "Occupancy", "DebtRatio"});
     
-    // 写入标题行
-    csv << "Code,Name,Sector,Region,Weight,MarketCap,Dividend,Occupancy\n";
-    
-    // 写入数据
-    for (const auto& comp : components) {
-        csv << comp.reit.code << ","
-            << comp.reit.name << ","
-            << comp.reit.sector << ","
-            << comp.reit.region << ","
-            << comp.weight << ","
-            << comp.reit.market_cap << ","
-            << comp.reit.dividend_amt << ","
-            << comp.reit.occupancy_rate << "\n";
-    }
-}
\ No newline at end of file
+    for (const auto& r : ranks) {
+        const REIT& reit = universe.at(r.index);
+        csv.field(r.rank);
+        csv.field(reit.code);
+        csv.field(reit.name);
+        csv.field(reit.sector);
+        csv.field(reit.region);
+        csv.field(r.score);
+        csv.field(r.eligible ? 1 : 0);
+        csv.field(reit.market_cap);
+        csv.field(reit.dividend_amt);
+        csv.field(reit.occupancy_rate);
+        csv.field(reit.debt_ratio);
+        csv.endRow();
+    }
+    sink.close();
+}
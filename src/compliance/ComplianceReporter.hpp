@@ -1,5 +1,8 @@
 #pragma once
+#include "compliance/FileSink.hpp"
 #include "core/IndexCalculator.hpp"
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 #include <nlohmann/json.hpp>
@@ -8,23 +11,131 @@
 
 using json = nlohmann::json;
 
+class IndexHistory;
+class ReportFormatSink;
+class XbrlWriter;
+
+// 报告格式
+enum class ReportFormat : uint8_t {
+    Json,
+    Csv,
+    Xbrl,
+    Cbor,       // 以下为JSON报告的二进制编码（结构相同）
+    MsgPack,
+    Ubjson,
+    Bson
+};
+
+// 全部报告格式（按枚举顺序）
+inline constexpr ReportFormat kReportFormats[] = {
+    ReportFormat::Json, ReportFormat::Csv, ReportFormat::Xbrl, ReportFormat::Cbor,
+    ReportFormat::MsgPack, ReportFormat::Ubjson, ReportFormat::Bson
+};
+
+// 报告格式名称（json/csv/xbrl/cbor/msgpack/ubjson/bson），未知名称抛出异常
+const char* reportFormatName(ReportFormat format);
+ReportFormat parseReportFormat(const std::string& name);
+
+// 报告文件扩展名（含点）
+const char* reportExtension(ReportFormat format);
+
+// 是否为JSON报告的二进制编码
+bool isBinaryReportFormat(ReportFormat format);
+
+// 从报告文件读回的成分报告
+struct LoadedReport {
+    std::string report_date;
+    std::vector<Component> components;  // 仅含报告字段（代码、名称、行业、权重、市值、分红）
+};
+
+// 多基金XBRL申报中的一只基金
+struct XbrlFund {
+    std::string entity;             // 报告主体标识
+    ComponentSnapshot components;
+};
+
+// 报告生成器：不同文件可在多个线程并发生成（同一文件须串行）
 class ComplianceReporter {
 public:
-    // 生成监管报告
+    // 生成监管报告（写入报告目录下的当日JSON文件，返回文件名）
+    // 报告目录下的当日文件均按内容摘要跳过未变的写出，变化时经临时文件原子替换
     std::string generateReport(const std::vector<Component>& components);
     
-    // 生成XBRL格式报告
-    std::string generateXbrlReport(const std::vector<Component>& components);
+    // 流式写出JSON报告到指定文件（不构建DOM，结构与排版同nlohmann缩进4输出）
+    void writeReport(const std::vector<Component>& components, const std::string& filename,
+                     const std::string& reportDate);
+    
+    // 以二进制编码（CBOR/MessagePack/UBJSON/BSON）写出成分报告，解码后与JSON报告内容相同
+    void writeBinaryReport(const std::vector<Component>& components, ReportFormat format,
+                           const std::string& filename, const std::string& reportDate);
+    
+    // 以单一格式写出到指定文件（不经内容摘要缓存），返回写出字节数；writeReport、exportToCSV等均经此写出
+    // buffer非空时借用作为写出缓冲（批量生成时每个线程复用）
+    size_t writeFile(ReportFormat format, const std::vector<Component>& components,
+                     const std::string& filename, const std::string& reportDate,
+                     std::vector<char>* buffer = nullptr) const;
+    
+    // 读取JSON或二进制成分报告（按扩展名识别编码，失败抛出异常）；JSON中的null数值读回为NaN
+    static LoadedReport loadReport(const std::string& filename);
+    
+    // 流式写出XBRL实例到指定文件（reportDate为YYYY-MM-DD，以默认报告主体申报）
+    void writeXbrlReport(const std::vector<Component>& components, const std::string& filename,
+                         const std::string& reportDate);
+    
+    // 多基金XBRL申报：每只基金一个报告主体，逐成分写出上下文与事实，内存占用与基金数、成分数无关
+    void writeXbrlReport(const std::vector<XbrlFund>& funds, const std::string& filename,
+                         const std::string& reportDate);
     
-    // 导出到CSV
+    // 按格式生成当日报告文件，返回文件名
+    std::string generate(ReportFormat format, const std::vector<Component>& components);
+    
+    // 单遍生成多种格式的当日报告：只遍历一次成分，共享字段格式化一次，各格式并行写出
+    // 返回各格式的文件名（重复格式只写一次）；某一格式失败时其余照常写完，随后抛出异常
+    std::vector<std::string> generate(const std::vector<ReportFormat>& formats,
+                                      const std::vector<Component>& components);
+    
+    // 导出到CSV（RFC 4180引号规则，数值为最短往返表示）
     void exportToCSV(const std::vector<Component>& components, 
                      const std::string& filename);
     
+    // 导出指数历史（每期每个样本一行，列同IndexHistory::saveToCSV）
+    void exportToCSV(const IndexHistory& history, const std::string& filename);
+    
+    // 导出全市场排名（ranks由IndexCalculator::rankUniverse(universe)得到）
+    void exportToCSV(const REITList& universe, const std::vector<UniverseRank>& ranks,
+                     const std::string& filename);
+    
+    // 报告写出统计（写出/跳过次数、fsync次数与字节数）
+    ReportWriteStats writeStats() const { return m_files.stats(); }
+    
+    // 报告目录下date（YYYYMMDD）当日format报告的文件名
+    std::string reportFilename(int date, ReportFormat format) const;
+    
+    // date当日format报告内的日期字段：JSON及其二进制编码沿用当日报告文件名，XBRL为YYYY-MM-DD
+    // 当日生成与批量生成（BulkReporter）共用，同日同成分的报告逐字节相同
+    std::string reportDate(int date, ReportFormat format) const;
+    
     // 设置报告路径
     void setReportPath(const std::string& path) {
         m_reportPath = path;
     }
+    
+    // XBRL实例引用的分类标准（相对报告文件或绝对URL）
+    void setXbrlSchemaRef(const std::string& href) {
+        m_xbrlSchemaRef = href;
+    }
 
 private:
+    // 写出指定格式到file的流水线格式端（reportDate：JSON及二进制编码的报告日期字段、XBRL时点）
+    std::unique_ptr<ReportFormatSink> makeSink(ReportFormat format, std::unique_ptr<FileSink> file,
+                                               const std::string& reportDate) const;
+    
+    
+    // 写出一只基金的上下文与事实（fund为基金序号，用于生成上下文ID）
+    void writeXbrlFund(XbrlWriter& writer, size_t fund, const std::string& entity,
+                       const std::vector<Component>& components, const std::string& reportDate);
+    
     std::string m_reportPath = "./reports/";
+    std::string m_xbrlSchemaRef = "../config/xbrl/reits-index.xsd";
+    ReportFileCache m_files;
 };
\ No newline at end of file
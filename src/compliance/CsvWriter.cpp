@@ -0,0 +1,57 @@
+﻿#include "CsvWriter.hpp"
+#include "compliance/DecimalText.hpp"
+#include <array>
+#include <cmath>
+
+namespace {
+    // 出现即须整体加引号的字节
+    constexpr std::array<bool, 256> kNeedsQuote = [] {
+        std::array<bool, 256> table{};
+        table[','] = true;
+        table['"'] = true;
+        table['\n'] = true;
+        table['\r'] = true;
+        return table;
+    }();
+}
+
+void CsvWriter::writeQuoted(FileSink& sink, std::string_view text) {
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    const char* p = begin;
+    while (p < end && !kNeedsQuote[static_cast<unsigned char>(*p)]) {
+        ++p;
+    }
+    if (p == end) {
+        sink.write(text);
+        return;
+    }
+
+    sink.put('"');
+    const char* run = begin;
+    for (p = begin; p < end; ++p) {
+        if (*p == '"') {
+            // 连同引号写出，下一段从同一引号开始，即引号加倍
+            sink.write(run, static_cast<size_t>(p - run + 1));
+            run = p;
+        }
+    }
+    sink.write(run, static_cast<size_t>(end - run));
+    sink.put('"');
+}
+
+void CsvWriter::field(double number) {
+    separator();
+    if (!std::isfinite(number)) {
+        return;
+    }
+    char* buf = m_sink.reserve(kNumberBuffer);
+    m_sink.commit(static_cast<size_t>(std::to_chars(buf, buf + kNumberBuffer, number).ptr - buf));
+}
+
+void CsvWriter::field(const DecimalText& number) {
+    separator();
+    // 最短排版不长于科学计数法，不超过kNumberBuffer
+    char* buf = m_sink.reserve(kNumberBuffer);
+    m_sink.commit(static_cast<size_t>(number.shortest(buf) - buf));
+}
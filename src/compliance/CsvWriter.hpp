@@ -0,0 +1,63 @@
+#pragma once
+#include "compliance/FileSink.hpp"
+#include <charconv>
+#include <cstdint>
+#include <initializer_list>
+#include <string_view>
+#include <type_traits>
+
+struct DecimalText;
+
+// 流式CSV写出：直接写入FileSink，字段按RFC 4180加引号（含逗号、引号或换行时整体加引号，内部引号加倍）
+// 浮点数取 to_chars 的最短往返表示，与区域设置无关；非有限值写为空字段
+// 行尾为LF，与仓库内各CSV读取方一致
+class CsvWriter {
+public:
+    explicit CsvWriter(FileSink& sink) : m_sink(sink) {}
+
+    void field(std::string_view text) {
+        separator();
+        writeQuoted(m_sink, text);
+    }
+    void field(const char* text) { field(std::string_view(text)); }
+    void field(double number);
+    void field(const DecimalText& number);     // 已分解的数值，排版同 field(double)
+
+    template <typename T>
+        requires(std::is_integral_v<T> && !std::is_same_v<T, bool>)
+    void field(T number) {
+        separator();
+        char* buf = m_sink.reserve(kNumberBuffer);
+        m_sink.commit(static_cast<size_t>(std::to_chars(buf, buf + kNumberBuffer, number).ptr - buf));
+    }
+
+    // 结束当前行
+    void endRow() {
+        m_sink.put('\n');
+        m_rowStart = true;
+    }
+
+    // 整行写出（用于标题行）
+    void row(std::initializer_list<std::string_view> fields) {
+        for (std::string_view f : fields) {
+            field(f);
+        }
+        endRow();
+    }
+
+    // 按需加引号写出字段内容：无需引号时整段复制
+    static void writeQuoted(FileSink& sink, std::string_view text);
+
+private:
+    static constexpr size_t kNumberBuffer = 32;
+
+    void separator() {
+        if (!m_rowStart) {
+            m_sink.put(',');
+        }
+        m_rowStart = false;
+    }
+
+    FileSink& m_sink;
+    bool m_rowStart = true;
+};
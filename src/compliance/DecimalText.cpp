@@ -0,0 +1,147 @@
+﻿#include "DecimalText.hpp"
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    // 不小于2^53的数值为整数且相邻浮点间距大于1，to_chars定点排版写出精确整数而非补零的最短有效数字
+    constexpr double kExactIntegerLimit = 9007199254740992.0;
+
+    // 写出两位或三位指数（与 printf("%g") 一致至少两位）
+    char* appendExponent(char* buf, int e) {
+        *buf++ = e < 0 ? '-' : '+';
+        unsigned k = static_cast<unsigned>(e < 0 ? -e : e);
+        if (k < 10) {
+            *buf++ = '0';
+            *buf++ = static_cast<char>('0' + k);
+        } else if (k < 100) {
+            *buf++ = static_cast<char>('0' + k / 10);
+            *buf++ = static_cast<char>('0' + k % 10);
+        } else {
+            *buf++ = static_cast<char>('0' + k / 100);
+            *buf++ = static_cast<char>('0' + k / 10 % 10);
+            *buf++ = static_cast<char>('0' + k % 10);
+        }
+        return buf;
+    }
+
+    // d.igitse±XX
+    char* writeScientific(char* buf, const char* digits, int k, int n) {
+        *buf++ = digits[0];
+        if (k > 1) {
+            *buf++ = '.';
+            std::memcpy(buf, digits + 1, k - 1);
+            buf += k - 1;
+        }
+        *buf++ = 'e';
+        return appendExponent(buf, n - 1);
+    }
+
+    // 定点：digits[000]、dig.its 或 0.[000]digits
+    char* writeFixed(char* buf, const char* digits, int k, int n) {
+        if (k <= n) {
+            std::memcpy(buf, digits, k);
+            std::memset(buf + k, '0', n - k);
+            return buf + n;
+        }
+        if (n > 0) {
+            std::memcpy(buf, digits, n);
+            buf[n] = '.';
+            std::memcpy(buf + n + 1, digits + n, k - n);
+            return buf + k + 1;
+        }
+        *buf++ = '0';
+        *buf++ = '.';
+        std::memset(buf, '0', -n);
+        buf += -n;
+        std::memcpy(buf, digits, k);
+        return buf + k;
+    }
+}
+
+DecimalText::DecimalText(double number) : value(number) {
+    if (!std::isfinite(number)) {
+        return;
+    }
+
+    // 最短往返的科学计数法给出有效数字与十进制指数
+    char sci[32];
+    char* sciEnd = std::to_chars(sci, sci + sizeof(sci), number, std::chars_format::scientific).ptr;
+    const char* p = sci;
+    if (*p == '-') {
+        negative = true;
+        ++p;
+    }
+    for (; p < sciEnd && *p != 'e'; ++p) {
+        if (*p != '.') {
+            digits[count++] = *p;
+        }
+    }
+    int exponent = 0;
+    const char* e = p + 1;
+    if (e < sciEnd && *e == '+') {
+        ++e;
+    }
+    std::from_chars(e, sciEnd, exponent);
+    point = static_cast<int16_t>(exponent + 1);
+}
+
+char* DecimalText::json(char* buf) const {
+    if (!finite()) {
+        std::memcpy(buf, "null", 4);
+        return buf + 4;
+    }
+    if (negative) {
+        *buf++ = '-';
+    }
+
+    // 按nlohmann规则排版：小数点位置在(-4, 15]内用定点（整数补 .0），否则科学计数法
+    const int k = count;
+    const int n = point;
+    constexpr int kMinExp = -4;
+    constexpr int kMaxExp = 15;
+    if (kMinExp < n && n <= kMaxExp) {
+        buf = writeFixed(buf, digits, k, n);
+        if (k <= n) {
+            *buf++ = '.';
+            *buf++ = '0';
+        }
+        return buf;
+    }
+    return writeScientific(buf, digits, k, n);
+}
+
+char* DecimalText::shortest(char* buf) const {
+    if (!finite()) {
+        return buf;
+    }
+    if (std::fabs(value) >= kExactIntegerLimit) {
+        return std::to_chars(buf, buf + kBuffer, value).ptr;
+    }
+    if (negative) {
+        *buf++ = '-';
+    }
+
+    const int k = count;
+    const int n = point;
+    int fixedLength = k <= n ? n : (n > 0 ? k + 1 : 2 - n + k);
+    int e = n - 1 < 0 ? 1 - n : n - 1;
+    int sciLength = k + (k > 1) + 2 + (e < 100 ? 2 : 3);
+    if (fixedLength <= sciLength) {
+        return writeFixed(buf, digits, k, n);
+    }
+    return writeScientific(buf, digits, k, n);
+}
+
+char* DecimalText::fixed(char* buf) const {
+    if (!finite()) {
+        return buf;
+    }
+    if (std::fabs(value) >= kExactIntegerLimit) {
+        return std::to_chars(buf, buf + kBuffer, value, std::chars_format::fixed).ptr;
+    }
+    if (negative) {
+        *buf++ = '-';
+    }
+    return writeFixed(buf, digits, count, point);
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// 浮点数的最短往返十进制分解：一次to_chars得到有效数字与小数点位置，再按各报告格式排版
+// 同一数值在JSON、CSV、XBRL中的文本由同一组有效数字生成，多格式报告只做一次浮点到十进制的转换
+struct DecimalText {
+    static constexpr size_t kMaxDigits = 17;
+    static constexpr size_t kBuffer = 352;      // 任一排版的最大长度（定点表示的次正规数）
+
+    double value = 0.0;
+    char digits[kMaxDigits] = {};
+    uint8_t count = 0;          // 有效数字位数（非有限值为0）
+    bool negative = false;
+    int16_t point = 0;          // 小数点位置：|数值| = 0.d1d2...dk × 10^point
+
+    DecimalText() = default;
+    explicit DecimalText(double number);
+
+    bool finite() const { return count > 0; }
+
+    // 以下排版写入buf并返回写入末尾，buf至少kBuffer字节
+    // nlohmann::json::dump 排版（非有限值为null）
+    char* json(char* buf) const;
+
+    // std::to_chars 默认排版：定点与科学计数法取较短者（等长取定点），非有限值为空
+    char* shortest(char* buf) const;
+
+    // std::to_chars 定点排版，非有限值为空
+    char* fixed(char* buf) const;
+};
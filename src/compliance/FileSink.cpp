@@ -0,0 +1,190 @@
+﻿#include "FileSink.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace {
+    // 最小缓冲：须容纳单个数值的直接格式化
+    constexpr size_t kMinBuffer = 64;
+}
+
+bool ReportFileCache::unchanged(const std::string& filename, uint64_t hash, uint64_t size) {
+    std::lock_guard lock(m_mutex);
+    auto it = m_digests.find(filename);
+    if (it == m_digests.end()) {
+        // 进程重启后首次写出：以磁盘现有内容为基准
+        Digest digest;
+        if (std::FILE* file = std::fopen(filename.c_str(), "rb")) {
+            XxHash64 hasher;
+            char chunk[1 << 16];
+            size_t n;
+            while ((n = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+                hasher.update(chunk, n);
+                digest.size += n;
+            }
+            digest.exists = !std::ferror(file);
+            digest.hash = hasher.digest();
+            std::fclose(file);
+        }
+        it = m_digests.emplace(filename, digest).first;
+    }
+    return it->second.exists && it->second.hash == hash && it->second.size == size;
+}
+
+void ReportFileCache::recordWrite(const std::string& filename, uint64_t hash, uint64_t size) {
+    std::lock_guard lock(m_mutex);
+    m_digests[filename] = {hash, size, true};
+    ++m_stats.written;
+    ++m_stats.fsyncs;
+    m_stats.bytes_written += size;
+}
+
+void ReportFileCache::recordSkip(uint64_t size) {
+    std::lock_guard lock(m_mutex);
+    ++m_stats.skipped;
+    m_stats.bytes_skipped += size;
+}
+
+ReportWriteStats ReportFileCache::stats() const {
+    std::lock_guard lock(m_mutex);
+    return m_stats;
+}
+
+FileSink::FileSink(const std::string& filename, size_t bufferSize)
+    : m_filename(filename), m_path(filename), m_ownBuffer(std::max(bufferSize, kMinBuffer)),
+      m_buffer(m_ownBuffer) {
+    openFile();
+}
+
+FileSink::FileSink(const std::string& filename, ReportFileCache& cache, size_t bufferSize)
+    : m_filename(filename), m_path(filename + ".tmp"), m_cache(&cache),
+      m_ownBuffer(std::max(bufferSize, kMinBuffer)), m_buffer(m_ownBuffer) {}
+
+FileSink::FileSink(const std::string& filename, std::vector<char>& buffer)
+    : m_filename(filename), m_path(filename), m_buffer(buffer) {
+    if (m_buffer.size() < kMinBuffer) {
+        m_buffer.resize(kMinBuffer);
+    }
+    openFile();
+}
+
+FileSink::~FileSink() {
+    if (m_closed) {
+        return;
+    }
+    if (m_cache) {
+        discard();
+        return;
+    }
+    try {
+        close();
+    } catch (...) {
+    }
+}
+
+void FileSink::openFile() {
+    m_file = std::fopen(m_path.c_str(), "wb");
+    if (!m_file) {
+        throw std::runtime_error("无法打开报告文件: " + m_path);
+    }
+    m_created = true;
+    // 自有缓冲已足够大，关闭C库缓冲避免二次复制
+    std::setvbuf(m_file, nullptr, _IONBF, 0);
+}
+
+void FileSink::discard() {
+    if (m_file) {
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+    if (m_cache && m_created) {
+        std::error_code ec;
+        fs::remove(m_path, ec);
+    }
+    m_closed = true;
+}
+
+void FileSink::writeFile(const char* data, size_t size) {
+    if (!m_file) {
+        openFile();
+    }
+    if (std::fwrite(data, 1, size, m_file) != size) {
+        throw std::runtime_error("写入报告文件失败: " + m_path);
+    }
+}
+
+void FileSink::writeSlow(const char* data, size_t size) {
+    flush();
+    // 超过缓冲区的大块直接写出
+    if (size >= m_buffer.size()) {
+        if (m_cache) {
+            m_hash.update(data, size);
+        }
+        writeFile(data, size);
+        m_written += size;
+        return;
+    }
+    std::char_traits<char>::copy(m_buffer.data(), data, size);
+    m_used = size;
+}
+
+void FileSink::flush() {
+    if (m_used == 0) {
+        return;
+    }
+    if (m_cache) {
+        m_hash.update(m_buffer.data(), m_used);
+    }
+    writeFile(m_buffer.data(), m_used);
+    m_written += m_used;
+    m_used = 0;
+}
+
+bool FileSink::close() {
+    if (m_closed) {
+        return false;
+    }
+    if (!m_cache) {
+        flush();
+        m_closed = true;
+        int rc = std::fclose(m_file);
+        m_file = nullptr;
+        if (rc != 0) {
+            throw std::runtime_error("关闭报告文件失败: " + m_filename);
+        }
+        return true;
+    }
+
+    // 缓冲剩余部分先计入摘要，内容未变时不再写出
+    m_hash.update(m_buffer.data(), m_used);
+    const uint64_t hash = m_hash.digest();
+    const uint64_t size = bytesWritten();
+    if (m_cache->unchanged(m_filename, hash, size)) {
+        discard();
+        m_cache->recordSkip(size);
+        return false;
+    }
+
+    try {
+        writeFile(m_buffer.data(), m_used);
+        m_written += m_used;
+        m_used = 0;
+        if (!syncFile(m_file)) {
+            throw std::runtime_error("同步报告文件失败: " + m_path);
+        }
+        int rc = std::fclose(m_file);
+        m_file = nullptr;
+        if (rc != 0) {
+            throw std::runtime_error("关闭报告文件失败: " + m_path);
+        }
+        replaceFile(m_path, m_filename);
+    } catch (...) {
+        discard();
+        throw;
+    }
+    m_closed = true;
+    m_cache->recordWrite(m_filename, hash, size);
+    return true;
+}
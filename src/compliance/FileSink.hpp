@@ -0,0 +1,116 @@
+#pragma once
+#include "core/FileSync.hpp"
+#include "core/XxHash64.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// 报告写出统计（进程内累计）
+struct ReportWriteStats {
+    uint64_t written = 0;           // 内容变化而替换目标文件的次数
+    uint64_t skipped = 0;           // 内容未变而跳过的次数
+    uint64_t fsyncs = 0;
+    uint64_t bytes_written = 0;
+    uint64_t bytes_skipped = 0;
+};
+
+// 各目标文件最近一次落盘内容的摘要（XXH64 + 长度），可被多个写出线程共享
+class ReportFileCache {
+public:
+    // 内容是否与目标文件现有内容相同；首次遇到的文件从磁盘读取计算摘要
+    bool unchanged(const std::string& filename, uint64_t hash, uint64_t size);
+
+    void recordWrite(const std::string& filename, uint64_t hash, uint64_t size);
+    void recordSkip(uint64_t size);
+
+    ReportWriteStats stats() const;
+
+private:
+    struct Digest {
+        uint64_t hash = 0;
+        uint64_t size = 0;
+        bool exists = false;
+    };
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, Digest> m_digests;
+    ReportWriteStats m_stats;
+};
+
+// 大块缓冲的文件输出：写入先进入用户态缓冲，满后整块写入，避免逐字段的流开销
+// 指定ReportFileCache时为原子替换模式：边写边计算内容摘要，写入同目录临时文件，
+// close()时内容与目标相同则丢弃临时文件，否则fsync后重命名覆盖目标；
+// 内容小于缓冲区时未变的报告不产生任何磁盘写入，中途崩溃不会留下残缺的目标文件
+class FileSink {
+public:
+    explicit FileSink(const std::string& filename, size_t bufferSize = 1 << 20);
+    FileSink(const std::string& filename, ReportFileCache& cache, size_t bufferSize = 1 << 20);
+    
+    // 借用调用方的缓冲（直接模式，缓冲生命周期须覆盖本对象）：批量写出时每个线程复用同一缓冲，免去逐文件分配
+    FileSink(const std::string& filename, std::vector<char>& buffer);
+    ~FileSink();
+
+    FileSink(const FileSink&) = delete;
+    FileSink& operator=(const FileSink&) = delete;
+
+    void write(const char* data, size_t size) {
+        if (size > m_buffer.size() - m_used) {
+            writeSlow(data, size);
+            return;
+        }
+        std::char_traits<char>::copy(m_buffer.data() + m_used, data, size);
+        m_used += size;
+    }
+    void write(std::string_view text) { write(text.data(), text.size()); }
+
+    void put(char c) {
+        if (m_used == m_buffer.size()) {
+            flush();
+        }
+        m_buffer[m_used++] = c;
+    }
+
+    // 预留至少n字节的连续空间供直接格式化（n不超过64），写入后以commit提交
+    char* reserve(size_t n) {
+        if (n > m_buffer.size() - m_used) {
+            flush();
+        }
+        return m_buffer.data() + m_used;
+    }
+    void commit(size_t n) { m_used += n; }
+
+    // 写出缓冲内容（失败抛出异常）
+    void flush();
+
+    // 写出剩余内容并关闭文件（失败抛出异常），返回是否实际写入目标文件（内容未变而跳过时为false）
+    // 析构时未关闭：直接模式尽力写出，原子替换模式丢弃临时文件
+    bool close();
+
+    size_t bytesWritten() const { return m_written + m_used; }
+    const std::string& filename() const { return m_filename; }
+
+private:
+    void writeSlow(const char* data, size_t size);
+
+    // 写入底层文件（原子替换模式下首次写入时创建临时文件）
+    void writeFile(const char* data, size_t size);
+    void openFile();
+    void discard();
+
+    std::string m_filename;
+    std::string m_path;             // 实际写入路径（原子替换模式为临时文件）
+    std::FILE* m_file = nullptr;
+    ReportFileCache* m_cache = nullptr;
+    XxHash64 m_hash;
+    std::vector<char> m_ownBuffer;
+    std::vector<char>& m_buffer;    // 自有或借用的缓冲
+    size_t m_used = 0;
+    size_t m_written = 0;
+    bool m_created = false;
+    bool m_closed = false;
+};
@@ -0,0 +1,156 @@
+﻿#include "JsonWriter.hpp"
+#include "compliance/DecimalText.hpp"
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    // 需要转义的字节：控制字符、引号与反斜杠（UTF-8多字节原样输出）
+    constexpr std::array<bool, 256> kNeedsEscape = [] {
+        std::array<bool, 256> table{};
+        for (int c = 0; c < 0x20; ++c) {
+            table[c] = true;
+        }
+        table['"'] = true;
+        table['\\'] = true;
+        return table;
+    }();
+
+    constexpr size_t kNumberBuffer = 32;
+}
+
+void JsonWriter::writeEscaped(FileSink& sink, std::string_view text) {
+    const char* run = text.data();
+    const char* end = run + text.size();
+    for (const char* p = run; p < end; ++p) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (!kNeedsEscape[c]) {
+            continue;
+        }
+        sink.write(run, static_cast<size_t>(p - run));
+        run = p + 1;
+
+        char escaped[6] = {'\\', 0, 0, 0, 0, 0};
+        size_t len = 2;
+        switch (c) {
+        case '"': escaped[1] = '"'; break;
+        case '\\': escaped[1] = '\\'; break;
+        case '\b': escaped[1] = 'b'; break;
+        case '\f': escaped[1] = 'f'; break;
+        case '\n': escaped[1] = 'n'; break;
+        case '\r': escaped[1] = 'r'; break;
+        case '\t': escaped[1] = 't'; break;
+        default:
+            escaped[1] = 'u';
+            escaped[2] = '0';
+            escaped[3] = '0';
+            escaped[4] = "0123456789abcdef"[c >> 4];
+            escaped[5] = "0123456789abcdef"[c & 0xF];
+            len = 6;
+            break;
+        }
+        sink.write(escaped, len);
+    }
+    sink.write(run, static_cast<size_t>(end - run));
+}
+
+char* JsonWriter::formatDouble(char* buf, double number) {
+    return DecimalText(number).json(buf);
+}
+
+void JsonWriter::newline(size_t depth) {
+    if (m_indent < 0) {
+        return;
+    }
+    m_sink.put('\n');
+    for (size_t i = 0; i < depth * static_cast<size_t>(m_indent); ++i) {
+        m_sink.put(' ');
+    }
+}
+
+void JsonWriter::prefix() {
+    if (m_afterKey) {
+        m_afterKey = false;
+        return;
+    }
+    if (m_depth == 0) {
+        return;
+    }
+    if (!m_empty[m_depth - 1]) {
+        m_sink.put(',');
+    }
+    m_empty[m_depth - 1] = false;
+    newline(m_depth);
+}
+
+void JsonWriter::open(char bracket) {
+    prefix();
+    if (m_depth == kMaxDepth) {
+        throw std::runtime_error("JSON嵌套层数超出上限");
+    }
+    m_sink.put(bracket);
+    m_empty[m_depth++] = true;
+}
+
+void JsonWriter::close(char bracket) {
+    --m_depth;
+    if (!m_empty[m_depth]) {
+        newline(m_depth);
+    }
+    m_sink.put(bracket);
+}
+
+void JsonWriter::key(std::string_view name) {
+    prefix();
+    m_sink.put('"');
+    writeEscaped(m_sink, name);
+    if (m_indent < 0) {
+        m_sink.write("\":", 2);
+    } else {
+        m_sink.write("\": ", 3);
+    }
+    m_afterKey = true;
+}
+
+void JsonWriter::value(std::string_view text) {
+    prefix();
+    m_sink.put('"');
+    writeEscaped(m_sink, text);
+    m_sink.put('"');
+}
+
+void JsonWriter::value(double number) {
+    prefix();
+    char* buf = m_sink.reserve(kNumberBuffer);
+    m_sink.commit(static_cast<size_t>(formatDouble(buf, number) - buf));
+}
+
+void JsonWriter::value(const DecimalText& number) {
+    prefix();
+    char* buf = m_sink.reserve(kNumberBuffer);
+    m_sink.commit(static_cast<size_t>(number.json(buf) - buf));
+}
+
+void JsonWriter::value(bool flag) {
+    prefix();
+    m_sink.write(flag ? std::string_view("true") : std::string_view("false"));
+}
+
+void JsonWriter::null() {
+    prefix();
+    m_sink.write("null", 4);
+}
+
+void JsonWriter::writeInteger(int64_t number) {
+    prefix();
+    char* buf = m_sink.reserve(kNumberBuffer);
+    m_sink.commit(static_cast<size_t>(std::to_chars(buf, buf + kNumberBuffer, number).ptr - buf));
+}
+
+void JsonWriter::writeInteger(uint64_t number) {
+    prefix();
+    char* buf = m_sink.reserve(kNumberBuffer);
+    m_sink.commit(static_cast<size_t>(std::to_chars(buf, buf + kNumberBuffer, number).ptr - buf));
+}
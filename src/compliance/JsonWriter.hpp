@@ -0,0 +1,71 @@
+#pragma once
+#include "compliance/FileSink.hpp"
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+struct DecimalText;
+
+// 流式JSON写出：直接写入FileSink，不构建DOM
+// 排版与 nlohmann::json::dump(indent) 一致，键顺序由调用方决定
+// 浮点数取 to_chars 的最短往返有效数字，个别值与nlohmann(grisu2)末位写法不同但解析后相等
+class JsonWriter {
+public:
+    // indent < 0 为紧凑格式
+    explicit JsonWriter(FileSink& sink, int indent = 4) : m_sink(sink), m_indent(indent) {}
+
+    void beginObject() { open('{'); }
+    void endObject() { close('}'); }
+    void beginArray() { open('['); }
+    void endArray() { close(']'); }
+
+    // 对象键（其后须紧跟一个值或容器）
+    void key(std::string_view name);
+
+    void value(std::string_view text);
+    void value(const char* text) { value(std::string_view(text)); }
+    void value(double number);
+    void value(const DecimalText& number);     // 已分解的数值，排版同 value(double)
+    void value(bool flag);
+    void null();
+
+    template <typename T>
+        requires(std::is_integral_v<T> && !std::is_same_v<T, bool>)
+    void value(T number) {
+        if constexpr (std::is_signed_v<T>) {
+            writeInteger(static_cast<int64_t>(number));
+        } else {
+            writeInteger(static_cast<uint64_t>(number));
+        }
+    }
+
+    // 键值对简写
+    template <typename T>
+    void field(std::string_view name, const T& v) {
+        key(name);
+        value(v);
+    }
+
+    // 写出转义后的字符串内容（不含引号）：无需转义的连续片段整段复制
+    static void writeEscaped(FileSink& sink, std::string_view text);
+
+    // 按nlohmann格式写出浮点数，返回写入末尾（buf至少32字节）
+    static char* formatDouble(char* buf, double number);
+
+private:
+    static constexpr size_t kMaxDepth = 64;
+
+    // 值之前的分隔与缩进
+    void prefix();
+    void newline(size_t depth);
+    void open(char bracket);
+    void close(char bracket);
+    void writeInteger(int64_t number);
+    void writeInteger(uint64_t number);
+
+    FileSink& m_sink;
+    int m_indent;
+    size_t m_depth = 0;
+    bool m_afterKey = false;
+    bool m_empty[kMaxDepth] = {};   // 各层是否尚无元素
+};
@@ -0,0 +1,150 @@
+﻿#include "ReportPipeline.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+ReportPipeline::ReportPipeline(size_t batchRows, size_t batchSlots)
+    : m_batchRows(std::max<size_t>(batchRows, 1)), m_batchSlots(std::max<size_t>(batchSlots, 1)) {}
+
+void ReportPipeline::addSink(std::unique_ptr<ReportFormatSink> sink) {
+    m_sinks.push_back(std::move(sink));
+}
+
+void ReportPipeline::fill(ReportRowBatch& batch, const std::vector<Component>& components,
+                          size_t first, size_t rows) {
+    batch.first = first;
+    batch.rows.resize(rows);
+    for (size_t j = 0; j < rows; ++j) {
+        const Component& comp = components[first + j];
+        ReportRow& row = batch.rows[j];
+        row.component = &comp;
+        row.weight = DecimalText(comp.weight);
+        row.market_cap = DecimalText(comp.reit.market_cap);
+        row.dividend = DecimalText(comp.reit.dividend_amt);
+        row.occupancy = DecimalText(comp.reit.occupancy_rate);
+    }
+}
+
+void ReportPipeline::run(const std::vector<Component>& components) {
+    if (m_sinks.empty()) {
+        return;
+    }
+    const size_t count = components.size();
+    const size_t batchCount = (count + m_batchRows - 1) / m_batchRows;
+    auto batchRows = [&](size_t b) { return std::min(m_batchRows, count - b * m_batchRows); };
+
+    if (m_sinks.size() == 1) {
+        ReportFormatSink& sink = *m_sinks.front();
+        try {
+            ReportRowBatch batch;
+            sink.begin(count);
+            for (size_t b = 0; b < batchCount; ++b) {
+                fill(batch, components, b * m_batchRows, batchRows(b));
+                sink.write(batch);
+            }
+            sink.end();
+        } catch (const std::exception& e) {
+            throw std::runtime_error(std::string(sink.name()) + ": " + e.what());
+        }
+        return;
+    }
+
+    // 第b批写入槽位 b % slots；生产第b批前须全部格式端都已写完第 b - slots 批
+    std::vector<ReportRowBatch> slots(std::min(m_batchSlots, std::max<size_t>(batchCount, 1)));
+    std::mutex mutex;
+    std::condition_variable producedCv;
+    std::condition_variable consumedCv;
+    size_t produced = 0;
+    bool closed = false;            // 生产结束（或中途失败）后不再有新批次
+    std::vector<size_t> consumed(m_sinks.size(), 0);
+    std::vector<std::string> errors(m_sinks.size());
+
+    auto consume = [&](size_t i) {
+        ReportFormatSink& sink = *m_sinks[i];
+        try {
+            sink.begin(count);
+            for (size_t b = 0; b < batchCount; ++b) {
+                {
+                    std::unique_lock lock(mutex);
+                    producedCv.wait(lock, [&] { return produced > b || closed; });
+                    if (produced <= b) {
+                        // 生产中途失败：不写结尾，残缺文件由格式端的文件析构处理
+                        return;
+                    }
+                }
+                sink.write(slots[b % slots.size()]);
+                {
+                    std::lock_guard lock(mutex);
+                    consumed[i] = b + 1;
+                }
+                consumedCv.notify_one();
+            }
+            sink.end();
+        } catch (const std::exception& e) {
+            // 失败的格式端不再阻塞生产，其余格式照常写完
+            {
+                std::lock_guard lock(mutex);
+                errors[i] = std::string(sink.name()) + ": " + e.what();
+                consumed[i] = batchCount;
+            }
+            consumedCv.notify_one();
+        }
+    };
+
+    // 无论正常结束还是启动线程、填充批次时抛出异常，离开作用域前都关闭流水线、唤醒并等待全部格式端线程，
+    // 否则仍可join的std::thread析构时调用std::terminate；异常在等待结束后照常向上传播
+    struct ConsumerJoin {
+        std::vector<std::thread> threads;
+        std::mutex& mutex;
+        bool& closed;
+        std::condition_variable& producedCv;
+
+        ~ConsumerJoin() {
+            {
+                std::lock_guard lock(mutex);
+                closed = true;
+            }
+            producedCv.notify_all();
+            for (auto& t : threads) {
+                if (t.joinable()) {
+                    t.join();
+                }
+            }
+        }
+    };
+
+    {
+        ConsumerJoin consumers{{}, mutex, closed, producedCv};
+        consumers.threads.reserve(m_sinks.size());
+        for (size_t i = 0; i < m_sinks.size(); ++i) {
+            consumers.threads.emplace_back(consume, i);
+        }
+
+        for (size_t b = 0; b < batchCount; ++b) {
+            {
+                std::unique_lock lock(mutex);
+                consumedCv.wait(lock, [&] {
+                    return *std::min_element(consumed.begin(), consumed.end()) + slots.size() > b;
+                });
+            }
+            fill(slots[b % slots.size()], components, b * m_batchRows, batchRows(b));
+            {
+                std::lock_guard lock(mutex);
+                produced = b + 1;
+            }
+            producedCv.notify_all();
+        }
+    }
+
+    std::string message;
+    for (const auto& error : errors) {
+        if (!error.empty()) {
+            message += message.empty() ? error : "; " + error;
+        }
+    }
+    if (!message.empty()) {
+        throw std::runtime_error(message);
+    }
+}
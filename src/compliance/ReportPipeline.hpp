@@ -0,0 +1,59 @@
+#pragma once
+#include "compliance/DecimalText.hpp"
+#include "core/IndexCalculator.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+// 成分在流水线中的共享字段：字符串引用原成分，数值预先分解为最短十进制
+struct ReportRow {
+    const Component* component = nullptr;
+    DecimalText weight;
+    DecimalText market_cap;
+    DecimalText dividend;
+    DecimalText occupancy;
+};
+
+// 一批连续成分行
+struct ReportRowBatch {
+    size_t first = 0;               // 首行在成分列表中的序号
+    std::vector<ReportRow> rows;
+};
+
+// 报告格式端：流水线按顺序交付全部批次，各格式端在各自线程中写出
+class ReportFormatSink {
+public:
+    virtual ~ReportFormatSink() = default;
+
+    // 格式名称（用于错误信息）
+    virtual const char* name() const = 0;
+
+    virtual void begin(size_t componentCount) = 0;
+    virtual void write(const ReportRowBatch& batch) = 0;
+
+    // 写出结尾并关闭文件（失败抛出异常）
+    virtual void end() = 0;
+};
+
+// 单遍多格式报告流水线：调用线程只遍历一次成分，将共享字段格式化到复用的批次缓冲，
+// 各格式端在各自线程中并行消费同一批次；批次槽位在全部格式端写完后才被覆盖，内存占用与成分数无关
+// 总耗时接近最慢的单一格式，而非各格式之和；只有一个格式端时在调用线程内直接写出
+class ReportPipeline {
+public:
+    explicit ReportPipeline(size_t batchRows = 4096, size_t batchSlots = 4);
+
+    void addSink(std::unique_ptr<ReportFormatSink> sink);
+    size_t sinkCount() const { return m_sinks.size(); }
+
+    // 写出全部格式；某一格式失败不影响其余格式，结束后抛出汇总各失败格式的异常
+    void run(const std::vector<Component>& components);
+
+private:
+    // 以 components[first, first + rows) 填充批次
+    static void fill(ReportRowBatch& batch, const std::vector<Component>& components,
+                     size_t first, size_t rows);
+
+    size_t m_batchRows;
+    size_t m_batchSlots;
+    std::vector<std::unique_ptr<ReportFormatSink>> m_sinks;
+};
@@ -0,0 +1,209 @@
+﻿#include "ReportQueue.hpp"
+#include "risk/CircuitBreaker.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+ReportQueueSettings ReportQueueSettings::fromRules(const json& rules) {
+    ReportQueueSettings settings;
+    json cfg = rules.value("reporting", json::object());
+
+    settings.capacity = std::max<size_t>(cfg.value("queue_capacity", settings.capacity), 1);
+    settings.writers = std::max<size_t>(cfg.value("writers", settings.writers), 1);
+
+    std::string policy = cfg.value("backpressure", std::string("coalesce"));
+    if (policy == "coalesce") {
+        settings.policy = BackpressurePolicy::CoalesceLatest;
+    } else if (policy == "block") {
+        settings.policy = BackpressurePolicy::Block;
+    } else {
+        throw std::runtime_error("未知报告队列策略: " + policy);
+    }
+
+    if (cfg.contains("formats")) {
+        settings.formats.clear();
+        for (const auto& name : cfg["formats"]) {
+            settings.formats.push_back(parseReportFormat(name.get<std::string>()));
+        }
+    }
+    settings.pipeline = cfg.value("pipeline", settings.pipeline);
+    return settings;
+}
+
+ReportQueue::ReportQueue(ComplianceReporter& reporter, ReportQueueSettings settings,
+                         const CircuitBreaker* breaker)
+    : m_reporter(reporter), m_settings(std::move(settings)), m_breaker(breaker) {
+    // 每种格式至少可有一个待写任务，合并策略下各格式互不挤占（流水线模式下只需一个）
+    m_settings.capacity = std::max({m_settings.capacity, m_settings.formats.size(), size_t(1)});
+    m_writers.reserve(m_settings.writers);
+    for (size_t i = 0; i < m_settings.writers; ++i) {
+        m_writers.emplace_back(&ReportQueue::writerLoop, this);
+    }
+}
+
+ReportQueue::~ReportQueue() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_ready.notify_all();
+    m_space.notify_all();
+    for (auto& t : m_writers) {
+        if (t.joinable()) {
+            t.join();
+        }
+    }
+}
+
+bool ReportQueue::submit(ReportFormat format, ComponentSnapshot components) {
+    return submitJob(1u << static_cast<uint32_t>(format), std::move(components));
+}
+
+bool ReportQueue::submitJob(uint32_t formats, ComponentSnapshot components) {
+    if (!components) {
+        return false;
+    }
+    std::unique_lock lock(m_mutex);
+    ++m_metrics.submitted;
+    if (m_breaker && m_breaker->halted()) {
+        ++m_metrics.halted;
+        return false;
+    }
+    Clock::time_point now = Clock::now();
+
+    if (m_settings.policy == BackpressurePolicy::CoalesceLatest) {
+        // 只有最新快照的报告有意义：同格式待写任务直接换成新快照
+        for (auto& job : m_jobs) {
+            if (job.formats == formats) {
+                job.components = std::move(components);
+                job.submitted = now;
+                ++m_metrics.coalesced;
+                return true;
+            }
+        }
+        if (m_jobs.size() >= m_settings.capacity) {
+            m_jobs.pop_front();
+            ++m_metrics.dropped;
+        }
+    } else {
+        m_space.wait(lock, [&] { return m_stopping || m_jobs.size() < m_settings.capacity; });
+        if (m_stopping) {
+            ++m_metrics.dropped;
+            return false;
+        }
+    }
+
+    m_jobs.push_back({formats, std::move(components), now});
+    m_metrics.max_depth = std::max(m_metrics.max_depth, m_jobs.size());
+    lock.unlock();
+    m_ready.notify_one();
+    return true;
+}
+
+void ReportQueue::submit(ComponentSnapshot components) {
+    if (!m_settings.pipeline) {
+        for (ReportFormat format : m_settings.formats) {
+            submit(format, components);
+        }
+        return;
+    }
+    uint32_t formats = 0;
+    for (ReportFormat format : m_settings.formats) {
+        formats |= 1u << static_cast<uint32_t>(format);
+    }
+    if (formats != 0) {
+        submitJob(formats, std::move(components));
+    }
+}
+
+void ReportQueue::flush() {
+    std::unique_lock lock(m_mutex);
+    m_space.wait(lock, [&] { return m_jobs.empty() && m_metrics.in_flight == 0; });
+}
+
+ReportQueueMetrics ReportQueue::metrics() const {
+    std::lock_guard lock(m_mutex);
+    ReportQueueMetrics metrics = m_metrics;
+    metrics.depth = m_jobs.size();
+    return metrics;
+}
+
+bool ReportQueue::takeJob(Job& job) {
+    for (auto it = m_jobs.begin(); it != m_jobs.end(); ++it) {
+        if (m_busyFormats & it->formats) {
+            continue;
+        }
+        m_busyFormats |= it->formats;
+        ++m_metrics.in_flight;
+        job = std::move(*it);
+        m_jobs.erase(it);
+        return true;
+    }
+    return false;
+}
+
+void ReportQueue::writerLoop() {
+    std::unique_lock lock(m_mutex);
+    while (true) {
+        Job job;
+        m_ready.wait(lock, [&] { return (m_stopping && m_jobs.empty()) || takeJob(job); });
+        if (!job.components) {
+            return;
+        }
+        // 取出任务即腾出队列空位
+        m_space.notify_all();
+
+        // 熔断后不再写出触发前排队的报告
+        if (m_breaker && m_breaker->halted()) {
+            ++m_metrics.halted;
+            m_busyFormats &= ~job.formats;
+            --m_metrics.in_flight;
+            lock.unlock();
+            job.components.reset();
+            lock.lock();
+            m_ready.notify_all();
+            m_space.notify_all();
+            continue;
+        }
+        lock.unlock();
+
+        Clock::time_point started = Clock::now();
+        std::string error;
+        std::vector<ReportFormat> formats;
+        for (uint32_t f = 0; f < 32; ++f) {
+            if (job.formats & (1u << f)) {
+                formats.push_back(static_cast<ReportFormat>(f));
+            }
+        }
+        try {
+            // 异常信息已带格式名
+            m_reporter.generate(formats, *job.components);
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+        Clock::time_point finished = Clock::now();
+        // 快照引用在锁外释放
+        job.components.reset();
+
+        lock.lock();
+        double writeMs = std::chrono::duration<double, std::milli>(finished - started).count();
+        double latencyMs = std::chrono::duration<double, std::milli>(finished - job.submitted).count();
+        if (error.empty()) {
+            ++m_metrics.written;
+            m_metrics.mean_write_ms += (writeMs - m_metrics.mean_write_ms) / m_metrics.written;
+        } else {
+            ++m_metrics.failed;
+            m_metrics.last_error = std::move(error);
+        }
+        m_metrics.last_write_ms = writeMs;
+        m_metrics.max_write_ms = std::max(m_metrics.max_write_ms, writeMs);
+        m_metrics.last_latency_ms = latencyMs;
+        m_metrics.max_latency_ms = std::max(m_metrics.max_latency_ms, latencyMs);
+
+        m_busyFormats &= ~job.formats;
+        --m_metrics.in_flight;
+
+        // 该格式空闲后其余写线程可能可取任务
+        m_ready.notify_all();
+        m_space.notify_all();
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "compliance/ComplianceReporter.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class CircuitBreaker;
+
+// 队列满时的处理策略
+enum class BackpressurePolicy : uint8_t {
+    CoalesceLatest,     // 同格式待写任务替换为最新快照；仍满时丢弃最旧的待写任务
+    Block               // 阻塞提交线程直至有空位
+};
+
+struct ReportQueueSettings {
+    size_t capacity = 8;        // 待写任务上限（不小于格式数）
+    size_t writers = 2;         // 后台写出线程数
+    BackpressurePolicy policy = BackpressurePolicy::CoalesceLatest;
+    std::vector<ReportFormat> formats{ReportFormat::Json};     // 每轮提交的格式
+    bool pipeline = true;       // 各格式合为一个单遍流水线任务（否则每种格式一个任务）
+
+    // 从规则配置的 "reporting" 节解析
+    static ReportQueueSettings fromRules(const json& rules);
+};
+
+// 队列指标（快照）
+struct ReportQueueMetrics {
+    size_t depth = 0;               // 当前待写任务数
+    size_t max_depth = 0;
+    size_t in_flight = 0;           // 正在写出的任务数
+    uint64_t submitted = 0;
+    uint64_t written = 0;
+    uint64_t coalesced = 0;         // 被同格式新快照替换的任务
+    uint64_t dropped = 0;           // 队列满时丢弃的任务
+    uint64_t failed = 0;
+    uint64_t halted = 0;            // 熔断期间丢弃的任务（提交时或写出前）
+    double last_write_ms = 0.0;     // 写出耗时
+    double mean_write_ms = 0.0;
+    double max_write_ms = 0.0;
+    double last_latency_ms = 0.0;   // 提交至写完
+    double max_latency_ms = 0.0;
+    std::string last_error;
+};
+
+// 异步报告队列：主循环提交共享成分快照（不复制），后台线程生成JSON/CSV/XBRL报告
+// 同一格式写同一当日文件，任一时刻每种格式至多一个任务在写；流水线模式下一个任务单遍写出全部格式
+// 指定熔断器时，熔断期间提交的任务被拒绝，已排队的任务在写出前逐个检查并丢弃（正在写出的任务照常写完）
+class ReportQueue {
+public:
+    ReportQueue(ComplianceReporter& reporter, ReportQueueSettings settings = {},
+                const CircuitBreaker* breaker = nullptr);
+
+    // 写完已提交的任务后停止后台线程
+    ~ReportQueue();
+
+    ReportQueue(const ReportQueue&) = delete;
+    ReportQueue& operator=(const ReportQueue&) = delete;
+
+    // 提交单个格式；CoalesceLatest策略下不阻塞，返回是否入队（含替换），空快照忽略
+    bool submit(ReportFormat format, ComponentSnapshot components);
+
+    // 按配置的全部格式提交（流水线模式下为一个任务）
+    void submit(ComponentSnapshot components);
+
+    // 阻塞至此前提交的任务全部写完
+    void flush();
+
+    ReportQueueMetrics metrics() const;
+    const ReportQueueSettings& settings() const { return m_settings; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Job {
+        uint32_t formats = 0;               // 按 1 << ReportFormat 标记的格式集合
+        ComponentSnapshot components;
+        Clock::time_point submitted;
+    };
+
+    bool submitJob(uint32_t formats, ComponentSnapshot components);
+    void writerLoop();
+
+    // 取出第一个格式空闲的任务（须持锁）
+    bool takeJob(Job& job);
+
+    ComplianceReporter& m_reporter;
+    ReportQueueSettings m_settings;
+    const CircuitBreaker* m_breaker;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_ready;        // 有可写任务或停止
+    std::condition_variable m_space;        // 有空位或任务完成
+    std::deque<Job> m_jobs;
+    uint32_t m_busyFormats = 0;             // 按 1 << ReportFormat 标记正在写出的格式
+    bool m_stopping = false;
+
+    ReportQueueMetrics m_metrics;
+    std::vector<std::thread> m_writers;
+};
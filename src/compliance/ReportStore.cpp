@@ -0,0 +1,732 @@
+﻿#include "ReportStore.hpp"
+#include "core/ByteIO.hpp"
+#include "core/Crc32c.hpp"
+#include "core/FileSync.hpp"
+#include "core/MappedFile.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr char kSegmentMagic[8] = {'R', 'E', 'I', 'T', 'S', 'E', 'G', '1'};
+    constexpr char kFooterMagic[8] = {'R', 'E', 'I', 'T', 'I', 'D', 'X', '1'};
+    constexpr size_t kEntrySize = 32;       // 键、偏移、长度、CRC32C、格式、3字节填充
+    constexpr size_t kFooterSize = 72;      // 布局见ReportSegment::write
+    constexpr size_t kFooterChecked = 56;   // 尾部CRC32C覆盖的前缀
+    constexpr uint16_t kVersion = 1;
+    constexpr uint16_t kFlagArchive = 1;
+    constexpr std::string_view kLoosePrefix = "REITs_Report_";
+
+    using byteio::load;
+    using byteio::store;
+
+    uint64_t pad8(uint64_t size) {
+        return (size + 7) & ~uint64_t(7);
+    }
+
+    // (键, 格式)的字典序
+    bool before(ReportKey ka, ReportFormat fa, ReportKey kb, ReportFormat fb) {
+        return ka != kb ? ka < kb : static_cast<uint8_t>(fa) < static_cast<uint8_t>(fb);
+    }
+
+    // 月份（YYYYMM）及其首个键
+    int keyMonth(ReportKey key) {
+        return reportKeyDate(key) / 100;
+    }
+
+    int nextMonth(int month) {
+        return month % 100 == 12 ? (month / 100 + 1) * 100 + 1 : month + 1;
+    }
+
+    int previousMonth(int month) {
+        return month % 100 == 1 ? (month / 100 - 1) * 100 + 12 : month - 1;
+    }
+
+    ReportKey monthStart(int month) {
+        return makeReportKey(month * 100);
+    }
+
+    // 扩展名对应的报告格式
+    std::optional<ReportFormat> formatForExtension(std::string_view extension) {
+        for (ReportFormat format : kReportFormats) {
+            if (extension == reportExtension(format)) {
+                return format;
+            }
+        }
+        return std::nullopt;
+    }
+
+    // 文件修改时刻的本地时间 HHMMSS（不在date当日时取23:59:59）
+    int modifiedTime(const fs::path& path, int date) {
+        std::error_code ec;
+        fs::file_time_type modified = fs::last_write_time(path, ec);
+        if (ec) {
+            return 235959;
+        }
+        auto system = std::chrono::system_clock::now() +
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                modified - fs::file_time_type::clock::now());
+        time_t t = std::chrono::system_clock::to_time_t(system);
+        tm local{};
+#ifdef _WIN32
+        localtime_s(&local, &t);
+#else
+        localtime_r(&t, &local);
+#endif
+        int localDate = (1900 + local.tm_year) * 10000 + (local.tm_mon + 1) * 100 + local.tm_mday;
+        if (localDate != date) {
+            return 235959;
+        }
+        return local.tm_hour * 10000 + local.tm_min * 100 + local.tm_sec;
+    }
+
+    // 段文件名末尾的文件编号（L<编号>.seg / A<月份>-<编号>.seg），无法解析时为0
+    uint64_t segmentFileId(const fs::path& path) {
+        const std::string stem = path.stem().string();
+        const size_t digits = stem.find_last_not_of("0123456789") + 1;
+        uint64_t id = 0;
+        std::from_chars(stem.data() + digits, stem.data() + stem.size(), id);
+        return id;
+    }
+
+    std::string readFile(const fs::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("无法打开报告文件: " + path.string());
+        }
+        std::string data(static_cast<size_t>(fs::file_size(path)), '\0');
+        if (!file.read(data.data(), static_cast<std::streamsize>(data.size()))) {
+            throw std::runtime_error("报告文件读取失败: " + path.string());
+        }
+        return data;
+    }
+}
+
+ReportStoreSettings ReportStoreSettings::fromRules(const json& rules) {
+    ReportStoreSettings settings;
+    json cfg = rules.value("report_store", json::object());
+    settings.enabled = cfg.value("enabled", settings.enabled);
+    settings.path = cfg.value("path", settings.path);
+    settings.segment_bytes = std::max<uint64_t>(cfg.value("segment_bytes", settings.segment_bytes), 1 << 20);
+    settings.archive_after_months = std::max(cfg.value("archive_after_months", settings.archive_after_months), 1);
+    return settings;
+}
+
+// ---- 段文件 ----
+
+ReportSegment::~ReportSegment() = default;
+
+void ReportSegment::write(const std::string& path, uint64_t sequence, uint64_t fileId, bool archive,
+                          const std::vector<Item>& items) {
+    if (items.empty()) {
+        throw std::invalid_argument("报告段不能为空: " + path);
+    }
+    std::string tmp = path + ".tmp";
+    std::FILE* file = std::fopen(tmp.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error("无法创建报告段: " + tmp);
+    }
+
+    static const char zeros[8] = {};
+    std::vector<char> index(items.size() * kEntrySize, '\0');
+    uint64_t offset = sizeof(kSegmentMagic);
+    bool ok = std::fwrite(kSegmentMagic, 1, sizeof(kSegmentMagic), file) == sizeof(kSegmentMagic);
+    for (size_t i = 0; ok && i < items.size(); ++i) {
+        const Item& item = items[i];
+        uint64_t size = item.data.size();
+        char* e = index.data() + i * kEntrySize;
+        store(e, item.key);
+        store(e + 8, offset);
+        store(e + 16, size);
+        store(e + 24, crc32c(item.data.data(), item.data.size()));
+        e[28] = static_cast<char>(item.format);
+        size_t padding = static_cast<size_t>(pad8(size) - size);
+        ok = (size == 0 || std::fwrite(item.data.data(), 1, item.data.size(), file) == size) &&
+             std::fwrite(zeros, 1, padding, file) == padding;
+        offset += size + padding;
+    }
+
+    // 尾部：索引偏移、项数、优先序号、文件编号、最小/最大键、索引CRC32C、标志、版本、尾部CRC32C、保留、魔数
+    char footer[kFooterSize] = {};
+    store(footer, offset);
+    store(footer + 8, static_cast<uint64_t>(items.size()));
+    store(footer + 16, sequence);
+    store(footer + 24, fileId);
+    store(footer + 32, items.front().key);
+    store(footer + 40, items.back().key);
+    store(footer + 48, crc32c(index.data(), index.size()));
+    store(footer + 52, archive ? kFlagArchive : uint16_t(0));
+    store(footer + 54, kVersion);
+    store(footer + 56, crc32c(footer, kFooterChecked));
+    std::memcpy(footer + 64, kFooterMagic, sizeof(kFooterMagic));
+
+    ok = ok && std::fwrite(index.data(), 1, index.size(), file) == index.size() &&
+         std::fwrite(footer, 1, kFooterSize, file) == kFooterSize && syncFile(file);
+    ok = std::fclose(file) == 0 && ok;
+    std::error_code ec;
+    if (!ok) {
+        fs::remove(tmp, ec);
+        throw std::runtime_error("报告段写出失败: " + path);
+    }
+    try {
+        replaceFile(tmp, path);
+    } catch (...) {
+        fs::remove(tmp, ec);
+        throw;
+    }
+}
+
+std::shared_ptr<const ReportSegment> ReportSegment::open(const std::string& path) {
+    std::shared_ptr<ReportSegment> segment(new ReportSegment());
+    segment->m_path = path;
+    segment->m_file = std::make_unique<MappedFile>(path);
+    const char* base = segment->m_file->data();
+    const size_t size = segment->m_file->size();
+    auto corrupt = [&](const char* what) {
+        return std::runtime_error("报告段损坏(" + std::string(what) + "): " + path);
+    };
+
+    if (size < sizeof(kSegmentMagic) + kFooterSize ||
+        std::memcmp(base, kSegmentMagic, sizeof(kSegmentMagic)) != 0) {
+        throw corrupt("魔数");
+    }
+    const char* footer = base + size - kFooterSize;
+    if (std::memcmp(footer + 64, kFooterMagic, sizeof(kFooterMagic)) != 0 ||
+        load<uint32_t>(footer + 56) != crc32c(footer, kFooterChecked)) {
+        throw corrupt("尾部");
+    }
+    if (load<uint16_t>(footer + 54) != kVersion) {
+        throw corrupt("版本");
+    }
+
+    const uint64_t indexOffset = load<uint64_t>(footer);
+    const uint64_t count = load<uint64_t>(footer + 8);
+    const uint64_t indexEnd = size - kFooterSize;
+    if (indexOffset < sizeof(kSegmentMagic) || indexOffset > indexEnd ||
+        count != (indexEnd - indexOffset) / kEntrySize ||
+        indexOffset + count * kEntrySize != indexEnd) {
+        throw corrupt("索引范围");
+    }
+    const char* index = base + indexOffset;
+    if (load<uint32_t>(footer + 48) != crc32c(index, count * kEntrySize)) {
+        throw corrupt("索引");
+    }
+    for (uint64_t i = 0; i < count; ++i) {
+        const char* e = index + i * kEntrySize;
+        uint64_t offset = load<uint64_t>(e + 8);
+        uint64_t length = load<uint64_t>(e + 16);
+        if (offset > indexOffset || length > indexOffset - offset) {
+            throw corrupt("载荷范围");
+        }
+    }
+
+    segment->m_index = index;
+    segment->m_count = static_cast<size_t>(count);
+    segment->m_indexOffset = indexOffset;
+    segment->m_sequence = load<uint64_t>(footer + 16);
+    segment->m_fileId = load<uint64_t>(footer + 24);
+    segment->m_minKey = load<int64_t>(footer + 32);
+    segment->m_maxKey = load<int64_t>(footer + 40);
+    segment->m_archive = (load<uint16_t>(footer + 52) & kFlagArchive) != 0;
+    return segment;
+}
+
+const char* ReportSegment::entry(size_t i) const {
+    return m_index + i * kEntrySize;
+}
+
+ReportKey ReportSegment::key(size_t i) const {
+    return load<int64_t>(entry(i));
+}
+
+ReportFormat ReportSegment::format(size_t i) const {
+    return static_cast<ReportFormat>(entry(i)[28]);
+}
+
+std::string_view ReportSegment::payload(size_t i) const {
+    const char* e = entry(i);
+    uint64_t offset = load<uint64_t>(e + 8);
+    uint64_t size = load<uint64_t>(e + 16);
+    std::string_view data = m_file->view(static_cast<size_t>(offset), static_cast<size_t>(size));
+    if (crc32c(data.data(), data.size()) != load<uint32_t>(e + 24)) {
+        throw std::runtime_error("报告段载荷校验失败: " + m_path);
+    }
+    return data;
+}
+
+size_t ReportSegment::lowerBound(ReportKey key, ReportFormat format) const {
+    size_t first = 0;
+    size_t count = m_count;
+    while (count > 0) {
+        size_t half = count / 2;
+        size_t mid = first + half;
+        if (before(this->key(mid), this->format(mid), key, format)) {
+            first = mid + 1;
+            count -= half + 1;
+        } else {
+            count = half;
+        }
+    }
+    return first;
+}
+
+uint64_t ReportSegment::fileSize() const {
+    return m_file->size();
+}
+
+// ---- 存储 ----
+
+ReportStore::ReportStore(ReportStoreSettings settings)
+    : m_settings(std::move(settings)) {
+    fs::create_directories(m_settings.path);
+    std::vector<SegmentPtr> segments;
+    for (const auto& entry : fs::directory_iterator(m_settings.path)) {
+        if (!entry.is_regular_file()) {
+            continue;
+        }
+        const fs::path& path = entry.path();
+        if (path.extension() == ".tmp") {
+            // 写出中途崩溃遗留的临时段
+            std::error_code ec;
+            fs::remove(path, ec);
+            continue;
+        }
+        if (path.extension() != ".seg") {
+            continue;
+        }
+        SegmentPtr segment;
+        try {
+            segment = ReportSegment::open(path.string());
+        } catch (const std::exception& e) {
+            // 一个损坏的段不应使整个存储不可用：改名隔离后跳过，文件编号不再复用
+            QuarantinedSegment bad{path.string(), path.string() + ".corrupt", e.what()};
+            for (int n = 1; fs::exists(bad.moved_to); ++n) {
+                bad.moved_to = path.string() + ".corrupt." + std::to_string(n);
+            }
+            std::error_code ec;
+            fs::rename(path, bad.moved_to, ec);
+            if (ec) {
+                bad.moved_to.clear();
+            }
+            m_nextId = std::max(m_nextId, segmentFileId(path) + 1);
+            m_quarantined.push_back(std::move(bad));
+            continue;
+        }
+        m_nextId = std::max(m_nextId, std::max(segment->fileId(), segment->sequence()) + 1);
+        segments.push_back(std::move(segment));
+    }
+    publish(std::move(segments));
+}
+
+ReportStore::~ReportStore() = default;
+
+void ReportStore::publish(std::vector<SegmentPtr> segments) {
+    std::sort(segments.begin(), segments.end(), [](const SegmentPtr& a, const SegmentPtr& b) {
+        return a->minKey() != b->minKey() ? a->minKey() < b->minKey() : a->fileId() < b->fileId();
+    });
+    auto snap = std::make_shared<Snapshot>();
+    snap->min_keys.reserve(segments.size());
+    snap->max_prefix.reserve(segments.size());
+    for (const auto& segment : segments) {
+        snap->min_keys.push_back(segment->minKey());
+        snap->max_prefix.push_back(snap->max_prefix.empty() ? segment->maxKey()
+            : std::max(snap->max_prefix.back(), segment->maxKey()));
+    }
+    snap->segments = std::move(segments);
+    m_snapshot.store(std::move(snap));
+}
+
+std::vector<ReportStore::SegmentPtr> ReportStore::candidates(const Snapshot& snap, ReportKey from,
+                                                             ReportKey to) {
+    // 最小键不大于to的段为前缀；自后向前，前缀最大键小于from时更前的段均不相交
+    size_t end = static_cast<size_t>(
+        std::upper_bound(snap.min_keys.begin(), snap.min_keys.end(), to) - snap.min_keys.begin());
+    std::vector<SegmentPtr> result;
+    for (size_t i = end; i-- > 0 && snap.max_prefix[i] >= from;) {
+        if (snap.segments[i]->maxKey() >= from) {
+            result.push_back(snap.segments[i]);
+        }
+    }
+    return result;
+}
+
+ReportStore::SegmentPtr ReportStore::writeSegment(uint64_t sequence, bool archive, int month,
+                                                  const std::vector<ReportSegment::Item>& items) {
+    uint64_t id = m_nextId++;
+    char name[48];
+    if (archive) {
+        std::snprintf(name, sizeof(name), "A%06d-%016llu.seg", month,
+                      static_cast<unsigned long long>(id));
+    } else {
+        std::snprintf(name, sizeof(name), "L%016llu.seg", static_cast<unsigned long long>(id));
+    }
+    std::string path = (fs::path(m_settings.path) / name).string();
+    ReportSegment::write(path, sequence, id, archive, items);
+    return ReportSegment::open(path);
+}
+
+uint64_t ReportStore::put(std::vector<ReportRecord> records) {
+    if (records.empty()) {
+        return 0;
+    }
+    std::stable_sort(records.begin(), records.end(), [](const ReportRecord& a, const ReportRecord& b) {
+        return before(a.key, a.format, b.key, b.format);
+    });
+    std::vector<ReportSegment::Item> items;
+    items.reserve(records.size());
+    for (size_t i = 0; i < records.size(); ++i) {
+        const ReportRecord& r = records[i];
+        if (i + 1 < records.size() && records[i + 1].key == r.key && records[i + 1].format == r.format) {
+            continue;   // 批内同键同格式保留最后一份
+        }
+        items.push_back({r.key, r.format, r.data});
+    }
+
+    std::lock_guard lock(m_writeMutex);
+    uint64_t sequence = m_nextId;
+    SegmentPtr segment = writeSegment(sequence, false, 0, items);
+    std::vector<SegmentPtr> segments = snapshot()->segments;
+    segments.push_back(std::move(segment));
+    publish(std::move(segments));
+    return sequence;
+}
+
+std::optional<StoredReport> ReportStore::get(ReportKey key, ReportFormat format) const {
+    std::shared_ptr<const Snapshot> snap = snapshot();
+    SegmentPtr best;
+    size_t bestIndex = 0;
+    for (const auto& segment : candidates(*snap, key, key)) {
+        size_t i = segment->lowerBound(key, format);
+        if (i < segment->size() && segment->key(i) == key && segment->format(i) == format &&
+            (!best || segment->sequence() > best->sequence())) {
+            best = segment;
+            bestIndex = i;
+        }
+    }
+    if (!best) {
+        return std::nullopt;
+    }
+    return StoredReport{key, format, best->payload(bestIndex), best};
+}
+
+std::optional<StoredReport> ReportStore::latest(int date, ReportFormat format) const {
+    const ReportKey first = makeReportKey(date);
+    const ReportKey last = makeReportKey(date, 235959);
+    std::shared_ptr<const Snapshot> snap = snapshot();
+    SegmentPtr best;
+    size_t bestIndex = 0;
+    for (const auto& segment : candidates(*snap, first, last)) {
+        // 自当日末尾向前找该格式的最后一项
+        size_t i = segment->lowerBound(last + 1);
+        while (i-- > 0 && segment->key(i) >= first) {
+            if (segment->format(i) != format) {
+                continue;
+            }
+            if (!best || segment->key(i) > best->key(bestIndex) ||
+                (segment->key(i) == best->key(bestIndex) && segment->sequence() > best->sequence())) {
+                best = segment;
+                bestIndex = i;
+            }
+            break;
+        }
+    }
+    if (!best) {
+        return std::nullopt;
+    }
+    return StoredReport{best->key(bestIndex), format, best->payload(bestIndex), best};
+}
+
+size_t ReportStore::scan(ReportKey from, ReportKey to, std::optional<ReportFormat> format,
+                         const std::function<bool(const StoredReport&)>& visit) const {
+    struct Cursor {
+        SegmentPtr segment;
+        size_t index;
+    };
+    // 堆顶为(键, 格式)最小者，相同时优先序号大者在前，其后的旧版本被跳过
+    auto after = [](const Cursor& a, const Cursor& b) {
+        ReportKey ka = a.segment->key(a.index);
+        ReportKey kb = b.segment->key(b.index);
+        ReportFormat fa = a.segment->format(a.index);
+        ReportFormat fb = b.segment->format(b.index);
+        if (ka != kb || fa != fb) {
+            return before(kb, fb, ka, fa);
+        }
+        return a.segment->sequence() < b.segment->sequence();
+    };
+
+    std::shared_ptr<const Snapshot> snap = snapshot();
+    std::vector<Cursor> heap;
+    for (auto& segment : candidates(*snap, from, to)) {
+        size_t i = segment->lowerBound(from);
+        if (i < segment->size() && segment->key(i) <= to) {
+            heap.push_back({std::move(segment), i});
+        }
+    }
+    std::make_heap(heap.begin(), heap.end(), after);
+
+    size_t visited = 0;
+    bool emitted = false;
+    ReportKey lastKey = 0;
+    ReportFormat lastFormat = ReportFormat::Json;
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), after);
+        Cursor cursor = std::move(heap.back());
+        heap.pop_back();
+
+        ReportKey key = cursor.segment->key(cursor.index);
+        ReportFormat f = cursor.segment->format(cursor.index);
+        if (!emitted || key != lastKey || f != lastFormat) {
+            emitted = true;
+            lastKey = key;
+            lastFormat = f;
+            if (!format || *format == f) {
+                ++visited;
+                if (!visit(StoredReport{key, f, cursor.segment->payload(cursor.index), cursor.segment})) {
+                    return visited;
+                }
+            }
+        }
+
+        if (++cursor.index < cursor.segment->size() && cursor.segment->key(cursor.index) <= to) {
+            heap.push_back(std::move(cursor));
+            std::push_heap(heap.begin(), heap.end(), after);
+        }
+    }
+    return visited;
+}
+
+size_t ReportStore::ingest(const std::string& reportPath, int beforeDate) {
+    struct Loose {
+        int date;
+        ReportFormat format;
+        fs::path path;
+    };
+    std::error_code ec;
+    if (!fs::is_directory(reportPath, ec)) {
+        return 0;
+    }
+
+    std::vector<Loose> loose;
+    for (const auto& entry : fs::directory_iterator(reportPath)) {
+        if (!entry.is_regular_file()) {
+            continue;
+        }
+        std::string name = entry.path().filename().string();
+        if (name.size() <= kLoosePrefix.size() + 8 || name.compare(0, kLoosePrefix.size(), kLoosePrefix) != 0) {
+            continue;
+        }
+        const char* digits = name.data() + kLoosePrefix.size();
+        int date = 0;
+        auto [ptr, err] = std::from_chars(digits, digits + 8, date);
+        if (err != std::errc() || ptr != digits + 8 || date >= beforeDate) {
+            continue;
+        }
+        std::optional<ReportFormat> format = formatForExtension(std::string_view(name).substr(kLoosePrefix.size() + 8));
+        if (format) {
+            loose.push_back({date, *format, entry.path()});
+        }
+    }
+    std::sort(loose.begin(), loose.end(), [](const Loose& a, const Loose& b) {
+        return a.date != b.date ? a.date < b.date : a.format < b.format;
+    });
+
+    // 按月、按载荷上限分段写入，段落盘后再删除对应的零散文件
+    size_t ingested = 0;
+    std::vector<ReportRecord> batch;
+    std::vector<fs::path> batchFiles;
+    uint64_t batchBytes = 0;
+    auto flush = [&]() {
+        if (batch.empty()) {
+            return;
+        }
+        put(std::move(batch));
+        for (const auto& path : batchFiles) {
+            fs::remove(path, ec);
+        }
+        ingested += batchFiles.size();
+        batch.clear();
+        batchFiles.clear();
+        batchBytes = 0;
+    };
+    for (const Loose& file : loose) {
+        if (!batch.empty() && (reportKeyDate(batch.back().key) / 100 != file.date / 100 ||
+                               batchBytes >= m_settings.segment_bytes)) {
+            flush();
+        }
+        ReportRecord record;
+        record.key = makeReportKey(file.date, modifiedTime(file.path, file.date));
+        record.format = file.format;
+        record.data = readFile(file.path);
+        batchBytes += record.data.size();
+        batch.push_back(std::move(record));
+        batchFiles.push_back(file.path);
+    }
+    flush();
+    return ingested;
+}
+
+ReportCompactionStats ReportStore::compact(int beforeMonth) {
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point started = Clock::now();
+    ReportCompactionStats stats;
+
+    std::lock_guard lock(m_writeMutex);
+    std::shared_ptr<const Snapshot> snap = snapshot();
+    const ReportKey cutoff = monthStart(beforeMonth);
+
+    // 各段含有的月份：逐月二分跳到下一月，不遍历段内各项
+    std::map<const ReportSegment*, std::vector<int>> segmentMonths;
+    std::map<int, std::vector<SegmentPtr>> sources;
+    std::set<int> blocked;
+    for (const auto& segment : snap->segments) {
+        if (segment->minKey() >= cutoff) {
+            continue;
+        }
+        std::vector<int>& months = segmentMonths[segment.get()];
+        for (size_t i = 0; i < segment->size();) {
+            int month = keyMonth(segment->key(i));
+            months.push_back(month);
+            i = segment->lowerBound(monthStart(nextMonth(month)));
+        }
+        // 跨越截止月份的段使其早于截止的月份暂不压缩
+        for (int month : months) {
+            if (segment->maxKey() >= cutoff) {
+                blocked.insert(month);
+            } else {
+                sources[month].push_back(segment);
+            }
+        }
+    }
+    // 源段的全部月份须一起归档才能删除该段：某月受阻时，与之共享源段的月份一并推迟
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (const auto& [segment, months] : segmentMonths) {
+            bool anyBlocked = std::any_of(months.begin(), months.end(),
+                                          [&](int m) { return blocked.count(m) > 0; });
+            for (int month : months) {
+                if (anyBlocked && blocked.insert(month).second) {
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    std::vector<SegmentPtr> archives;
+    std::set<const ReportSegment*> merged;
+    for (const auto& [month, segments] : sources) {
+        if (blocked.count(month) > 0 || (segments.size() == 1 && segments[0]->archive())) {
+            continue;
+        }
+        // 多路归并该月各段的索引，同(键, 格式)取优先序号大者
+        const ReportKey first = monthStart(month);
+        const ReportKey last = monthStart(nextMonth(month)) - 1;
+        struct Cursor {
+            const ReportSegment* segment;
+            size_t index;
+        };
+        std::vector<Cursor> cursors;
+        uint64_t sequence = 0;
+        for (const auto& segment : segments) {
+            cursors.push_back({segment.get(), segment->lowerBound(first)});
+            sequence = std::max(sequence, segment->sequence());
+        }
+        std::vector<ReportSegment::Item> items;
+        while (true) {
+            const Cursor* best = nullptr;
+            for (const Cursor& c : cursors) {
+                if (c.index >= c.segment->size() || c.segment->key(c.index) > last) {
+                    continue;
+                }
+                if (!best) {
+                    best = &c;
+                    continue;
+                }
+                ReportKey k = c.segment->key(c.index);
+                ReportFormat f = c.segment->format(c.index);
+                ReportKey bk = best->segment->key(best->index);
+                ReportFormat bf = best->segment->format(best->index);
+                if (before(k, f, bk, bf) ||
+                    (k == bk && f == bf && c.segment->sequence() > best->segment->sequence())) {
+                    best = &c;
+                }
+            }
+            if (!best) {
+                break;
+            }
+            ReportKey key = best->segment->key(best->index);
+            ReportFormat format = best->segment->format(best->index);
+            items.push_back({key, format, best->segment->payload(best->index)});
+            for (Cursor& c : cursors) {
+                if (c.index < c.segment->size() && c.segment->key(c.index) == key &&
+                    c.segment->format(c.index) == format) {
+                    ++c.index;
+                }
+            }
+        }
+
+        SegmentPtr archive = writeSegment(sequence, true, month, items);
+        stats.months += 1;
+        stats.reports += items.size();
+        stats.bytes += archive->fileSize();
+        archives.push_back(std::move(archive));
+        for (const auto& segment : segments) {
+            merged.insert(segment.get());
+        }
+    }
+
+    if (!archives.empty()) {
+        std::vector<SegmentPtr> segments;
+        std::vector<std::string> removed;
+        for (const auto& segment : snap->segments) {
+            if (merged.count(segment.get()) > 0) {
+                removed.push_back(segment->path());
+            } else {
+                segments.push_back(segment);
+            }
+        }
+        segments.insert(segments.end(), archives.begin(), archives.end());
+        publish(std::move(segments));
+
+        // 仍在读取的段由映射保持，文件删除失败时留待下次压缩（其内容已被归档覆盖）
+        for (const auto& path : removed) {
+            std::error_code ec;
+            fs::remove(path, ec);
+        }
+        stats.segments_merged = removed.size();
+    }
+    stats.elapsed_ms = std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+    return stats;
+}
+
+ReportMaintenance ReportStore::maintain(const std::string& reportPath, int today) {
+    ReportMaintenance result;
+    result.ingested = ingest(reportPath, today);
+    int month = today / 100;
+    for (int i = 1; i < m_settings.archive_after_months; ++i) {
+        month = previousMonth(month);
+    }
+    result.compaction = compact(month);
+    return result;
+}
+
+ReportStoreStats ReportStore::stats() const {
+    ReportStoreStats stats;
+    std::shared_ptr<const Snapshot> snap = snapshot();
+    for (const auto& segment : snap->segments) {
+        stats.segments += 1;
+        stats.archives += segment->archive() ? 1 : 0;
+        stats.entries += segment->size();
+        stats.bytes += segment->fileSize();
+    }
+    return stats;
+}
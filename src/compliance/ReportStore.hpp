@@ -0,0 +1,211 @@
+#pragma once
+#include "compliance/ComplianceReporter.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+class MappedFile;
+
+struct ReportStoreSettings {
+    bool enabled = true;
+    std::string path = "../reports/store/";
+    uint64_t segment_bytes = 64ull << 20;   // 归入零散报告时单个段的载荷上限（超过即另起一段）
+    int archive_after_months = 1;           // 早于当月往前该月数的各月压缩为月度归档（1为当月以前）
+
+    // 从规则配置的 "report_store" 节解析
+    static ReportStoreSettings fromRules(const json& rules);
+};
+
+// 报告键：本地时间 YYYYMMDDHHMMSS，按数值排序即按时间排序
+using ReportKey = int64_t;
+
+constexpr ReportKey makeReportKey(int date, int hhmmss = 0) {
+    return static_cast<ReportKey>(date) * 1000000 + hhmmss;
+}
+
+constexpr int reportKeyDate(ReportKey key) {
+    return static_cast<int>(key / 1000000);
+}
+
+// 待写入存储的报告
+struct ReportRecord {
+    ReportKey key = 0;
+    ReportFormat format = ReportFormat::Json;
+    std::string data;
+};
+
+class ReportSegment;
+
+// 从存储读出的报告：data直接指向段文件的内存映射，持有segment期间有效
+struct StoredReport {
+    ReportKey key = 0;
+    ReportFormat format = ReportFormat::Json;
+    std::string_view data;
+    std::shared_ptr<const ReportSegment> segment;
+};
+
+struct ReportStoreStats {
+    size_t segments = 0;            // 段文件数（含归档）
+    size_t archives = 0;            // 其中的月度归档数
+    size_t entries = 0;             // 各段索引项合计（被新版本覆盖的旧版本也计入）
+    uint64_t bytes = 0;             // 段文件合计字节数
+};
+
+// 打开存储时因损坏而隔离的段
+struct QuarantinedSegment {
+    std::string path;               // 原段文件
+    std::string moved_to;           // 改名后的文件（改名失败时为空，该段同样不再加载）
+    std::string reason;
+};
+
+struct ReportCompactionStats {
+    size_t months = 0;              // 写出归档的月数
+    size_t segments_merged = 0;     // 被合并删除的源段数
+    size_t reports = 0;             // 归档中的报告数
+    uint64_t bytes = 0;             // 写出的归档字节数
+    double elapsed_ms = 0.0;
+};
+
+struct ReportMaintenance {
+    size_t ingested = 0;            // 归入的零散报告数
+    ReportCompactionStats compaction;
+};
+
+// 不可变的报告段文件，整体只读映射
+// 布局：[8字节魔数][各报告载荷，按8字节对齐][索引][定长尾部]，整数均为小端
+// 索引项按(键, 格式)升序，每项32字节：键、载荷偏移、载荷长度、载荷CRC32C、格式
+// 尾部含索引偏移、项数、优先序号、键范围与索引CRC32C，自身以CRC32C和魔数结尾
+// 打开时只校验尾部与索引，载荷在读取时逐份校验；同一(键, 格式)出现在多个段时优先序号大者有效
+class ReportSegment {
+public:
+    // 映射并校验段文件（失败抛出异常）
+    static std::shared_ptr<const ReportSegment> open(const std::string& path);
+
+    ~ReportSegment();
+
+    size_t size() const { return m_count; }
+    ReportKey key(size_t i) const;
+    ReportFormat format(size_t i) const;
+
+    // 第i份报告的内容（校验CRC32C，失败抛出异常）
+    std::string_view payload(size_t i) const;
+
+    // 首个(键, 格式)不小于(key, format)的索引项
+    size_t lowerBound(ReportKey key, ReportFormat format = ReportFormat::Json) const;
+
+    uint64_t sequence() const { return m_sequence; }
+    uint64_t fileId() const { return m_fileId; }
+    ReportKey minKey() const { return m_minKey; }
+    ReportKey maxKey() const { return m_maxKey; }
+    bool archive() const { return m_archive; }
+    uint64_t fileSize() const;
+    const std::string& path() const { return m_path; }
+
+    // 待写出的一份报告（data须在写出期间有效）
+    struct Item {
+        ReportKey key = 0;
+        ReportFormat format = ReportFormat::Json;
+        std::string_view data;
+    };
+
+    // 写出段文件：先写同目录临时文件并fsync，再原子替换为path（重命名落盘后返回）；items须按(键, 格式)严格升序
+    static void write(const std::string& path, uint64_t sequence, uint64_t fileId, bool archive,
+                      const std::vector<Item>& items);
+
+private:
+    ReportSegment() = default;
+
+    const char* entry(size_t i) const;
+
+    std::string m_path;
+    std::unique_ptr<MappedFile> m_file;
+    const char* m_index = nullptr;
+    size_t m_count = 0;
+    uint64_t m_indexOffset = 0;
+    uint64_t m_sequence = 0;
+    uint64_t m_fileId = 0;
+    ReportKey m_minKey = 0;
+    ReportKey m_maxKey = 0;
+    bool m_archive = false;
+};
+
+// 按日期/时刻索引的历史报告存储：报告以批为单位写成不可变段，按段的键范围与段内有序索引定位
+// 取某一份报告或某日、某区间的报告为 O(log 段数 + log 段内项数)，区间扫描在各段索引上多路归并，
+// 只触及区间内报告的载荷页，不解析其他文件；早于归档期的各月段合并为每月一个归档段
+// 读取无锁（原子发布的段集快照），写入、归入与压缩相互串行
+class ReportStore {
+public:
+    // 打开（或创建）存储目录并映射全部段；清理崩溃遗留的临时文件
+    // 无法打开的段改名为 .corrupt 隔离（见quarantined()），其余段照常加载，其中的报告不再可见
+    explicit ReportStore(ReportStoreSettings settings = {});
+    ~ReportStore();
+
+    ReportStore(const ReportStore&) = delete;
+    ReportStore& operator=(const ReportStore&) = delete;
+
+    // 一批报告写为一个新段（批内同键同格式以后者为准，并覆盖存储中已有的版本），返回优先序号
+    uint64_t put(std::vector<ReportRecord> records);
+
+    // 键为key的format报告
+    std::optional<StoredReport> get(ReportKey key, ReportFormat format) const;
+
+    // date（YYYYMMDD）当日最后一份format报告
+    std::optional<StoredReport> latest(int date, ReportFormat format) const;
+
+    // 按(键, 格式)顺序流式访问键在[from, to]内的报告（format为空时为全部格式）
+    // visit返回false时提前停止，返回访问的报告数
+    size_t scan(ReportKey from, ReportKey to, std::optional<ReportFormat> format,
+                const std::function<bool(const StoredReport&)>& visit) const;
+
+    // 将reportPath下报告日期早于beforeDate的当日报告文件（REITs_Report_YYYYMMDD.*）写入新段后删除
+    // 键取文件修改时刻（不在报告当日时取23:59:59），返回归入的报告数
+    size_t ingest(const std::string& reportPath, int beforeDate);
+
+    // 将早于beforeMonth（YYYYMM）各月的段合并为每月一个归档段，随后删除被合并的段
+    // 仍有段跨越该月与未到期月份时，该月留待以后压缩
+    ReportCompactionStats compact(int beforeMonth);
+
+    // 日常维护：归入today以前的零散报告，并按archive_after_months压缩
+    ReportMaintenance maintain(const std::string& reportPath, int today);
+
+    ReportStoreStats stats() const;
+    const ReportStoreSettings& settings() const { return m_settings; }
+
+    // 打开时隔离的损坏段
+    const std::vector<QuarantinedSegment>& quarantined() const { return m_quarantined; }
+
+private:
+    using SegmentPtr = std::shared_ptr<const ReportSegment>;
+
+    // 段集快照：按最小键升序，附最小键与最大键的前缀最大值，供二分定位候选段
+    struct Snapshot {
+        std::vector<SegmentPtr> segments;
+        std::vector<ReportKey> min_keys;
+        std::vector<ReportKey> max_prefix;
+    };
+
+    std::shared_ptr<const Snapshot> snapshot() const { return m_snapshot.load(); }
+    void publish(std::vector<SegmentPtr> segments);
+
+    // 键范围与[from, to]相交的段
+    static std::vector<SegmentPtr> candidates(const Snapshot& snap, ReportKey from, ReportKey to);
+
+    // 写出并映射新段，文件编号取m_nextId（调用方持有m_writeMutex）
+    SegmentPtr writeSegment(uint64_t sequence, bool archive, int month,
+                            const std::vector<ReportSegment::Item>& items);
+
+    ReportStoreSettings m_settings;
+    std::mutex m_writeMutex;
+    uint64_t m_nextId = 1;          // 新段的文件编号与优先序号
+    std::atomic<std::shared_ptr<const Snapshot>> m_snapshot;
+    std::vector<QuarantinedSegment> m_quarantined;
+};
@@ -0,0 +1,213 @@
+﻿#include "XbrlWriter.hpp"
+#include "compliance/DecimalText.hpp"
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define XBRL_ESCAPE_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#define XBRL_ESCAPE_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+    // 需处理的字节：实体字符与全部控制字符（制表、换行、回车在处理时原样保留）
+    constexpr std::array<bool, 256> kSpecial = [] {
+        std::array<bool, 256> table{};
+        for (int c = 0; c < 0x20; ++c) {
+            table[c] = true;
+        }
+        table['&'] = true;
+        table['<'] = true;
+        table['>'] = true;
+        table['"'] = true;
+        table['\''] = true;
+        return table;
+    }();
+
+    // 首个需处理字节的位置（无则为size）
+    size_t findSpecial(const char* data, size_t size) {
+        size_t i = 0;
+#if defined(XBRL_ESCAPE_SSE2)
+        const __m128i amp = _mm_set1_epi8('&');
+        const __m128i lt = _mm_set1_epi8('<');
+        const __m128i gt = _mm_set1_epi8('>');
+        const __m128i quot = _mm_set1_epi8('"');
+        const __m128i apos = _mm_set1_epi8('\'');
+        const __m128i ctl = _mm_set1_epi8(0x1F);
+        for (; i + 16 <= size; i += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i hit = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, amp), _mm_cmpeq_epi8(v, lt)),
+                _mm_or_si128(_mm_cmpeq_epi8(v, gt), _mm_cmpeq_epi8(v, quot)));
+            // 无符号 v <= 0x1F
+            hit = _mm_or_si128(hit, _mm_or_si128(_mm_cmpeq_epi8(v, apos),
+                                                 _mm_cmpeq_epi8(_mm_max_epu8(v, ctl), ctl)));
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hit));
+            if (mask != 0) {
+                return i + static_cast<size_t>(std::countr_zero(mask));
+            }
+        }
+#elif defined(XBRL_ESCAPE_NEON)
+        const uint8x16_t amp = vdupq_n_u8('&');
+        const uint8x16_t lt = vdupq_n_u8('<');
+        const uint8x16_t gt = vdupq_n_u8('>');
+        const uint8x16_t quot = vdupq_n_u8('"');
+        const uint8x16_t apos = vdupq_n_u8('\'');
+        const uint8x16_t ctl = vdupq_n_u8(0x20);
+        for (; i + 16 <= size; i += 16) {
+            uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(data + i));
+            uint8x16_t hit = vorrq_u8(vorrq_u8(vceqq_u8(v, amp), vceqq_u8(v, lt)),
+                                      vorrq_u8(vceqq_u8(v, gt), vceqq_u8(v, quot)));
+            hit = vorrq_u8(hit, vorrq_u8(vceqq_u8(v, apos), vcltq_u8(v, ctl)));
+            if (vmaxvq_u8(hit) != 0) {
+                break;  // 在本块内逐字节定位
+            }
+        }
+#endif
+        for (; i < size; ++i) {
+            if (kSpecial[static_cast<unsigned char>(data[i])]) {
+                return i;
+            }
+        }
+        return size;
+    }
+}
+
+void XbrlWriter::writeEscaped(FileSink& sink, std::string_view text) {
+    const char* p = text.data();
+    size_t remaining = text.size();
+    while (remaining > 0) {
+        size_t run = findSpecial(p, remaining);
+        sink.write(p, run);
+        if (run == remaining) {
+            return;
+        }
+        switch (p[run]) {
+        case '&': sink.write("&amp;"); break;
+        case '<': sink.write("&lt;"); break;
+        case '>': sink.write("&gt;"); break;
+        case '"': sink.write("&quot;"); break;
+        case '\'': sink.write("&apos;"); break;
+        case '\t':
+        case '\n':
+        case '\r':
+            sink.put(p[run]);
+            break;
+        default:
+            break;  // XML 1.0不可表示的控制字符
+        }
+        p += run + 1;
+        remaining -= run + 1;
+    }
+}
+
+char* XbrlWriter::formatDecimal(char* buf, double number) {
+    return std::to_chars(buf, buf + kDecimalBuffer, number, std::chars_format::fixed).ptr;
+}
+
+void XbrlWriter::begin(std::string_view schemaRef) {
+    m_sink.write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                 "<xbrli:xbrl xmlns:xbrli=\"http://www.xbrl.org/2003/instance\""
+                 " xmlns:link=\"http://www.xbrl.org/2003/linkbase\""
+                 " xmlns:xlink=\"http://www.w3.org/1999/xlink\""
+                 " xmlns:iso4217=\"http://www.xbrl.org/2003/iso4217\""
+                 " xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\""
+                 " xmlns:reits=\"");
+    m_sink.write(kTaxonomyNamespace);
+    m_sink.write("\">\n  <link:schemaRef xlink:type=\"simple\" xlink:href=\"");
+    writeEscaped(m_sink, schemaRef);
+    m_sink.write("\"/>\n  <xbrli:unit id=\"");
+    m_sink.write(kUnitPure);
+    m_sink.write("\"><xbrli:measure>xbrli:pure</xbrli:measure></xbrli:unit>\n  <xbrli:unit id=\"");
+    m_sink.write(kUnitCny);
+    m_sink.write("\"><xbrli:measure>iso4217:CNY</xbrli:measure></xbrli:unit>\n");
+}
+
+void XbrlWriter::context(std::string_view id, std::string_view entity, std::string_view date,
+                         std::string_view constituent) {
+    m_sink.write("  <xbrli:context id=\"");
+    writeEscaped(m_sink, id);
+    m_sink.write("\"><xbrli:entity><xbrli:identifier scheme=\"");
+    m_sink.write(kEntityScheme);
+    m_sink.write("\">");
+    writeEscaped(m_sink, entity);
+    m_sink.write("</xbrli:identifier>");
+    if (!constituent.empty()) {
+        m_sink.write("<xbrli:segment><reits:ConstituentCode>");
+        writeEscaped(m_sink, constituent);
+        m_sink.write("</reits:ConstituentCode></xbrli:segment>");
+    }
+    m_sink.write("</xbrli:entity><xbrli:period><xbrli:instant>");
+    writeEscaped(m_sink, date);
+    m_sink.write("</xbrli:instant></xbrli:period></xbrli:context>\n");
+}
+
+void XbrlWriter::openFact(std::string_view name, std::string_view contextRef) {
+    m_sink.write("  <reits:");
+    m_sink.write(name);
+    m_sink.write(" contextRef=\"");
+    writeEscaped(m_sink, contextRef);
+    m_sink.put('"');
+}
+
+void XbrlWriter::closeFact(std::string_view name) {
+    m_sink.write("</reits:");
+    m_sink.write(name);
+    m_sink.write(">\n");
+}
+
+void XbrlWriter::fact(std::string_view name, std::string_view contextRef, std::string_view text) {
+    openFact(name, contextRef);
+    m_sink.put('>');
+    writeEscaped(m_sink, text);
+    closeFact(name);
+}
+
+void XbrlWriter::fact(std::string_view name, std::string_view contextRef, double number,
+                      std::string_view unitRef) {
+    openFact(name, contextRef);
+    m_sink.write(" unitRef=\"");
+    m_sink.write(unitRef);
+    if (!std::isfinite(number)) {
+        m_sink.write("\" xsi:nil=\"true\"/>\n");
+        return;
+    }
+    m_sink.write("\" decimals=\"INF\">");
+    char buf[kDecimalBuffer];
+    m_sink.write(buf, static_cast<size_t>(formatDecimal(buf, number) - buf));
+    closeFact(name);
+}
+
+void XbrlWriter::fact(std::string_view name, std::string_view contextRef, const DecimalText& number,
+                      std::string_view unitRef) {
+    openFact(name, contextRef);
+    m_sink.write(" unitRef=\"");
+    m_sink.write(unitRef);
+    if (!number.finite()) {
+        m_sink.write("\" xsi:nil=\"true\"/>\n");
+        return;
+    }
+    m_sink.write("\" decimals=\"INF\">");
+    char buf[DecimalText::kBuffer];
+    m_sink.write(buf, static_cast<size_t>(number.fixed(buf) - buf));
+    closeFact(name);
+}
+
+void XbrlWriter::fact(std::string_view name, std::string_view contextRef, uint64_t number,
+                      std::string_view unitRef) {
+    openFact(name, contextRef);
+    m_sink.write(" unitRef=\"");
+    m_sink.write(unitRef);
+    m_sink.write("\" decimals=\"INF\">");
+    char buf[24];
+    m_sink.write(buf, static_cast<size_t>(std::to_chars(buf, buf + sizeof(buf), number).ptr - buf));
+    closeFact(name);
+}
+
+void XbrlWriter::end() {
+    m_sink.write("</xbrli:xbrl>\n");
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "compliance/FileSink.hpp"
+#include <cstdint>
+#include <string_view>
+
+struct DecimalText;
+
+// 流式XBRL 2.1实例写出：直接写入FileSink，上下文、单位与事实按写出顺序交错，内存占用与规模无关
+// 概念取自 config/xbrl/reits-index.xsd（命名空间前缀 reits），单位预置 pure（比例）与 CNY（人民币）
+// 数值事实为定点十进制（xs:decimal不允许指数形式），取最短往返表示，decimals="INF"；非有限值写为 xsi:nil
+class XbrlWriter {
+public:
+    static constexpr std::string_view kTaxonomyNamespace = "http://www.csindex.com.cn/xbrl/reits50";
+    static constexpr std::string_view kEntityScheme = "http://www.csindex.com.cn";
+    static constexpr std::string_view kUnitPure = "pure";
+    static constexpr std::string_view kUnitCny = "CNY";
+
+    explicit XbrlWriter(FileSink& sink) : m_sink(sink) {}
+
+    // XML声明、根元素、schemaRef与预置单位
+    void begin(std::string_view schemaRef);
+
+    // 时点上下文：报告主体entity，date为YYYY-MM-DD；constituent非空时以成分代码作为分部
+    void context(std::string_view id, std::string_view entity, std::string_view date,
+                 std::string_view constituent = {});
+
+    // 事实（name为不含前缀的概念名）
+    void fact(std::string_view name, std::string_view contextRef, std::string_view text);
+    void fact(std::string_view name, std::string_view contextRef, double number,
+              std::string_view unitRef);
+    void fact(std::string_view name, std::string_view contextRef, const DecimalText& number,
+              std::string_view unitRef);
+    void fact(std::string_view name, std::string_view contextRef, uint64_t number,
+              std::string_view unitRef);
+
+    // 结束根元素
+    void end();
+
+    // 写出XML转义后的文本：& < > " ' 转为实体，XML 1.0不允许的控制字符丢弃
+    // 以16字节向量比较定位需处理的字节，其余连续片段整段复制
+    static void writeEscaped(FileSink& sink, std::string_view text);
+
+    // 最短往返的定点十进制表示，返回写入末尾（buf至少kDecimalBuffer字节）
+    static constexpr size_t kDecimalBuffer = 352;
+    static char* formatDecimal(char* buf, double number);
+
+private:
+    void openFact(std::string_view name, std::string_view contextRef);
+    void closeFact(std::string_view name);
+
+    FileSink& m_sink;
+};
@@ -0,0 +1,174 @@
+﻿#include "AttributionEngine.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // 每个分组的累计量布局
+    enum Slot { WP, WB, CONTRIB, ALLOC, SEL, INTER, SLOTS };
+
+    // 两组权重与收益的点积（四路累加便于编译器向量化）
+    void dotPair(const double* w, const double* b, const double* r, size_t n,
+                 double& wr, double& br) {
+        double w0 = 0.0, w1 = 0.0, w2 = 0.0, w3 = 0.0;
+        double b0 = 0.0, b1 = 0.0, b2 = 0.0, b3 = 0.0;
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            w0 += w[i] * r[i];         b0 += b[i] * r[i];
+            w1 += w[i + 1] * r[i + 1]; b1 += b[i + 1] * r[i + 1];
+            w2 += w[i + 2] * r[i + 2]; b2 += b[i + 2] * r[i + 2];
+            w3 += w[i + 3] * r[i + 3]; b3 += b[i + 3] * r[i + 3];
+        }
+        for (; i < n; ++i) {
+            w0 += w[i] * r[i];
+            b0 += b[i] * r[i];
+        }
+        wr = (w0 + w1) + (w2 + w3);
+        br = (b0 + b1) + (b2 + b3);
+    }
+
+    // Carino对数链接系数
+    double carino(double a, double b) {
+        if (std::fabs(a - b) < 1e-12) {
+            return 1.0 / (1.0 + a);
+        }
+        return (std::log1p(a) - std::log1p(b)) / (a - b);
+    }
+}
+
+AttributionResult AttributionEngine::analyze(int startDate, int endDate,
+                                             AttributionLevel level) const {
+    AttributionResult result;
+    result.start_date = startDate;
+    result.end_date = endDate;
+
+    // 第t期收益使用第t-1期末权重，因此首期至少为1
+    size_t first = std::max<size_t>(m_history.upperBound(startDate), 1);
+    size_t last = m_history.upperBound(endDate);
+    if (first >= last) {
+        return result;
+    }
+
+    size_t n = m_history.constituentCount();
+    size_t periods = last - first;
+    result.periods = periods;
+
+    // 分组映射
+    std::vector<uint32_t> groupOf(n);
+    size_t groups = 0;
+    switch (level) {
+    case AttributionLevel::Constituent:
+        for (size_t i = 0; i < n; ++i) {
+            groupOf[i] = static_cast<uint32_t>(i);
+            result.groups.push_back({m_history.code(i)});
+        }
+        break;
+    case AttributionLevel::Sector:
+        groupOf.assign(m_history.sectorIds().begin(), m_history.sectorIds().end());
+        for (uint32_t g = 0; g < m_history.sectors().size(); ++g) {
+            result.groups.push_back({m_history.sectors().name(g)});
+        }
+        break;
+    case AttributionLevel::Region:
+        groupOf.assign(m_history.regionIds().begin(), m_history.regionIds().end());
+        for (uint32_t g = 0; g < m_history.regions().size(); ++g) {
+            result.groups.push_back({m_history.regions().name(g)});
+        }
+        break;
+    }
+    groups = result.groups.size();
+
+    ThreadPool& pool = ThreadPool::shared();
+    const size_t grain = 32;
+
+    // 第一遍：各期指数与基准收益
+    std::vector<double> rp(periods), rb(periods);
+    pool.parallelFor(0, periods, grain, [&](size_t lo, size_t hi, size_t) {
+        for (size_t k = lo; k < hi; ++k) {
+            size_t t = first + k;
+            dotPair(m_history.weights(t - 1), m_history.benchmarkWeights(t - 1),
+                    m_history.returns(t), n, rp[k], rb[k]);
+        }
+    });
+
+    double growthP = 1.0, growthB = 1.0;
+    for (size_t k = 0; k < periods; ++k) {
+        growthP *= 1.0 + rp[k];
+        growthB *= 1.0 + rb[k];
+    }
+    result.portfolio_return = growthP - 1.0;
+    result.benchmark_return = growthB - 1.0;
+
+    double linkActive = carino(result.portfolio_return, result.benchmark_return);
+    double linkTotal = carino(result.portfolio_return, 0.0);
+
+    // 第二遍：按期分组聚合并计算链接后的效应，线程内累加后归并
+    size_t workers = pool.size();
+    std::vector<double> totals(workers * groups * SLOTS, 0.0);
+    std::vector<double> scratch(workers * groups * 4, 0.0);
+
+    pool.parallelFor(0, periods, grain, [&](size_t lo, size_t hi, size_t worker) {
+        double* acc = &totals[worker * groups * SLOTS];
+        double* sWp = &scratch[worker * groups * 4];
+        double* sWb = sWp + groups;
+        double* sCp = sWb + groups;
+        double* sCb = sCp + groups;
+
+        for (size_t k = lo; k < hi; ++k) {
+            size_t t = first + k;
+            const double* w = m_history.weights(t - 1);
+            const double* b = m_history.benchmarkWeights(t - 1);
+            const double* r = m_history.returns(t);
+
+            std::fill_n(sWp, groups * 4, 0.0);
+            for (size_t i = 0; i < n; ++i) {
+                uint32_t g = groupOf[i];
+                sWp[g] += w[i];
+                sWb[g] += b[i];
+                sCp[g] += w[i] * r[i];
+                sCb[g] += b[i] * r[i];
+            }
+
+            double kActive = carino(rp[k], rb[k]) / linkActive;
+            double kTotal = carino(rp[k], 0.0) / linkTotal;
+
+            for (size_t g = 0; g < groups; ++g) {
+                double wp = sWp[g];
+                double wb = sWb[g];
+                double rbg = wb > 0.0 ? sCb[g] / wb : 0.0;
+                double rpg = wp > 0.0 ? sCp[g] / wp : rbg;
+                if (wb <= 0.0) {
+                    rbg = rpg;
+                }
+
+                double* slot = acc + g * SLOTS;
+                slot[WP] += wp;
+                slot[WB] += wb;
+                slot[CONTRIB] += kTotal * sCp[g];
+                slot[ALLOC] += kActive * (wp - wb) * (rbg - rb[k]);
+                slot[SEL] += kActive * wb * (rpg - rbg);
+                slot[INTER] += kActive * (wp - wb) * (rpg - rbg);
+            }
+        }
+    });
+
+    for (size_t g = 0; g < groups; ++g) {
+        double sums[SLOTS] = {};
+        for (size_t w = 0; w < workers; ++w) {
+            const double* slot = &totals[(w * groups + g) * SLOTS];
+            for (int s = 0; s < SLOTS; ++s) {
+                sums[s] += slot[s];
+            }
+        }
+
+        auto& out = result.groups[g];
+        out.portfolio_weight = sums[WP] / periods;
+        out.benchmark_weight = sums[WB] / periods;
+        out.contribution = sums[CONTRIB];
+        out.allocation = sums[ALLOC];
+        out.selection = sums[SEL];
+        out.interaction = sums[INTER];
+    }
+
+    return result;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "core/IndexHistory.hpp"
+#include <string>
+#include <vector>
+
+// 归因分组口径
+enum class AttributionLevel {
+    Constituent,    // 单只REIT
+    Sector,         // 资产类型
+    Region          // 区域
+};
+
+// 分组归因结果（各效应已按Carino系数跨期链接，合计等于区间累计收益差）
+struct GroupAttribution {
+    std::string name;
+    double portfolio_weight = 0.0;  // 区间平均指数权重
+    double benchmark_weight = 0.0;  // 区间平均基准权重
+    double contribution = 0.0;      // 对指数区间收益的贡献
+    double allocation = 0.0;        // 配置效应
+    double selection = 0.0;         // 选择效应
+    double interaction = 0.0;       // 交互效应
+};
+
+struct AttributionResult {
+    int start_date = 0;
+    int end_date = 0;
+    size_t periods = 0;
+    double portfolio_return = 0.0;  // 指数区间累计收益
+    double benchmark_return = 0.0;  // 基准区间累计收益
+    std::vector<GroupAttribution> groups;
+};
+
+// 业绩归因引擎：基于指数历史对任意区间做Brinson-Fachler归因
+class AttributionEngine {
+public:
+    explicit AttributionEngine(const IndexHistory& history) : m_history(history) {}
+
+    // 计算(startDate, endDate]区间的归因，各期使用上期末权重与本期收益
+    AttributionResult analyze(int startDate, int endDate, AttributionLevel level) const;
+
+private:
+    const IndexHistory& m_history;
+};
@@ -0,0 +1,20 @@
+#pragma once
+#include <bit>
+#include <cstring>
+
+// 定长二进制文件格式（审计日志、报告段）的非对齐读写：按本机字节序逐字节复制，格式约定为小端
+namespace byteio {
+    static_assert(std::endian::native == std::endian::little, "二进制文件格式按小端读写");
+
+    template <typename T>
+    inline void store(char* p, T value) {
+        std::memcpy(p, &value, sizeof(T));
+    }
+
+    template <typename T>
+    inline T load(const char* p) {
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        return value;
+    }
+}
@@ -0,0 +1,364 @@
+﻿#include "CovarianceEngine.hpp"
+#include "IndexHistory.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+CovarianceSettings CovarianceSettings::fromRules(const json& rules) {
+    CovarianceSettings settings;
+    json cfg = rules.value("covariance", json::object());
+
+    std::string method = cfg.value("method", std::string("ewma"));
+    if (method == "ewma") {
+        settings.method = CovarianceMethod::Ewma;
+    } else if (method == "rolling") {
+        settings.method = CovarianceMethod::Rolling;
+    } else {
+        throw std::runtime_error("未知的协方差估计方法: " + method);
+    }
+
+    std::string shrinkage = cfg.value("shrinkage", std::string("none"));
+    if (shrinkage == "none") {
+        settings.shrinkage = ShrinkageTarget::None;
+    } else if (shrinkage == "identity") {
+        settings.shrinkage = ShrinkageTarget::ScaledIdentity;
+    } else if (shrinkage == "constant_correlation") {
+        settings.shrinkage = ShrinkageTarget::ConstantCorrelation;
+    } else {
+        throw std::runtime_error("未知的协方差收缩目标: " + shrinkage);
+    }
+
+    settings.lambda = cfg.value("lambda", settings.lambda);
+    settings.window = cfg.value("window", settings.window);
+    settings.intensity = std::clamp(cfg.value("intensity", settings.intensity), 0.0, 1.0);
+    return settings;
+}
+
+PackedSymmetric::PackedSymmetric(size_t n) : m_n(n), m_offset(n) {
+    size_t offset = 0;
+    for (size_t i = 0; i < n; ++i) {
+        m_offset[i] = offset;
+        offset += (n - i + 3) & ~size_t(3);
+    }
+    m_data.assign(offset, 0.0);
+}
+
+std::vector<double> CovarianceSnapshot::dense(const std::vector<std::string>& subset) const {
+    size_t n = subset.size();
+    std::vector<double> out(n * n, 0.0);
+
+    std::vector<int> index(n, -1);
+    for (size_t a = 0; a < n; ++a) {
+        auto it = std::find(codes->begin(), codes->end(), subset[a]);
+        if (it != codes->end()) {
+            index[a] = static_cast<int>(it - codes->begin());
+        }
+    }
+
+    for (size_t a = 0; a < n; ++a) {
+        if (index[a] < 0) {
+            continue;
+        }
+        for (size_t b = a; b < n; ++b) {
+            if (index[b] < 0) {
+                continue;
+            }
+            double v = matrix.at(index[a], index[b]);
+            out[a * n + b] = v;
+            out[b * n + a] = v;
+        }
+    }
+    return out;
+}
+
+namespace {
+    // 扩展打包矩阵至n阶，已有元素保持原位置，新增行列为0
+    PackedSymmetric widened(const PackedSymmetric& m, size_t n) {
+        PackedSymmetric out(n);
+        for (size_t i = 0; i < m.size(); ++i) {
+            std::copy_n(m.row(i), m.size() - i, out.row(i));
+        }
+        return out;
+    }
+
+    // 拆分观测：缺测（NaN）取值记0、掩码记0
+    void splitObservations(const double* x, size_t n, double* value, double* mask) {
+        for (size_t i = 0; i < n; ++i) {
+            bool observed = !std::isnan(x[i]);
+            value[i] = observed ? x[i] : 0.0;
+            mask[i] = observed ? 1.0 : 0.0;
+        }
+    }
+}
+
+CovarianceEngine::CovarianceEngine(std::vector<std::string> codes, CovarianceSettings settings)
+    : m_n(0), m_settings(settings) {
+
+    if (m_settings.method == CovarianceMethod::Ewma) {
+        if (m_settings.lambda <= 0.0 || m_settings.lambda >= 1.0) {
+            throw std::runtime_error("EWMA衰减因子须位于(0, 1)");
+        }
+    } else if (m_settings.window < 2) {
+        throw std::runtime_error("滚动窗口至少为2期");
+    }
+
+    for (size_t i = 0; i < codes.size(); ++i) {
+        m_index.emplace(codes[i], static_cast<int>(i));
+    }
+    m_codes = std::make_shared<const std::vector<std::string>>(std::move(codes));
+    resize(m_codes->size());
+
+    publish();
+}
+
+void CovarianceEngine::resize(size_t n) {
+    const size_t old = m_n;
+    m_value.resize(n, 0.0);
+    m_mask.resize(n, 0.0);
+    if (m_settings.method == CovarianceMethod::Ewma) {
+        m_mean.resize(n, 0.0);
+        m_seen.resize(n, 0);
+        m_delta.resize(n, 0.0);
+        m_ewma = widened(m_ewma, n);
+        m_ewmaWeight = widened(m_ewmaWeight, n);
+    } else {
+        // 环形缓冲逐期加宽，新代码在已有各期记为缺测
+        std::vector<double> ring(m_settings.window * n, std::nan(""));
+        for (size_t slot = 0; old > 0 && slot < m_settings.window; ++slot) {
+            std::copy_n(&m_ring[slot * old], old, &ring[slot * n]);
+        }
+        m_ring = std::move(ring);
+        m_evictValue.resize(n, 0.0);
+        m_evictMask.resize(n, 0.0);
+        m_cross = widened(m_cross, n);
+        m_pairCount = widened(m_pairCount, n);
+        m_pairSumRow = widened(m_pairSumRow, n);
+        m_pairSumCol = widened(m_pairSumCol, n);
+    }
+    m_n = n;
+}
+
+void CovarianceEngine::addCodes(const std::vector<std::string>& codes) {
+    std::vector<std::string> all = *m_codes;
+    for (const auto& code : codes) {
+        if (m_index.emplace(code, static_cast<int>(all.size())).second) {
+            all.push_back(code);
+        }
+    }
+    if (all.size() == m_n) {
+        return;
+    }
+    resize(all.size());
+    m_codes = std::make_shared<const std::vector<std::string>>(std::move(all));
+    publish();
+}
+
+int CovarianceEngine::indexOf(const std::string& code) const {
+    auto it = m_index.find(code);
+    return it != m_index.end() ? it->second : -1;
+}
+
+void CovarianceEngine::update(const double* returns) {
+    if (m_settings.method == CovarianceMethod::Ewma) {
+        updateEwma(returns);
+    } else {
+        updateRolling(returns);
+    }
+    ++m_observations;
+    publish();
+}
+
+void CovarianceEngine::update(const IndexHistory& history, size_t t) {
+    m_scratch.assign(m_n, std::nan(""));
+    const double* returns = history.returns(t);
+    const double* caps = history.marketCaps(t);
+    const double* prevCaps = t > 0 ? history.marketCaps(t - 1) : nullptr;
+    for (size_t i = 0; i < history.constituentCount(); ++i) {
+        int at = indexOf(history.code(i));
+        if (at >= 0 && prevCaps && caps[i] > 0.0 && prevCaps[i] > 0.0) {
+            m_scratch[at] = returns[i];
+        }
+    }
+    update(m_scratch.data());
+}
+
+void CovarianceEngine::updateEwma(const double* x) {
+    const double lambda = m_settings.lambda;
+    const double alpha = 1.0 - lambda;
+
+    // 加权增量更新：d = x - μ，μ += αd，C = λ(C + α·d·dᵀ)，W = λ(W + α)
+    // 首个观测只作均值初值；缺测的代码及其所在的对本期不更新、不衰减
+    for (size_t i = 0; i < m_n; ++i) {
+        m_mask[i] = 0.0;
+        m_delta[i] = 0.0;
+        if (std::isnan(x[i])) {
+            continue;
+        }
+        if (!m_seen[i]) {
+            m_mean[i] = x[i];
+            m_seen[i] = 1;
+            continue;
+        }
+        m_delta[i] = x[i] - m_mean[i];
+        m_mean[i] += alpha * m_delta[i];
+        m_mask[i] = 1.0;
+    }
+
+    const double* d = m_delta.data();
+    const double* m = m_mask.data();
+    for (size_t i = 0; i < m_n; ++i) {
+        if (m[i] == 0.0) {
+            continue;
+        }
+        double* row = m_ewma.row(i);
+        double* weight = m_ewmaWeight.row(i);
+        const double* dj = d + i;
+        const double* mj = m + i;
+        const double a = alpha * d[i];
+        const size_t len = m_n - i;
+        for (size_t k = 0; k < len; ++k) {
+            row[k] += mj[k] * (lambda * (row[k] + a * dj[k]) - row[k]);
+            weight[k] += mj[k] * (lambda * (weight[k] + alpha) - weight[k]);
+        }
+    }
+}
+
+void CovarianceEngine::updateRolling(const double* x) {
+    const size_t window = m_settings.window;
+    double* slot = &m_ring[m_ringHead * m_n];
+    bool evict = m_observations >= window;
+
+    splitObservations(x, m_n, m_value.data(), m_mask.data());
+    if (evict) {
+        splitObservations(slot, m_n, m_evictValue.data(), m_evictMask.data());
+    }
+
+    // 秩2更新：加入新观测，窗口满时同时移出最旧观测；缺测项取值与掩码均为0，自然不计入
+    const double* xv = m_value.data();
+    const double* xm = m_mask.data();
+    const double* yv = m_evictValue.data();
+    const double* ym = m_evictMask.data();
+    for (size_t i = 0; i < m_n; ++i) {
+        double* cross = m_cross.row(i);
+        double* count = m_pairCount.row(i);
+        double* sumRow = m_pairSumRow.row(i);
+        double* sumCol = m_pairSumCol.row(i);
+        const size_t len = m_n - i;
+        const double* xvj = xv + i;
+        const double* xmj = xm + i;
+        const double xvi = xv[i];
+        const double xmi = xm[i];
+        if (evict) {
+            const double* yvj = yv + i;
+            const double* ymj = ym + i;
+            const double yvi = yv[i];
+            const double ymi = ym[i];
+            for (size_t k = 0; k < len; ++k) {
+                cross[k] += xvi * xvj[k] - yvi * yvj[k];
+                count[k] += xmi * xmj[k] - ymi * ymj[k];
+                sumRow[k] += xvi * xmj[k] - yvi * ymj[k];
+                sumCol[k] += xmi * xvj[k] - ymi * yvj[k];
+            }
+        } else {
+            for (size_t k = 0; k < len; ++k) {
+                cross[k] += xvi * xvj[k];
+                count[k] += xmi * xmj[k];
+                sumRow[k] += xvi * xmj[k];
+                sumCol[k] += xmi * xvj[k];
+            }
+        }
+    }
+
+    std::copy_n(x, m_n, slot);
+    m_ringHead = (m_ringHead + 1) % window;
+}
+
+void CovarianceEngine::publish() {
+    auto snap = std::make_shared<CovarianceSnapshot>();
+    snap->version = ++m_version;
+    snap->observations = m_observations;
+    snap->codes = m_codes;
+    snap->matrix = PackedSymmetric(m_n);
+
+    // 打包存储各矩阵布局相同，按元素逐一换算（行尾对齐填充处的权重/期数为0）
+    std::vector<double>& out = snap->matrix.data();
+    if (m_settings.method == CovarianceMethod::Ewma) {
+        // Σ = C / W：按各对实际累计的权重归一，缺测多或新纳入的代码不被低估
+        const std::vector<double>& c = m_ewma.data();
+        const std::vector<double>& w = m_ewmaWeight.data();
+        for (size_t k = 0; k < out.size(); ++k) {
+            out[k] = w[k] > 0.0 ? c[k] / w[k] : 0.0;
+        }
+    } else {
+        // Σ = (Σxy - Σx·Σy/n) / (n - 1)，n为该对在窗口内的共同观测期数
+        const std::vector<double>& cross = m_cross.data();
+        const std::vector<double>& count = m_pairCount.data();
+        const std::vector<double>& sumRow = m_pairSumRow.data();
+        const std::vector<double>& sumCol = m_pairSumCol.data();
+        for (size_t k = 0; k < out.size(); ++k) {
+            const double n = std::round(count[k]);
+            out[k] = n >= 2.0 ? (cross[k] - sumRow[k] * sumCol[k] / n) / (n - 1.0) : 0.0;
+        }
+    }
+
+    applyShrinkage(snap->matrix);
+    m_snapshot.store(std::move(snap), std::memory_order_release);
+}
+
+void CovarianceEngine::applyShrinkage(PackedSymmetric& m) const {
+    const double delta = m_settings.intensity;
+    if (m_settings.shrinkage == ShrinkageTarget::None || delta <= 0.0 || m_n == 0) {
+        return;
+    }
+
+    if (m_settings.shrinkage == ShrinkageTarget::ScaledIdentity) {
+        // Σ' = (1-δ)Σ + δ·(tr(Σ)/n)·I
+        double trace = 0.0;
+        for (size_t i = 0; i < m_n; ++i) {
+            trace += m.row(i)[0];
+        }
+        double target = trace / static_cast<double>(m_n);
+        for (size_t i = 0; i < m_n; ++i) {
+            double* row = m.row(i);
+            const size_t len = m_n - i;
+            for (size_t k = 0; k < len; ++k) {
+                row[k] *= 1.0 - delta;
+            }
+            row[0] += delta * target;
+        }
+        return;
+    }
+
+    // 常相关目标：F_ij = ρ̄·σ_i·σ_j，对角保持不变
+    std::vector<double> vol(m_n);
+    for (size_t i = 0; i < m_n; ++i) {
+        vol[i] = std::sqrt(std::max(0.0, m.row(i)[0]));
+    }
+
+    double corrSum = 0.0;
+    size_t pairs = 0;
+    for (size_t i = 0; i < m_n; ++i) {
+        const double* row = m.row(i);
+        for (size_t k = 1; k < m_n - i; ++k) {
+            double denom = vol[i] * vol[i + k];
+            if (denom > 0.0) {
+                corrSum += row[k] / denom;
+                ++pairs;
+            }
+        }
+    }
+    if (pairs == 0) {
+        return;
+    }
+    double avgCorr = corrSum / static_cast<double>(pairs);
+
+    for (size_t i = 0; i < m_n; ++i) {
+        double* row = m.row(i);
+        const double* vj = vol.data() + i;
+        const double target = avgCorr * vol[i];
+        const size_t len = m_n - i;
+        for (size_t k = 1; k < len; ++k) {
+            row[k] = (1.0 - delta) * row[k] + delta * target * vj[k];
+        }
+    }
+}
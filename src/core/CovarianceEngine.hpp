@@ -0,0 +1,142 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+class IndexHistory;
+
+using json = nlohmann::json;
+
+// 协方差估计方法
+enum class CovarianceMethod {
+    Ewma,       // 指数加权
+    Rolling     // 滚动窗口样本协方差
+};
+
+// 收缩目标
+enum class ShrinkageTarget {
+    None,
+    ScaledIdentity,         // 平均方差 × 单位阵
+    ConstantCorrelation     // 平均相关系数的常相关矩阵
+};
+
+struct CovarianceSettings {
+    CovarianceMethod method = CovarianceMethod::Ewma;
+    double lambda = 0.94;       // EWMA衰减因子
+    size_t window = 250;        // 滚动窗口期数
+    ShrinkageTarget shrinkage = ShrinkageTarget::None;
+    double intensity = 0.0;     // 收缩强度（0-1）
+
+    // 从规则配置的 "covariance" 节解析
+    static CovarianceSettings fromRules(const json& rules);
+};
+
+// 打包上三角存储：第i行保存列i..n-1，行长按4个double对齐便于向量化
+class PackedSymmetric {
+public:
+    PackedSymmetric() = default;
+    explicit PackedSymmetric(size_t n);
+
+    size_t size() const { return m_n; }
+    double* row(size_t i) { return &m_data[m_offset[i]]; }
+    const double* row(size_t i) const { return &m_data[m_offset[i]]; }
+
+    double at(size_t i, size_t j) const {
+        return i <= j ? m_data[m_offset[i] + (j - i)] : m_data[m_offset[j] + (i - j)];
+    }
+
+    std::vector<double>& data() { return m_data; }
+    const std::vector<double>& data() const { return m_data; }
+
+private:
+    size_t m_n = 0;
+    std::vector<size_t> m_offset;
+    std::vector<double> m_data;
+};
+
+// 只读协方差快照（发布后不再修改，可跨线程共享）
+struct CovarianceSnapshot {
+    uint64_t version = 0;
+    size_t observations = 0;
+    std::shared_ptr<const std::vector<std::string>> codes;
+    PackedSymmetric matrix;
+
+    // 按给定代码顺序展开为稠密n×n行主序矩阵（未知代码对应行列为0）
+    std::vector<double> dense(const std::vector<std::string>& subset) const;
+};
+
+// 增量协方差引擎：每期一次秩1（EWMA）或秩2（滚动窗口）更新，O(N²)而非O(T·N²)
+// 缺测（NaN）按对跳过：每个元素只由两者均有观测的期估计，并按该对的有效权重/期数归一
+// update()与addCodes()须由单一写线程调用；snapshot()可被任意线程并发读取
+class CovarianceEngine {
+public:
+    CovarianceEngine(std::vector<std::string> codes, CovarianceSettings settings = {});
+
+    // 追加一期收益（按codes()顺序，NaN表示该期缺测），并发布新快照
+    void update(const double* returns);
+
+    // 追加指数历史第t期收益（按代码映射列；当期或上期不在样本中、历史中没有的代码均为缺测）
+    void update(const IndexHistory& history, size_t t);
+
+    // 追加新代码（已有代码忽略），保留已有代码的估计状态；新代码在有观测前协方差为0
+    void addCodes(const std::vector<std::string>& codes);
+
+    // 当前快照
+    std::shared_ptr<const CovarianceSnapshot> snapshot() const {
+        return m_snapshot.load(std::memory_order_acquire);
+    }
+
+    // 代码所在序号（不存在返回-1）
+    int indexOf(const std::string& code) const;
+
+    size_t size() const { return m_n; }
+    const std::vector<std::string>& codes() const { return *m_codes; }
+
+private:
+    void updateEwma(const double* x);
+    void updateRolling(const double* x);
+    void publish();
+
+    // 分配n个代码的估计状态，已有状态按原序号保留
+    void resize(size_t n);
+
+    // 对快照矩阵应用收缩
+    void applyShrinkage(PackedSymmetric& m) const;
+
+    size_t m_n;
+    CovarianceSettings m_settings;
+    std::shared_ptr<const std::vector<std::string>> m_codes;
+    std::unordered_map<std::string, int> m_index;
+    uint64_t m_version = 0;
+    size_t m_observations = 0;
+
+    // 按历史列映射的收益暂存
+    std::vector<double> m_scratch;
+
+    // 本期观测拆为取值（缺测记0）与掩码（有观测为1），对内层循环无分支
+    std::vector<double> m_value;
+    std::vector<double> m_mask;
+
+    // EWMA状态：加权均值（首个观测作初值）、协方差及各对累计权重
+    std::vector<double> m_mean;
+    std::vector<char> m_seen;
+    std::vector<double> m_delta;
+    PackedSymmetric m_ewma;
+    PackedSymmetric m_ewmaWeight;
+
+    // 滚动窗口状态：环形缓冲（缺测为NaN），各对的共同观测期数、叉积和及双方一阶和
+    std::vector<double> m_ring;
+    size_t m_ringHead = 0;
+    std::vector<double> m_evictValue;
+    std::vector<double> m_evictMask;
+    PackedSymmetric m_cross;
+    PackedSymmetric m_pairCount;
+    PackedSymmetric m_pairSumRow;
+    PackedSymmetric m_pairSumCol;
+
+    std::atomic<std::shared_ptr<const CovarianceSnapshot>> m_snapshot;
+};
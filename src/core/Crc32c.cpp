@@ -0,0 +1,121 @@
+﻿#include "Crc32c.hpp"
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CRC32C_X86 1
+#include <nmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CRC32C_TARGET
+#else
+#include <cpuid.h>
+#define CRC32C_TARGET __attribute__((target("sse4.2")))
+#endif
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define CRC32C_ARM 1
+#include <arm_acle.h>
+#endif
+
+namespace {
+    constexpr uint32_t kPolynomial = 0x82F63B78;  // 反射形式
+
+    // slicing-by-8查表：table[k][b]为字节b后接k个零字节的余数
+    constexpr std::array<std::array<uint32_t, 256>, 8> makeTables() {
+        std::array<std::array<uint32_t, 256>, 8> table{};
+        for (uint32_t b = 0; b < 256; ++b) {
+            uint32_t crc = b;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ (kPolynomial & (0u - (crc & 1)));
+            }
+            table[0][b] = crc;
+        }
+        for (uint32_t b = 0; b < 256; ++b) {
+            for (size_t k = 1; k < 8; ++k) {
+                table[k][b] = (table[k - 1][b] >> 8) ^ table[0][table[k - 1][b] & 0xFF];
+            }
+        }
+        return table;
+    }
+    constexpr auto kTables = makeTables();
+
+    uint32_t crc32cSoftware(const unsigned char* p, size_t size, uint32_t crc) {
+        for (; size >= 8; p += 8, size -= 8) {
+            uint32_t lo, hi;
+            std::memcpy(&lo, p, 4);
+            std::memcpy(&hi, p + 4, 4);
+            lo ^= crc;
+            crc = kTables[7][lo & 0xFF] ^ kTables[6][(lo >> 8) & 0xFF] ^
+                  kTables[5][(lo >> 16) & 0xFF] ^ kTables[4][lo >> 24] ^
+                  kTables[3][hi & 0xFF] ^ kTables[2][(hi >> 8) & 0xFF] ^
+                  kTables[1][(hi >> 16) & 0xFF] ^ kTables[0][hi >> 24];
+        }
+        for (; size > 0; ++p, --size) {
+            crc = (crc >> 8) ^ kTables[0][(crc ^ *p) & 0xFF];
+        }
+        return crc;
+    }
+
+#if defined(CRC32C_X86)
+    CRC32C_TARGET uint32_t crc32cHardwareImpl(const unsigned char* p, size_t size, uint32_t crc) {
+        uint64_t c = crc;
+        for (; size >= 8; p += 8, size -= 8) {
+            uint64_t v;
+            std::memcpy(&v, p, 8);
+            c = _mm_crc32_u64(c, v);
+        }
+        uint32_t c32 = static_cast<uint32_t>(c);
+        for (; size > 0; ++p, --size) {
+            c32 = _mm_crc32_u8(c32, *p);
+        }
+        return c32;
+    }
+
+    bool detectHardware() {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 20)) != 0;
+#else
+        unsigned eax, ebx, ecx, edx;
+        return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSE4_2) != 0;
+#endif
+    }
+#elif defined(CRC32C_ARM)
+    uint32_t crc32cHardwareImpl(const unsigned char* p, size_t size, uint32_t crc) {
+        for (; size >= 8; p += 8, size -= 8) {
+            uint64_t v;
+            std::memcpy(&v, p, 8);
+            crc = __crc32cd(crc, v);
+        }
+        for (; size > 0; ++p, --size) {
+            crc = __crc32cb(crc, *p);
+        }
+        return crc;
+    }
+
+    bool detectHardware() { return true; }
+#endif
+
+    using Crc32cFn = uint32_t (*)(const unsigned char*, size_t, uint32_t);
+
+    // 启动时按CPU能力选定实现
+    Crc32cFn selectImpl() {
+#if defined(CRC32C_X86) || defined(CRC32C_ARM)
+        if (detectHardware()) {
+            return crc32cHardwareImpl;
+        }
+#endif
+        return crc32cSoftware;
+    }
+
+    const Crc32cFn g_impl = selectImpl();
+}
+
+uint32_t crc32c(const void* data, size_t size, uint32_t crc) {
+    return ~g_impl(static_cast<const unsigned char*>(data), size, ~crc);
+}
+
+bool crc32cHardware() {
+    return g_impl != crc32cSoftware;
+}
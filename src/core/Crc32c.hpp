@@ -0,0 +1,11 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// CRC32C（Castagnoli多项式，与iSCSI/ext4等一致）
+// x86-64支持SSE4.2、ARM64支持CRC扩展时使用硬件指令，否则退回查表（slicing-by-8）
+// crc为此前数据的结果，可分段续算：crc32c(b, crc32c(a)) == crc32c(a + b)
+uint32_t crc32c(const void* data, size_t size, uint32_t crc = 0);
+
+// 当前进程是否使用硬件CRC指令
+bool crc32cHardware();
@@ -0,0 +1,59 @@
+﻿#include "FileSync.hpp"
+#include <filesystem>
+#include <stdexcept>
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+bool syncFile(std::FILE* file) {
+    if (std::fflush(file) != 0) {
+        return false;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+bool syncDirectory(const std::string& path) {
+#ifdef _WIN32
+    (void)path;
+    return true;
+#else
+    int fd = ::open(path.empty() ? "." : path.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#endif
+}
+
+void replaceFile(const std::string& tmp, const std::string& target) {
+#ifdef _WIN32
+    // 写穿模式的重命名在返回前落盘，无需再同步目录
+    if (!MoveFileExA(tmp.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        throw std::runtime_error("重命名文件失败: " + tmp + " -> " + target);
+    }
+#else
+    fs::rename(tmp, target);
+    // 重命名只改变目录项，须fsync所在目录，否则掉电后可能回到旧文件
+    if (!syncDirectory(fs::path(target).parent_path().string())) {
+        throw std::runtime_error("同步目录失败: " + target);
+    }
+#endif
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <cstdio>
+#include <string>
+
+// 将已写出的数据落到磁盘（fflush后fsync/_commit），返回是否成功
+bool syncFile(std::FILE* file);
+
+// 将目录项的变更（新建、重命名、删除）落到磁盘，返回是否成功（Windows上无需也无法单独同步目录）
+bool syncDirectory(const std::string& path);
+
+// 以已落盘的临时文件原子替换目标文件，重命名本身也落盘后返回（失败抛出异常，临时文件由调用方清理）
+// POSIX上重命名后fsync所在目录，Windows上以写穿模式重命名
+void replaceFile(const std::string& tmp, const std::string& target);
@@ -1,8 +1,11 @@
 ﻿#include "IndexCalculator.hpp"
+#include "core/FileSync.hpp"
+#include "data/SymbolTable.hpp"
 #include <fstream>
 #include <algorithm>
 #include <numeric>
 #include <cmath>
+#include <cstdio>
 
 void IndexCalculator::loadRules(const std::string& configFile) {
     std::ifstream file(configFile);
@@ -59,6 +62,33 @@ std::vector<Component> IndexCalculator::calculateComponents(
     return components;
 }
 
+std::vector<UniverseRank> IndexCalculator::rankUniverse(const REITList& reits) const {
+    Screening rules = screening();
+    std::vector<UniverseRank> ranks(reits.size());
+    for (size_t i = 0; i < reits.size(); ++i) {
+        ranks[i].index = i;
+        ranks[i].score = calculateScore(reits[i]);
+        ranks[i].eligible = rules.passes(reits[i]);
+    }
+    
+    std::sort(ranks.begin(), ranks.end(),
+        [](const UniverseRank& a, const UniverseRank& b) {
+            if (a.eligible != b.eligible) {
+                return a.eligible;
+            }
+            return a.score != b.score ? a.score > b.score : a.index < b.index;
+        });
+    
+    uint32_t rank = 0;
+    for (auto& r : ranks) {
+        if (!r.eligible) {
+            break;
+        }
+        r.rank = ++rank;
+    }
+    return ranks;
+}
+
 double IndexCalculator::calculateIndexValue(
     const std::vector<Component>& components) const {
     
@@ -74,23 +104,192 @@ double IndexCalculator::calculateIndexValue(
     return base_value * (1 + ((total_value - base_value) / base_value));
 }
 
-std::vector<REIT> IndexCalculator::filterREITs(const REITList& reits) const {
-    std::vector<REIT> result;
+WeightingScheme IndexCalculator::weightingScheme() const {
+    return WeightOptimizer::parseScheme(
+        m_rules["weighting"].value("scheme", std::string("heuristic")));
+}
+
+void IndexCalculator::applyOptimizedWeights(std::vector<Component>& components,
+                                            const std::vector<double>& covariance) const {
+    WeightingScheme scheme = weightingScheme();
+    if (scheme == WeightingScheme::Heuristic || components.empty()) {
+        return;
+    }
+    
+    // 复用规则中的单只与行业上限
+    WeightConstraints constraints;
+    constraints.single_max = m_rules["constraints"]["single_position_max"].get<double>();
+    
+    SymbolTable sectors;
+    for (const auto& constraint : m_rules["constraints"]["sector_limits"].items()) {
+        uint32_t id = sectors.intern(constraint.key());
+        constraints.group_max.resize(id + 1);
+        constraints.group_max[id] = constraint.value().get<double>();
+    }
+    for (const auto& comp : components) {
+        constraints.group.push_back(sectors.intern(comp.reit.sector));
+    }
+    
+    OptimizerSettings settings;
+    json optimizer = m_rules["weighting"].value("optimizer", json::object());
+    settings.max_iterations = optimizer.value("max_iterations", settings.max_iterations);
+    settings.tolerance = optimizer.value("tolerance", settings.tolerance);
+    settings.time_budget_ms = optimizer.value("time_budget_ms", settings.time_budget_ms);
+    
+    WeightOptimizer solver(std::move(constraints), settings);
+    OptimizerResult result = solver.optimize(scheme, covariance);
+    
+    for (size_t i = 0; i < components.size(); ++i) {
+        components[i].weight = result.weights[i];
+    }
+    
+    std::stable_sort(components.begin(), components.end(),
+        [](const Component& a, const Component& b) {
+            return a.weight > b.weight;
+        });
+}
+
+IndexLevels IndexCalculator::calculateIndexLevels(
+    const std::vector<Component>& components, const REITList& universe, int date) {
+    
+    // 首次计算以基点初始化三条指数
+    if (m_lastBasis.empty()) {
+        double base_value = m_rules["base_value"].get<double>();
+        m_levels = {base_value, base_value, base_value};
+    } else {
+        double tax_rate = m_rules.value("total_return", json::object())
+                                 .value("dividend_tax_rate", 0.0);
+        
+        // 当前行情：本期成分优先，调出的成分取全市场数据
+        std::unordered_map<std::string, const REIT*> current;
+        for (const auto& reit : universe) {
+            current[reit.code] = &reit;
+        }
+        for (const auto& comp : components) {
+            current[comp.reit.code] = &comp.reit;
+        }
+        
+        // 按上一计算日的成分与权重单次遍历，同时累计价格收益、全收益与净收益
+        // 新纳入成分自下一期起计入收益
+        double price_ret = 0.0;
+        double gross_ret = 0.0;
+        double net_ret = 0.0;
+        double covered = 0.0;
+        for (const auto& [code, basis] : m_lastBasis) {
+            auto it = current.find(code);
+            if (it == current.end() || basis.market_cap <= 0.0 ||
+                !(it->second->market_cap > 0.0)) {
+                continue; // 无当期行情，剔除后按其余成分归一
+            }
+            
+            const REIT& reit = *it->second;
+            double prev_cap = basis.market_cap;
+            double w = basis.weight;
+            double r = reit.market_cap / prev_cap - 1.0;
+            
+            // 除息日落在(上一计算日, 当前计算日]内时按前收市值再投资分红
+            double d = 0.0;
+            if (reit.ex_dividend_date > m_lastLevelDate && reit.ex_dividend_date <= date) {
+                d = reit.dividend_amt / prev_cap;
+            }
+            
+            price_ret += w * r;
+            gross_ret += w * (r + d);
+            net_ret += w * (r + d * (1.0 - tax_rate));
+            covered += w;
+        }
+        
+        if (covered > 0.0) {
+            m_levels.price *= 1.0 + price_ret / covered;
+            m_levels.total_return *= 1.0 + gross_ret / covered;
+            m_levels.net_total_return *= 1.0 + net_ret / covered;
+        }
+    }
+    
+    m_lastBasis.clear();
+    for (const auto& comp : components) {
+        m_lastBasis[comp.reit.code] = {comp.reit.market_cap, comp.weight};
+    }
+    m_lastLevelDate = date;
+    
+    return m_levels;
+}
+
+void IndexCalculator::saveLevelState(const std::string& filename) const {
+    json state;
+    state["date"] = m_lastLevelDate;
+    state["price"] = m_levels.price;
+    state["total_return"] = m_levels.total_return;
+    state["net_total_return"] = m_levels.net_total_return;
+    state["basis"] = json::array();
+    for (const auto& [code, basis] : m_lastBasis) {
+        state["basis"].push_back({
+            {"code", code}, {"market_cap", basis.market_cap}, {"weight", basis.weight}
+        });
+    }
+    const std::string text = state.dump(2);
     
+    // 写入同目录临时文件，fsync后原子替换
+    const std::string tmp = filename + ".tmp";
+    std::FILE* file = std::fopen(tmp.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error("无法创建点位状态文件: " + tmp);
+    }
+    bool ok = std::fwrite(text.data(), 1, text.size(), file) == text.size() && syncFile(file);
+    ok = std::fclose(file) == 0 && ok;
+    try {
+        if (!ok) {
+            throw std::runtime_error("写入点位状态文件失败: " + tmp);
+        }
+        replaceFile(tmp, filename);
+    } catch (...) {
+        std::remove(tmp.c_str());
+        throw;
+    }
+}
+
+void IndexCalculator::loadLevelState(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("无法打开点位状态文件: " + filename);
+    }
+    
+    try {
+        json state = json::parse(file);
+        IndexLevels levels{state.at("price").get<double>(),
+                           state.at("total_return").get<double>(),
+                           state.at("net_total_return").get<double>()};
+        std::unordered_map<std::string, LevelBasis> basis;
+        for (const auto& item : state.at("basis")) {
+            basis[item.at("code").get<std::string>()] = {
+                item.at("market_cap").get<double>(), item.at("weight").get<double>()
+            };
+        }
+        m_levels = levels;
+        m_lastLevelDate = state.at("date").get<int>();
+        m_lastBasis = std::move(basis);
+    } catch (const json::exception& e) {
+        throw std::runtime_error("点位状态文件格式错误: " + filename + " (" + e.what() + ")");
+    }
+}
+
+IndexCalculator::Screening IndexCalculator::screening() const {
     // 获取规则阈值
-    double min_market_cap = m_rules["screening"]["min_market_cap"].get<double>();
-    double min_dividend_yield = m_rules["screening"]["min_dividend_yield"].get<double>();
-    double min_occupancy = m_rules["screening"]["min_occupancy_rate"].get<double>();
-    double max_debt_ratio = m_rules["screening"]["max_debt_ratio"].get<double>();
+    return {
+        m_rules["screening"]["min_market_cap"].get<double>(),
+        m_rules["screening"]["min_dividend_yield"].get<double>(),
+        m_rules["screening"]["min_occupancy_rate"].get<double>(),
+        m_rules["screening"]["max_debt_ratio"].get<double>()
+    };
+}
+
+std::vector<REIT> IndexCalculator::filterREITs(const REITList& reits) const {
+    std::vector<REIT> result;
+    Screening rules = screening();
     
     // 过滤REITs
     std::copy_if(reits.begin(), reits.end(), std::back_inserter(result),
-        [=](const REIT& r) {
-            return r.market_cap >= min_market_cap &&
-                   (r.dividend_amt / r.market_cap) >= min_dividend_yield &&
-                   r.occupancy_rate >= min_occupancy &&
-                   r.debt_ratio <= max_debt_ratio;
-        });
+        [&](const REIT& r) { return rules.passes(r); });
     
     return result;
 }
@@ -1,8 +1,10 @@
 #pragma once
+#include <memory>
 #include <vector>
 #include <unordered_map>
 #include <nlohmann/json.hpp>
 #include "data/DataLoader.hpp"
+#include "core/WeightOptimizer.hpp"
 
 using json = nlohmann::json;
 
@@ -11,18 +13,74 @@ struct Component {
     double weight;
 };
 
+// 不可变成分快照（跨线程共享，免复制）
+using ComponentSnapshot = std::shared_ptr<const std::vector<Component>>;
+
+// 指数点位（价格/全收益/净收益）
+struct IndexLevels {
+    double price = 0.0;             // 价格指数
+    double total_return = 0.0;      // 全收益指数（分红按除息日再投资）
+    double net_total_return = 0.0;  // 净收益指数（分红扣税后再投资）
+};
+
+// 全市场排名条目
+struct UniverseRank {
+    size_t index = 0;       // 在输入列表中的序号
+    double score = 0.0;     // 规则得分
+    uint32_t rank = 0;      // 合格标的按得分的名次（自1起，未通过筛选为0）
+    bool eligible = false;  // 是否通过筛选
+};
+
 class IndexCalculator {
 public:
     // 加载指数规则
     void loadRules(const std::string& configFile);
     
+    // 获取规则配置
+    const json& getRules() const { return m_rules; }
+    
     // 计算指数成分
     std::vector<Component> calculateComponents(const REITList& reits) const;
     
+    // 全市场排名：合格标的按得分降序在前，未通过筛选的按得分降序在后
+    std::vector<UniverseRank> rankUniverse(const REITList& reits) const;
+    
     // 获取指数值
     double calculateIndexValue(const std::vector<Component>& components) const;
     
+    // 规则配置的权重方案
+    WeightingScheme weightingScheme() const;
+    
+    // 按规则配置的优化方案重新分配成分权重（covariance为成分顺序的n×n协方差矩阵）
+    void applyOptimizedWeights(std::vector<Component>& components,
+                               const std::vector<double>& covariance) const;
+    
+    // 链式计算价格、全收益、净收益指数（date为YYYYMMDD）
+    // 收益按上一计算日的成分与权重累计：调出的成分取universe中的当前市值，无行情的成分剔除后按其余权重归一
+    IndexLevels calculateIndexLevels(const std::vector<Component>& components,
+                                     const REITList& universe, int date);
+    
+    // 保存/恢复点位链接状态（三条点位、上一计算日及各成分市值与权重），重启后接续而非回到基点
+    void saveLevelState(const std::string& filename) const;
+    void loadLevelState(const std::string& filename);
+    
 private:
+    // 筛选阈值
+    struct Screening {
+        double min_market_cap;
+        double min_dividend_yield;
+        double min_occupancy;
+        double max_debt_ratio;
+        
+        bool passes(const REIT& r) const {
+            return r.market_cap >= min_market_cap &&
+                   (r.dividend_amt / r.market_cap) >= min_dividend_yield &&
+                   r.occupancy_rate >= min_occupancy &&
+                   r.debt_ratio <= max_debt_ratio;
+        }
+    };
+    Screening screening() const;
+    
     // 筛选合格REITs
     std::vector<REIT> filterREITs(const REITList& reits) const;
     
@@ -35,6 +93,15 @@ private:
     // 规则配置
     json m_rules;
     
+    // 指数点位链接状态（上一计算日的成分市值与权重）
+    struct LevelBasis {
+        double market_cap;
+        double weight;
+    };
+    IndexLevels m_levels;
+    int m_lastLevelDate = 0;
+    std::unordered_map<std::string, LevelBasis> m_lastBasis;
+    
     // 区域权重映射
     const std::unordered_map<std::string, double> REGION_FACTORS = {
         {"长三角", 1.2}, {"珠三角", 1.2}, 
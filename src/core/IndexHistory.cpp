@@ -0,0 +1,265 @@
+﻿#include "IndexHistory.hpp"
+#include "FileSync.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+void IndexHistory::loadFromCSV(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("无法打开历史文件: " + filename);
+    }
+
+    // 跳过标题行
+    std::string line;
+    std::getline(file, line);
+
+    while (std::getline(file, line)) {
+        if (line.empty() || line == "\r") {
+            continue;
+        }
+
+        std::istringstream iss(line);
+        std::string field, code, name, sector, region;
+
+        std::getline(iss, field, ',');
+        int date = std::stoi(field);
+        std::getline(iss, code, ',');
+        std::getline(iss, name, ',');
+        std::getline(iss, sector, ',');
+        std::getline(iss, region, ',');
+
+        double values[7];
+        for (double& v : values) {
+            std::getline(iss, field, ',');
+            v = std::stod(field);
+        }
+
+        if (m_dates.empty() || date > m_dates.back()) {
+            appendPeriod(date);
+        } else if (date < m_dates.back()) {
+            throw std::runtime_error("历史文件日期未按升序排列: " + filename);
+        }
+
+        size_t i = ensureColumn(code, name, sector, region);
+        size_t at = (m_dates.size() - 1) * m_stride + i;
+        m_marketCap[at] = values[0];
+        m_dividend[at] = values[1];
+        m_occupancy[at] = values[2];
+        m_debt[at] = values[3];
+        m_weight[at] = values[4];
+        m_benchmark[at] = values[5];
+        m_return[at] = values[6];
+    }
+}
+
+void IndexHistory::saveToCSV(const std::string& filename) const {
+    // 写入同目录临时文件，fsync后重命名覆盖，写出中途崩溃时原历史文件保持完整
+    const std::string tmp = filename + ".tmp";
+    std::FILE* csv = std::fopen(tmp.c_str(), "w");
+    if (!csv) {
+        throw std::runtime_error("无法创建历史文件: " + tmp);
+    }
+
+    std::fputs("date,code,name,sector,region,market_cap,dividend_amt,occupancy_rate,"
+               "debt_ratio,weight,benchmark_weight,return\n", csv);
+
+    for (size_t t = 0; t < m_dates.size(); ++t) {
+        for (size_t i = 0; i < m_codes.size(); ++i) {
+            size_t at = t * m_stride + i;
+            if (m_marketCap[at] <= 0.0) {
+                continue; // 当期不在样本中
+            }
+            std::fprintf(csv, "%d,%s,%s,%s,%s,%.17g,%.17g,%.17g,%.17g,%.17g,%.17g,%.17g\n",
+                         m_dates[t],
+                         m_codes[i].c_str(),
+                         m_names[i].c_str(),
+                         m_sectors.name(m_sectorIds[i]).c_str(),
+                         m_regions.name(m_regionIds[i]).c_str(),
+                         m_marketCap[at],
+                         m_dividend[at],
+                         m_occupancy[at],
+                         m_debt[at],
+                         m_weight[at],
+                         m_benchmark[at],
+                         m_return[at]);
+        }
+    }
+
+    bool ok = !std::ferror(csv) && syncFile(csv);
+    ok = std::fclose(csv) == 0 && ok;
+    try {
+        if (!ok) {
+            throw std::runtime_error("写入历史文件失败: " + tmp);
+        }
+        replaceFile(tmp, filename);
+    } catch (...) {
+        std::remove(tmp.c_str());
+        throw;
+    }
+}
+
+bool IndexHistory::recordSnapshot(int date, const REITList& universe,
+                                  const std::vector<Component>& components) {
+    if (!m_dates.empty() && date < m_dates.back()) {
+        throw std::runtime_error("历史快照日期早于最新记录: " + std::to_string(date));
+    }
+
+    for (const auto& reit : universe) {
+        ensureColumn(reit.code, reit.name, reit.sector, reit.region);
+    }
+
+    bool appended = m_dates.empty() || date > m_dates.back();
+    if (appended) {
+        appendPeriod(date);
+    }
+
+    size_t t = m_dates.size() - 1;
+    size_t row = t * m_stride;
+    std::fill_n(&m_weight[row], m_stride, 0.0);
+    std::fill_n(&m_benchmark[row], m_stride, 0.0);
+    std::fill_n(&m_return[row], m_stride, 0.0);
+    std::fill_n(&m_marketCap[row], m_stride, 0.0);
+
+    // 基准：全样本市值加权
+    double total_cap = 0.0;
+    for (const auto& reit : universe) {
+        total_cap += reit.market_cap;
+    }
+
+    int prev_date = t > 0 ? m_dates[t - 1] : 0;
+    for (const auto& reit : universe) {
+        size_t at = row + m_columnIndex.at(reit.code);
+        m_marketCap[at] = reit.market_cap;
+        m_dividend[at] = reit.dividend_amt;
+        m_occupancy[at] = reit.occupancy_rate;
+        m_debt[at] = reit.debt_ratio;
+        m_benchmark[at] = total_cap > 0.0 ? reit.market_cap / total_cap : 0.0;
+
+        // 本期收益 = 价格收益 + 除息日落在本期内的分红收益
+        if (t > 0) {
+            double prev_cap = m_marketCap[at - m_stride];
+            if (prev_cap > 0.0) {
+                double r = reit.market_cap / prev_cap - 1.0;
+                if (reit.ex_dividend_date > prev_date && reit.ex_dividend_date <= date) {
+                    r += reit.dividend_amt / prev_cap;
+                }
+                m_return[at] = r;
+            }
+        }
+    }
+
+    for (const auto& comp : components) {
+        auto it = m_columnIndex.find(comp.reit.code);
+        if (it != m_columnIndex.end()) {
+            m_weight[row + it->second] = comp.weight;
+        }
+    }
+
+    return appended;
+}
+
+size_t IndexHistory::upperBound(int date) const {
+    return std::upper_bound(m_dates.begin(), m_dates.end(), date) - m_dates.begin();
+}
+
+REIT IndexHistory::reitAt(size_t t, size_t i) const {
+    size_t row = t * m_stride;
+    REIT reit;
+    reit.code = m_codes[i];
+    reit.name = m_names[i];
+    reit.sector = m_sectors.name(m_sectorIds[i]);
+    reit.region = m_regions.name(m_regionIds[i]);
+    reit.market_cap = m_marketCap[row + i];
+    reit.dividend_amt = m_dividend[row + i];
+    reit.occupancy_rate = m_occupancy[row + i];
+    reit.debt_ratio = m_debt[row + i];
+    return reit;
+}
+
+std::vector<Component> IndexHistory::componentsAt(size_t t) const {
+    std::vector<Component> components;
+    size_t row = t * m_stride;
+
+    for (size_t i = 0; i < m_codes.size(); ++i) {
+        if (m_weight[row + i] <= 0.0) {
+            continue;
+        }
+        components.push_back({reitAt(t, i), m_weight[row + i]});
+    }
+
+    // 与指数计算输出保持一致的权重降序
+    std::stable_sort(components.begin(), components.end(),
+        [](const Component& a, const Component& b) {
+            return a.weight > b.weight;
+        });
+
+    return components;
+}
+
+std::vector<Component> IndexHistory::componentsAt(size_t t, const uint32_t* columns,
+                                                  const double* weights, size_t count) const {
+    std::vector<Component> components;
+    components.reserve(count);
+    size_t row = t * m_stride;
+
+    for (size_t k = 0; k < count; ++k) {
+        size_t i = columns[k];
+        if (i >= m_codes.size() || m_marketCap[row + i] <= 0.0) {
+            continue; // 当期不在样本中
+        }
+        components.push_back({reitAt(t, i), weights[k]});
+    }
+
+    std::stable_sort(components.begin(), components.end(),
+        [](const Component& a, const Component& b) {
+            return a.weight > b.weight;
+        });
+
+    return components;
+}
+
+size_t IndexHistory::ensureColumn(const std::string& code, const std::string& name,
+                                  const std::string& sector, const std::string& region) {
+    auto it = m_columnIndex.find(code);
+    if (it != m_columnIndex.end()) {
+        return it->second;
+    }
+
+    size_t i = m_codes.size();
+    if (i >= m_stride) {
+        reserveColumns(std::max<size_t>(64, m_stride * 2));
+    }
+
+    m_codes.push_back(code);
+    m_names.push_back(name);
+    m_sectorIds.push_back(m_sectors.intern(sector));
+    m_regionIds.push_back(m_regions.intern(region));
+    m_columnIndex.emplace(code, i);
+    return i;
+}
+
+void IndexHistory::appendPeriod(int date) {
+    m_dates.push_back(date);
+    size_t cells = m_dates.size() * m_stride;
+    for (auto* column : {&m_weight, &m_benchmark, &m_return, &m_marketCap,
+                         &m_dividend, &m_occupancy, &m_debt}) {
+        column->resize(cells, 0.0);
+    }
+}
+
+void IndexHistory::reserveColumns(size_t columns) {
+    size_t periods = m_dates.size();
+    for (auto* column : {&m_weight, &m_benchmark, &m_return, &m_marketCap,
+                         &m_dividend, &m_occupancy, &m_debt}) {
+        std::vector<double> widened(periods * columns, 0.0);
+        for (size_t t = 0; t < periods; ++t) {
+            std::copy_n(column->data() + t * m_stride, m_codes.size(),
+                        widened.data() + t * columns);
+        }
+        column->swap(widened);
+    }
+    m_stride = columns;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include "core/IndexCalculator.hpp"
+#include "data/SymbolTable.hpp"
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// 指数历史：按期列式存储全市场REIT快照、指数权重与基准权重
+// 第t期数据以行主序存放于 [t * stride(), t * stride() + constituentCount())
+class IndexHistory {
+public:
+    // 从CSV加载历史（按日期升序）
+    void loadFromCSV(const std::string& filename);
+
+    // 保存历史到CSV（写入临时文件并fsync后原子替换，崩溃时不损坏原文件）
+    void saveToCSV(const std::string& filename) const;
+
+    // 记录一期快照（同日重复记录覆盖当日数据），返回是否新增一期
+    bool recordSnapshot(int date, const REITList& universe,
+                        const std::vector<Component>& components);
+
+    size_t periodCount() const { return m_dates.size(); }
+    size_t constituentCount() const { return m_codes.size(); }
+    size_t stride() const { return m_stride; }
+    const std::vector<int>& dates() const { return m_dates; }
+
+    // 首个日期大于date的期序号
+    size_t upperBound(int date) const;
+
+    // 第t期期末数据
+    const double* weights(size_t t) const { return &m_weight[t * m_stride]; }
+    const double* benchmarkWeights(size_t t) const { return &m_benchmark[t * m_stride]; }
+    const double* returns(size_t t) const { return &m_return[t * m_stride]; }
+    const double* marketCaps(size_t t) const { return &m_marketCap[t * m_stride]; }
+    const double* dividends(size_t t) const { return &m_dividend[t * m_stride]; }
+    const double* occupancyRates(size_t t) const { return &m_occupancy[t * m_stride]; }
+    const double* debtRatios(size_t t) const { return &m_debt[t * m_stride]; }
+
+    // 代码所在列（不存在返回-1）
+    int columnOf(const std::string& code) const {
+        auto it = m_columnIndex.find(code);
+        return it != m_columnIndex.end() ? static_cast<int>(it->second) : -1;
+    }
+
+    // 成分静态属性
+    const std::string& code(size_t i) const { return m_codes[i]; }
+    const std::string& name(size_t i) const { return m_names[i]; }
+    uint32_t sectorId(size_t i) const { return m_sectorIds[i]; }
+    uint32_t regionId(size_t i) const { return m_regionIds[i]; }
+    const std::vector<uint32_t>& sectorIds() const { return m_sectorIds; }
+    const std::vector<uint32_t>& regionIds() const { return m_regionIds; }
+    const SymbolTable& sectors() const { return m_sectors; }
+    const SymbolTable& regions() const { return m_regions; }
+
+    // 还原第t期指数成分（权重>0）
+    std::vector<Component> componentsAt(size_t t) const;
+    
+    // 还原第t期指定列的成分，权重取调用方给定值（如基金持仓权重），当期不在样本中的列略去
+    std::vector<Component> componentsAt(size_t t, const uint32_t* columns, const double* weights,
+                                        size_t count) const;
+
+private:
+    // 第t期第i列的REIT快照
+    REIT reitAt(size_t t, size_t i) const;
+    
+    // 获取代码所在列（不存在则新增）
+    size_t ensureColumn(const std::string& code, const std::string& name,
+                        const std::string& sector, const std::string& region);
+
+    // 新增一期（各列置零）
+    void appendPeriod(int date);
+
+    // 扩展列容量并重排已有数据
+    void reserveColumns(size_t columns);
+
+    std::vector<int> m_dates;
+
+    // 列属性
+    std::vector<std::string> m_codes;
+    std::vector<std::string> m_names;
+    std::vector<uint32_t> m_sectorIds;
+    std::vector<uint32_t> m_regionIds;
+    std::unordered_map<std::string, size_t> m_columnIndex;
+    SymbolTable m_sectors;
+    SymbolTable m_regions;
+
+    // 期 × 列数据
+    size_t m_stride = 0;
+    std::vector<double> m_weight;
+    std::vector<double> m_benchmark;
+    std::vector<double> m_return;
+    std::vector<double> m_marketCap;
+    std::vector<double> m_dividend;
+    std::vector<double> m_occupancy;
+    std::vector<double> m_debt;
+};
@@ -0,0 +1,128 @@
+﻿#include "LinearAlgebra.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace linalg {
+
+double dot(const double* a, const double* b, size_t n) {
+    // 四路累加，打破依赖链便于向量化
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    for (; i < n; ++i) {
+        s0 += a[i] * b[i];
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+void gemv(const double* A, const double* x, double* y, size_t n) {
+    const size_t colBlock = BLOCK * 4;
+
+    std::fill_n(y, n, 0.0);
+    for (size_t jb = 0; jb < n; jb += colBlock) {
+        size_t width = std::min(colBlock, n - jb);
+        const double* xb = x + jb;
+
+        // 每次处理4行，共享同一x块
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            const double* a0 = A + i * n + jb;
+            const double* a1 = a0 + n;
+            const double* a2 = a1 + n;
+            const double* a3 = a2 + n;
+            double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+            for (size_t j = 0; j < width; ++j) {
+                double xj = xb[j];
+                s0 += a0[j] * xj;
+                s1 += a1[j] * xj;
+                s2 += a2[j] * xj;
+                s3 += a3[j] * xj;
+            }
+            y[i] += s0;
+            y[i + 1] += s1;
+            y[i + 2] += s2;
+            y[i + 3] += s3;
+        }
+        for (; i < n; ++i) {
+            y[i] += dot(A + i * n + jb, xb, width);
+        }
+    }
+}
+
+void gram(const double* X, size_t rows, size_t cols, double* C) {
+    const size_t rowBlock = BLOCK * 4;
+
+    std::fill_n(C, cols * cols, 0.0);
+
+    // 仅计算上三角块，内层沿列连续访问以便向量化
+    for (size_t jb = 0; jb < cols; jb += BLOCK) {
+        size_t jEnd = std::min(jb + BLOCK, cols);
+        for (size_t kb = jb; kb < cols; kb += BLOCK) {
+            size_t kEnd = std::min(kb + BLOCK, cols);
+            for (size_t rb = 0; rb < rows; rb += rowBlock) {
+                size_t rEnd = std::min(rb + rowBlock, rows);
+                for (size_t r = rb; r < rEnd; ++r) {
+                    const double* xr = X + r * cols;
+                    for (size_t j = jb; j < jEnd; ++j) {
+                        double xj = xr[j];
+                        double* cj = C + j * cols;
+                        for (size_t k = std::max(kb, j); k < kEnd; ++k) {
+                            cj[k] += xj * xr[k];
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // 镜像下三角
+    for (size_t j = 0; j < cols; ++j) {
+        for (size_t k = j + 1; k < cols; ++k) {
+            C[k * cols + j] = C[j * cols + k];
+        }
+    }
+}
+
+bool cholesky(double* A, size_t n) {
+    for (size_t j = 0; j < n; ++j) {
+        double diag = A[j * n + j] - dot(A + j * n, A + j * n, j);
+        if (diag <= 0.0) {
+            return false;
+        }
+        diag = std::sqrt(diag);
+        A[j * n + j] = diag;
+        for (size_t i = j + 1; i < n; ++i) {
+            A[i * n + j] = (A[i * n + j] - dot(A + i * n, A + j * n, j)) / diag;
+        }
+        std::fill(A + j * n + j + 1, A + (j + 1) * n, 0.0);
+    }
+    return true;
+}
+
+bool choleskySolve(double* A, double* b, size_t n) {
+    if (!cholesky(A, n)) {
+        return false;
+    }
+
+    // 前代 L·y = b
+    for (size_t i = 0; i < n; ++i) {
+        b[i] = (b[i] - dot(A + i * n, b, i)) / A[i * n + i];
+    }
+
+    // 回代 Lᵀ·x = y
+    for (size_t i = n; i-- > 0;) {
+        double s = b[i];
+        for (size_t k = i + 1; k < n; ++k) {
+            s -= A[k * n + i] * b[k];
+        }
+        b[i] = s / A[i * n + i];
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+
+// 分块稠密线性代数内核（行主序，双精度）
+namespace linalg {
+    // 分块边长：64×64双精度块为32KB，可驻留L1/L2
+    constexpr size_t BLOCK = 64;
+
+    // 向量点积
+    double dot(const double* a, const double* b, size_t n);
+
+    // y = A·x，A为n×n行主序矩阵；按列块遍历使x块常驻缓存
+    void gemv(const double* A, const double* x, double* y, size_t n);
+
+    // C = XᵀX，X为rows×cols行主序矩阵，C为cols×cols（完整对称填充）
+    void gram(const double* X, size_t rows, size_t cols, double* C);
+
+    // 对称正定矩阵的Cholesky分解A = L·Lᵀ（L覆盖下三角，上三角置0），非正定返回false
+    bool cholesky(double* A, size_t n);
+
+    // 对称正定方程组A·x = b的Cholesky求解（A被分解覆盖，b被解覆盖），非正定返回false
+    bool choleskySolve(double* A, double* b, size_t n);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// 只读内存映射文件：Windows为文件映射对象，其余平台为mmap；页面按需换入，不占用用户态缓冲
+// 映射期间文件可被删除（Windows以共享删除方式打开），最后一个引用释放后由系统回收
+class MappedFile {
+public:
+    // 映射整个文件（失败抛出异常），空文件映射为空区间
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    std::string_view view(size_t offset, size_t size) const { return {m_data + offset, size}; }
+
+private:
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void* m_file = nullptr;         // HANDLE
+    void* m_mapping = nullptr;      // HANDLE
+#endif
+};
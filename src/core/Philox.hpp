@@ -0,0 +1,82 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// Philox4x32-10 计数器型随机数发生器（Salmon et al., 2011）
+// 输出仅由(计数器, 密钥)决定：按场景编号构造计数器即可在任意线程数下复现同一序列
+class Philox4x32 {
+public:
+    using Counter = std::array<uint32_t, 4>;
+    using Key = std::array<uint32_t, 2>;
+
+    static Key makeKey(uint64_t seed) {
+        return {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)};
+    }
+
+    // 10轮变换，返回4个32位随机字
+    static Counter generate(Counter ctr, Key key) {
+        for (int round = 0; round < 10; ++round) {
+            uint64_t p0 = static_cast<uint64_t>(M0) * ctr[0];
+            uint64_t p1 = static_cast<uint64_t>(M1) * ctr[2];
+            ctr = {static_cast<uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0], static_cast<uint32_t>(p1),
+                   static_cast<uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1], static_cast<uint32_t>(p0)};
+            key[0] += W0;
+            key[1] += W1;
+        }
+        return ctr;
+    }
+
+    // 批量生成Lanes个计数器（第0字依次为base[0] + l）的输出，按字分列存放
+    // 各lane在轮内相互独立，循环可被编译器向量化；结果与逐个generate一致
+    template <size_t Lanes>
+    static void generateBlock(const Counter& base, Key key, uint32_t (&out)[4][Lanes]) {
+        uint32_t* c0 = out[0];
+        uint32_t* c1 = out[1];
+        uint32_t* c2 = out[2];
+        uint32_t* c3 = out[3];
+        for (size_t l = 0; l < Lanes; ++l) {
+            c0[l] = base[0] + static_cast<uint32_t>(l);
+            c1[l] = base[1];
+            c2[l] = base[2];
+            c3[l] = base[3];
+        }
+        for (int round = 0; round < 10; ++round) {
+            for (size_t l = 0; l < Lanes; ++l) {
+                uint64_t p0 = static_cast<uint64_t>(M0) * c0[l];
+                uint64_t p1 = static_cast<uint64_t>(M1) * c2[l];
+                uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1[l] ^ key[0];
+                uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3[l] ^ key[1];
+                c1[l] = static_cast<uint32_t>(p1);
+                c3[l] = static_cast<uint32_t>(p0);
+                c0[l] = n0;
+                c2[l] = n2;
+            }
+            key[0] += W0;
+            key[1] += W1;
+        }
+    }
+
+    // 两个32位字拼成53位精度的(0, 1)均匀数
+    static double uniform53(uint32_t hi, uint32_t lo) {
+        uint64_t bits = ((static_cast<uint64_t>(hi) << 32) | lo) >> 11;
+        return (static_cast<double>(bits) + 0.5) * 0x1.0p-53;
+    }
+
+    // Box-Muller：一次生成输出两个独立标准正态数
+    static void normalPair(const Counter& bits, double& z0, double& z1) {
+        double u1 = uniform53(bits[0], bits[1]);
+        double u2 = uniform53(bits[2], bits[3]);
+        double r = std::sqrt(-2.0 * std::log(u1));
+        double theta = 6.283185307179586 * u2;
+        z0 = r * std::cos(theta);
+        z1 = r * std::sin(theta);
+    }
+
+private:
+    static constexpr uint32_t M0 = 0xD2511F53u;
+    static constexpr uint32_t M1 = 0xCD9E8D57u;
+    static constexpr uint32_t W0 = 0x9E3779B9u;
+    static constexpr uint32_t W1 = 0xBB67AE85u;
+};
@@ -0,0 +1,112 @@
+﻿#include "ThreadPool.hpp"
+#include <algorithm>
+
+namespace {
+    // 当前线程是否为线程池工作线程（用于嵌套调用时串行执行）
+    thread_local bool t_inPool = false;
+}
+
+ThreadPool::ThreadPool(size_t threads) {
+    size_t workers = threads > 1 ? threads - 1 : 0;
+    m_workers.reserve(workers);
+    for (size_t i = 0; i < workers; ++i) {
+        m_workers.emplace_back(&ThreadPool::workerLoop, this, i + 1);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (auto& t : m_workers) {
+        if (t.joinable()) {
+            t.join();
+        }
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::parallelFor(size_t begin, size_t end, size_t grain,
+                             const RangeTask& task) {
+    if (begin >= end) {
+        return;
+    }
+    grain = std::max<size_t>(grain, 1);
+
+    // 区间过小、无工作线程或嵌套调用时直接串行执行
+    if (m_workers.empty() || t_inPool || end - begin <= grain) {
+        task(begin, end, 0);
+        return;
+    }
+
+    std::lock_guard submit(m_submitMutex);
+    auto batch = std::make_shared<Batch>();
+    batch->task = &task;
+    batch->begin = begin;
+    batch->end = end;
+    batch->grain = grain;
+    batch->chunks = (end - begin + grain - 1) / grain;
+
+    {
+        std::lock_guard lock(m_mutex);
+        m_batch = batch;
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    t_inPool = true;
+    runChunks(*batch, 0);
+    t_inPool = false;
+
+    std::unique_lock lock(m_mutex);
+    m_finished.wait(lock, [&] {
+        return batch->done.load(std::memory_order_acquire) == batch->chunks;
+    });
+    m_batch.reset();
+}
+
+void ThreadPool::runChunks(Batch& batch, size_t worker) {
+    while (true) {
+        size_t chunk = batch.next.fetch_add(1, std::memory_order_relaxed);
+        if (chunk >= batch.chunks) {
+            return;
+        }
+
+        size_t lo = batch.begin + chunk * batch.grain;
+        size_t hi = std::min(batch.end, lo + batch.grain);
+        (*batch.task)(lo, hi, worker);
+
+        if (batch.done.fetch_add(1, std::memory_order_acq_rel) + 1 == batch.chunks) {
+            std::lock_guard lock(m_mutex);
+            m_finished.notify_all();
+        }
+    }
+}
+
+void ThreadPool::workerLoop(size_t worker) {
+    t_inPool = true;
+    uint64_t seen = 0;
+
+    while (true) {
+        std::shared_ptr<Batch> batch;
+        {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stopping || m_generation != seen; });
+            if (m_stopping) {
+                return;
+            }
+            seen = m_generation;
+            batch = m_batch;
+        }
+
+        if (batch) {
+            runChunks(*batch, worker);
+        }
+    }
+}
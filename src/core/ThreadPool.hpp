@@ -0,0 +1,53 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 固定大小线程池，提供按块动态调度的并行循环
+class ThreadPool {
+public:
+    // 分块任务：处理区间[begin, end)，worker为执行线程编号（0为调用线程）
+    using RangeTask = std::function<void(size_t begin, size_t end, size_t worker)>;
+
+    explicit ThreadPool(size_t threads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // 并行执行[begin, end)，按grain切块，调用线程同时参与，返回时全部完成（任务不得抛出异常）
+    void parallelFor(size_t begin, size_t end, size_t grain, const RangeTask& task);
+
+    // 参与计算的线程数（含调用线程）
+    size_t size() const { return m_workers.size() + 1; }
+
+    // 进程级共享线程池
+    static ThreadPool& shared();
+
+private:
+    struct Batch {
+        const RangeTask* task;
+        size_t begin;
+        size_t end;
+        size_t grain;
+        size_t chunks;
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+    };
+
+    void workerLoop(size_t worker);
+    void runChunks(Batch& batch, size_t worker);
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::mutex m_submitMutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_finished;
+    std::shared_ptr<Batch> m_batch;
+    uint64_t m_generation = 0;
+    bool m_stopping = false;
+};
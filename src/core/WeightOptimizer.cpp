@@ -0,0 +1,265 @@
+﻿#include "WeightOptimizer.hpp"
+#include "LinearAlgebra.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+    const double UNBOUNDED = std::numeric_limits<double>::infinity();
+    const size_t BISECTION_STEPS = 100;
+}
+
+WeightOptimizer::WeightOptimizer(WeightConstraints constraints, OptimizerSettings settings)
+    : m_constraints(std::move(constraints)), m_settings(settings) {
+
+    m_n = m_constraints.group.size();
+
+    // 未配置上限的分组视为无上限
+    uint32_t groups = 0;
+    for (uint32_t g : m_constraints.group) {
+        groups = std::max(groups, g + 1);
+    }
+    if (m_constraints.group_max.size() < groups) {
+        m_constraints.group_max.resize(groups, UNBOUNDED);
+    }
+    groups = static_cast<uint32_t>(m_constraints.group_max.size());
+
+    // 按分组计数排序，投影时逐组连续访问
+    m_groupBegin.assign(groups + 1, 0);
+    for (uint32_t g : m_constraints.group) {
+        ++m_groupBegin[g + 1];
+    }
+    for (uint32_t g = 0; g < groups; ++g) {
+        m_groupBegin[g + 1] += m_groupBegin[g];
+    }
+    m_order.resize(m_n);
+    std::vector<size_t> cursor(m_groupBegin.begin(), m_groupBegin.end() - 1);
+    for (size_t i = 0; i < m_n; ++i) {
+        m_order[cursor[m_constraints.group[i]]++] = i;
+    }
+
+    // 可行性：各组可容纳的最大权重之和须不低于100%
+    double capacity = 0.0;
+    for (uint32_t g = 0; g < groups; ++g) {
+        double members = static_cast<double>(m_groupBegin[g + 1] - m_groupBegin[g]);
+        capacity += std::min(members * m_constraints.single_max, m_constraints.group_max[g]);
+    }
+    if (m_n > 0 && capacity < 1.0 - 1e-12) {
+        throw std::runtime_error("权重约束不可行: 单只与行业上限合计仅 " +
+                                 std::to_string(capacity * 100) + "%");
+    }
+}
+
+WeightingScheme WeightOptimizer::parseScheme(const std::string& name) {
+    if (name == "min_variance") {
+        return WeightingScheme::MinimumVariance;
+    }
+    if (name == "risk_parity") {
+        return WeightingScheme::RiskParity;
+    }
+    if (name == "max_diversification") {
+        return WeightingScheme::MaximumDiversification;
+    }
+    if (name.empty() || name == "heuristic") {
+        return WeightingScheme::Heuristic;
+    }
+    throw std::runtime_error("未知的权重方案: " + name);
+}
+
+void WeightOptimizer::project(const double* y, double* w, double lower) const {
+    const double upper = m_constraints.single_max;
+    const size_t groups = m_constraints.group_max.size();
+
+    auto clip = [&](double v) {
+        return std::min(upper, std::max(lower, v));
+    };
+    auto groupSum = [&](size_t g, double shift) {
+        double s = 0.0;
+        for (size_t p = m_groupBegin[g]; p < m_groupBegin[g + 1]; ++p) {
+            s += clip(y[m_order[p]] - shift);
+        }
+        return s;
+    };
+
+    double yMin = UNBOUNDED, yMax = -UNBOUNDED;
+    for (size_t i = 0; i < m_n; ++i) {
+        yMin = std::min(yMin, y[i]);
+        yMax = std::max(yMax, y[i]);
+    }
+
+    // 外层二分：求λ使 Σ_g min(S_g(λ), 上限_g) = 1
+    double lo = yMin - upper - 1.0;
+    double hi = yMax - lower + 1.0;
+    for (size_t step = 0; step < BISECTION_STEPS && hi - lo > 1e-15; ++step) {
+        double lambda = 0.5 * (lo + hi);
+        double total = 0.0;
+        for (size_t g = 0; g < groups; ++g) {
+            total += std::min(groupSum(g, lambda), m_constraints.group_max[g]);
+        }
+        (total > 1.0 ? lo : hi) = lambda;
+    }
+    double lambda = 0.5 * (lo + hi);
+
+    // 内层二分：超限分组追加平移μ_g使组和恰为上限
+    for (size_t g = 0; g < groups; ++g) {
+        double cap = m_constraints.group_max[g];
+        double shift = lambda;
+        if (groupSum(g, lambda) > cap) {
+            double mLo = 0.0;
+            double mHi = yMax - lambda - lower + 1.0;
+            for (size_t step = 0; step < BISECTION_STEPS && mHi - mLo > 1e-15; ++step) {
+                double mu = 0.5 * (mLo + mHi);
+                (groupSum(g, lambda + mu) > cap ? mLo : mHi) = mu;
+            }
+            shift = lambda + 0.5 * (mLo + mHi);
+        }
+        for (size_t p = m_groupBegin[g]; p < m_groupBegin[g + 1]; ++p) {
+            size_t i = m_order[p];
+            w[i] = clip(y[i] - shift);
+        }
+    }
+}
+
+double WeightOptimizer::evaluate(WeightingScheme scheme, const double* w, const double* sw,
+                                 const double* vol, double rpScale, double* grad) const {
+    double variance = linalg::dot(w, sw, m_n);
+
+    switch (scheme) {
+    case WeightingScheme::RiskParity: {
+        // min ½wᵀΣw - c·Σ(1/n)·ln w，c取当前组合方差时驻点即为等风险贡献
+        double budget = rpScale / static_cast<double>(m_n);
+        double logSum = 0.0;
+        for (size_t i = 0; i < m_n; ++i) {
+            logSum += std::log(w[i]);
+            grad[i] = sw[i] - budget / w[i];
+        }
+        return 0.5 * variance - budget * logSum;
+    }
+    case WeightingScheme::MaximumDiversification: {
+        // min -ln(wᵀσ) + ½ln(wᵀΣw)，即最大化分散化比率
+        double weightedVol = linalg::dot(w, vol, m_n);
+        if (variance <= 0.0 || weightedVol <= 0.0) {
+            return UNBOUNDED;
+        }
+        for (size_t i = 0; i < m_n; ++i) {
+            grad[i] = sw[i] / variance - vol[i] / weightedVol;
+        }
+        return 0.5 * std::log(variance) - std::log(weightedVol);
+    }
+    default:
+        std::copy_n(sw, m_n, grad);
+        return 0.5 * variance;
+    }
+}
+
+OptimizerResult WeightOptimizer::optimize(WeightingScheme scheme,
+                                          const std::vector<double>& covariance) const {
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+
+    OptimizerResult result;
+    const size_t n = m_n;
+    if (n == 0) {
+        return result;
+    }
+    if (covariance.size() != n * n) {
+        throw std::runtime_error("协方差矩阵维度与候选数量不匹配");
+    }
+
+    const double* cov = covariance.data();
+    const double lower = scheme == WeightingScheme::RiskParity ? 1e-8 : 0.0;
+
+    std::vector<double> vol(n);
+    double trace = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        vol[i] = std::sqrt(std::max(0.0, cov[i * n + i]));
+        trace += std::max(0.0, cov[i * n + i]);
+    }
+
+    std::vector<double> w(n, 1.0 / n), wn(n), y(n);
+    std::vector<double> sw(n), swn(n), g(n), gn(n);
+    project(std::vector<double>(w).data(), w.data(), lower);
+
+    // 无风险信息时退化为约束下的等权
+    if (trace <= 0.0) {
+        result.converged = true;
+        result.weights = std::move(w);
+        return result;
+    }
+
+    linalg::gemv(cov, w.data(), sw.data(), n);
+    double rpScale = linalg::dot(w.data(), sw.data(), n);
+    double f = evaluate(scheme, w.data(), sw.data(), vol.data(), rpScale, g.data());
+
+    // 方差类目标的Lipschitz常数不超过迹，以其倒数作初始步长
+    double step = 1.0 / std::max(trace, 1e-12);
+
+    for (result.iterations = 0; result.iterations < m_settings.max_iterations;
+         ++result.iterations) {
+        double fn = UNBOUNDED;
+        double maxMove = 0.0;
+
+        // Armijo回溯
+        for (int tries = 0; tries < 50; ++tries) {
+            for (size_t i = 0; i < n; ++i) {
+                y[i] = w[i] - step * g[i];
+            }
+            project(y.data(), wn.data(), lower);
+
+            double decrease = 0.0;
+            maxMove = 0.0;
+            for (size_t i = 0; i < n; ++i) {
+                double d = wn[i] - w[i];
+                decrease += g[i] * d;
+                maxMove = std::max(maxMove, std::fabs(d));
+            }
+            if (maxMove < m_settings.tolerance) {
+                break;
+            }
+
+            linalg::gemv(cov, wn.data(), swn.data(), n);
+            fn = evaluate(scheme, wn.data(), swn.data(), vol.data(), rpScale, gn.data());
+            if (fn <= f + 1e-4 * decrease) {
+                break;
+            }
+            step *= 0.5;
+        }
+
+        if (maxMove < m_settings.tolerance) {
+            result.converged = true;
+            break;
+        }
+
+        // Barzilai-Borwein步长
+        double ss = 0.0, sy = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            double s = wn[i] - w[i];
+            ss += s * s;
+            sy += s * (gn[i] - g[i]);
+        }
+        step = sy > 0.0 ? ss / sy : step * 2.0;
+        step = std::clamp(step, 1e-20, 1e20);
+
+        w.swap(wn);
+        sw.swap(swn);
+        g.swap(gn);
+        f = fn;
+
+        // 风险平价：更新对数项系数并重算当前点目标
+        if (scheme == WeightingScheme::RiskParity) {
+            rpScale = linalg::dot(w.data(), sw.data(), n);
+            f = evaluate(scheme, w.data(), sw.data(), vol.data(), rpScale, g.data());
+        }
+
+        std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+        if (elapsed.count() > m_settings.time_budget_ms) {
+            break;
+        }
+    }
+
+    result.objective = f;
+    result.weights = std::move(w);
+    return result;
+}
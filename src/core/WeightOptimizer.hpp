@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 权重方案
+enum class WeightingScheme {
+    Heuristic,              // 股息/市值打分（默认）
+    MinimumVariance,        // 最小方差
+    RiskParity,             // 风险平价（等风险贡献）
+    MaximumDiversification  // 最大分散化
+};
+
+// 权重约束：单只上限与分组（行业）上限
+struct WeightConstraints {
+    double single_max = 1.0;
+    std::vector<uint32_t> group;    // 各候选所属分组ID
+    std::vector<double> group_max;  // 各分组权重上限（按分组ID索引，无上限填大于1的值）
+};
+
+// 求解参数
+struct OptimizerSettings {
+    size_t max_iterations = 5000;
+    double tolerance = 1e-10;       // 相邻迭代权重最大变化的收敛阈值
+    double time_budget_ms = 200.0;  // 单次求解时间预算
+};
+
+struct OptimizerResult {
+    std::vector<double> weights;
+    size_t iterations = 0;
+    double objective = 0.0;
+    bool converged = false;
+};
+
+// 基于投影梯度法（BB步长 + Armijo回溯）的约束权重优化器
+class WeightOptimizer {
+public:
+    WeightOptimizer(WeightConstraints constraints, OptimizerSettings settings = {});
+
+    // 求解权重，covariance为n×n行主序协方差矩阵（n = constraints.group.size()）
+    OptimizerResult optimize(WeightingScheme scheme, const std::vector<double>& covariance) const;
+
+    // 欧氏投影到 {lower ≤ w ≤ single_max, Σw = 1, 分组和 ≤ group_max}
+    void project(const double* y, double* w, double lower = 0.0) const;
+
+    // 解析规则中的方案名称
+    static WeightingScheme parseScheme(const std::string& name);
+
+private:
+    // 由w与Σw计算目标函数值与梯度（vol为各候选波动率，rpScale为风险平价对数项系数）
+    double evaluate(WeightingScheme scheme, const double* w, const double* sw,
+                    const double* vol, double rpScale, double* grad) const;
+
+    WeightConstraints m_constraints;
+    OptimizerSettings m_settings;
+    size_t m_n = 0;
+
+    // 按分组重排的候选下标及各组起止位置
+    std::vector<size_t> m_order;
+    std::vector<size_t> m_groupBegin;
+};
@@ -0,0 +1,123 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// XXH64 流式哈希（非加密，用于内容去重），结果与参考实现一致
+class XxHash64 {
+public:
+    explicit XxHash64(uint64_t seed = 0) { reset(seed); }
+
+    void reset(uint64_t seed = 0) {
+        m_v[0] = seed + kPrime1 + kPrime2;
+        m_v[1] = seed + kPrime2;
+        m_v[2] = seed;
+        m_v[3] = seed - kPrime1;
+        m_seed = seed;
+        m_total = 0;
+        m_pending = 0;
+    }
+
+    void update(const void* data, size_t size) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        const unsigned char* end = p + size;
+        m_total += size;
+
+        // 先补齐上次不足32字节的残余
+        if (m_pending > 0) {
+            size_t take = kStripe - m_pending < size ? kStripe - m_pending : size;
+            std::memcpy(m_buffer + m_pending, p, take);
+            m_pending += take;
+            p += take;
+            if (m_pending < kStripe) {
+                return;
+            }
+            consumeStripe(m_buffer);
+            m_pending = 0;
+        }
+        for (; end - p >= static_cast<ptrdiff_t>(kStripe); p += kStripe) {
+            consumeStripe(p);
+        }
+        m_pending = static_cast<size_t>(end - p);
+        std::memcpy(m_buffer, p, m_pending);
+    }
+
+    uint64_t digest() const {
+        uint64_t h;
+        if (m_total >= kStripe) {
+            h = rotl(m_v[0], 1) + rotl(m_v[1], 7) + rotl(m_v[2], 12) + rotl(m_v[3], 18);
+            for (uint64_t v : m_v) {
+                h = (h ^ round(0, v)) * kPrime1 + kPrime4;
+            }
+        } else {
+            h = m_seed + kPrime5;
+        }
+        h += m_total;
+
+        const unsigned char* p = m_buffer;
+        const unsigned char* end = m_buffer + m_pending;
+        for (; end - p >= 8; p += 8) {
+            h = rotl(h ^ round(0, read64(p)), 27) * kPrime1 + kPrime4;
+        }
+        if (end - p >= 4) {
+            h = rotl(h ^ (read32(p) * kPrime1), 23) * kPrime2 + kPrime3;
+            p += 4;
+        }
+        for (; p < end; ++p) {
+            h = rotl(h ^ (*p * kPrime5), 11) * kPrime1;
+        }
+
+        h ^= h >> 33;
+        h *= kPrime2;
+        h ^= h >> 29;
+        h *= kPrime3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    static uint64_t hash(const void* data, size_t size, uint64_t seed = 0) {
+        XxHash64 hasher(seed);
+        hasher.update(data, size);
+        return hasher.digest();
+    }
+
+private:
+    static constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+    static constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+    static constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+    static constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+    static constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+    static constexpr size_t kStripe = 32;
+
+    static uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+    static uint64_t round(uint64_t acc, uint64_t input) {
+        acc += input * kPrime2;
+        return rotl(acc, 31) * kPrime1;
+    }
+
+    // 按小端读取（目标平台x86/ARM均为小端）
+    static uint64_t read64(const unsigned char* p) {
+        uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    static uint64_t read32(const unsigned char* p) {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    void consumeStripe(const unsigned char* p) {
+        m_v[0] = round(m_v[0], read64(p));
+        m_v[1] = round(m_v[1], read64(p + 8));
+        m_v[2] = round(m_v[2], read64(p + 16));
+        m_v[3] = round(m_v[3], read64(p + 24));
+    }
+
+    uint64_t m_v[4];
+    uint64_t m_seed;
+    uint64_t m_total;
+    unsigned char m_buffer[kStripe];
+    size_t m_pending;
+};
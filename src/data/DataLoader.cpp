@@ -35,9 +35,14 @@ void DataLoader::loadFromCSV(const std::string& filename) {
         std::getline(iss, field, ',');
         reit.occupancy_rate = std::stod(field);
         
-        std::getline(iss, field);
+        std::getline(iss, field, ',');
         reit.debt_ratio = std::stod(field);
         
+        // 可选列：除息日
+        if (std::getline(iss, field) && !field.empty() && field != "\r") {
+            reit.ex_dividend_date = std::stoi(field);
+        }
+        
         m_data.push_back(reit);
     }
 }
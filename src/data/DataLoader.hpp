@@ -13,6 +13,8 @@ struct REIT {
     double dividend_amt;     // 年度分红金额（元）
     double occupancy_rate;   // 出租率（0.0-1.0）
     double debt_ratio;       // 负债率（0.0-1.0）
+    
+    int ex_dividend_date = 0; // 除息日（YYYYMMDD，0表示无分红事件）
 };
 
 using REITList = std::vector<REIT>;
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// 字符串驻留表：将行业/区域等名称映射为紧凑的整数ID
+class SymbolTable {
+public:
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    // 获取名称ID（不存在则新增）
+    uint32_t intern(const std::string& name) {
+        auto it = m_ids.find(name);
+        if (it != m_ids.end()) {
+            return it->second;
+        }
+        uint32_t id = static_cast<uint32_t>(m_names.size());
+        m_names.push_back(name);
+        m_ids.emplace(name, id);
+        return id;
+    }
+
+    // 查找名称ID（不存在返回npos）
+    uint32_t find(const std::string& name) const {
+        auto it = m_ids.find(name);
+        return it != m_ids.end() ? it->second : npos;
+    }
+
+    const std::string& name(uint32_t id) const { return m_names[id]; }
+    size_t size() const { return m_names.size(); }
+
+private:
+    std::vector<std::string> m_names;
+    std::unordered_map<std::string, uint32_t> m_ids;
+};
@@ -1,17 +1,41 @@
 ﻿#include "core/IndexCalculator.hpp"
+#include "core/IndexHistory.hpp"
+#include "core/AttributionEngine.hpp"
+#include "core/CovarianceEngine.hpp"
 #include "data/DataLoader.hpp"
 #include "risk/RiskEngine.hpp"
+#include "risk/FactorRiskModel.hpp"
+#include "risk/VarEngine.hpp"
+#include "risk/StressTester.hpp"
+#include "risk/PortfolioRiskService.hpp"
+#include "core/ThreadPool.hpp"
 #include "compliance/ComplianceReporter.hpp"
+#include "compliance/ReportQueue.hpp"
+#include "compliance/AuditJournal.hpp"
+#include "compliance/BulkReporter.hpp"
+#include "compliance/ReportStore.hpp"
 #include <iostream>
+#include <atomic>
 #include <chrono>
 #include <thread>
 #include <windows.h>
+#include <psapi.h>
 #include <cstdlib>
+#include <filesystem>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
 
 // Windows服务管理函数
 SERVICE_STATUS g_serviceStatus;
 SERVICE_STATUS_HANDLE g_statusHandle;
 
+// 停止请求（服务停止或控制台Ctrl+C）：主循环在本轮结束后退出并落盘
+std::atomic<bool> g_stopRequested{false};
+
+// 控制台中断处理
+BOOL WINAPI ConsoleCtrlHandler(DWORD ctrlType);
+
 // 服务控制处理器
 VOID WINAPI ServiceCtrlHandler(DWORD dwCtrl);
 
@@ -21,6 +45,54 @@ VOID WINAPI ServiceMain(DWORD argc, LPWSTR* argv);
 // 系统主逻辑
 void runSystem();
 
+// 业绩归因查询
+int runAttribution(int startDate, int endDate, const std::string& level);
+
+// 蒙特卡洛VaR线程扩展性测试
+int runVarScaling();
+
+// 压力测试
+int runStress(const std::string& scenarioFile);
+
+// 跟踪组合批量风险检查
+int runPortfolioRisk(const std::string& holdingsFile);
+
+// JSON报告流式写出与DOM写出的吞吐/峰值内存对比
+int runReportBench(size_t componentCount);
+
+// 导出指数历史（history）或全市场排名（rankings）到CSV
+int runExport(const std::string& kind, const std::string& filename);
+
+// 查询审计日志中某一时刻（本地时间 YYYY-MM-DD HH:MM:SS）发布的计算记录
+int runAuditQuery(const std::string& timeText, const std::string& journalFile);
+
+// 修复中间记录损坏的审计日志（原文件备份后只保留校验通过的记录）
+int runAuditRepair(const std::string& journalFile);
+
+// 按指数历史批量生成区间内各基金（持仓CSV，省略时为指数本身）逐日的报告
+int runBulkReports(int startDate, int endDate, const std::string& fundsFile);
+
+// 列出报告存储中区间内（YYYYMMDD）的报告，format为空时列出全部格式
+int runReportList(int startDate, int endDate, const std::string& formatName);
+
+// 从报告存储取出某日最后一份指定格式的报告写入文件（省略时为原报告文件名）
+int runReportGet(int date, const std::string& formatName, const std::string& filename);
+
+// 指数历史文件
+const char* const HISTORY_FILE = "../data/index_history.csv";
+
+// 指数点位链接状态文件（与历史同时落盘）
+const char* const LEVELS_FILE = "../data/index_levels.json";
+
+// 以成分市值加权构造跟踪组合
+ComponentSnapshot marketCapPortfolio(const std::vector<Component>& components);
+
+// 输出VaR/CVaR
+void printVar(const std::string& label, const VarResult& result);
+
+// 输出报告存储打开时隔离的损坏段
+void printQuarantined(const ReportStore& store);
+
 // Windows服务注册
 bool installService();
 bool uninstallService();
@@ -43,6 +115,40 @@ int main(int argc, char* argv[]) {
         else if (strcmp(argv[i], "--uninstall") == 0) {
             return uninstallService() ? 0 : 1;
         }
+        else if (strcmp(argv[i], "--var-scaling") == 0) {
+            return runVarScaling();
+        }
+        else if (strcmp(argv[i], "--stress") == 0) {
+            return runStress(i + 1 < argc ? argv[i + 1] : "../config/stress_scenarios.json");
+        }
+        else if (strcmp(argv[i], "--portfolios") == 0 && i + 1 < argc) {
+            return runPortfolioRisk(argv[i + 1]);
+        }
+        else if (strcmp(argv[i], "--report-bench") == 0) {
+            return runReportBench(i + 1 < argc ? strtoull(argv[i + 1], nullptr, 10) : 200000);
+        }
+        else if (strcmp(argv[i], "--export") == 0 && i + 2 < argc) {
+            return runExport(argv[i + 1], argv[i + 2]);
+        }
+        else if (strcmp(argv[i], "--audit-at") == 0 && i + 1 < argc) {
+            return runAuditQuery(argv[i + 1], i + 2 < argc ? argv[i + 2] : "");
+        }
+        else if (strcmp(argv[i], "--audit-repair") == 0) {
+            return runAuditRepair(i + 1 < argc ? argv[i + 1] : "");
+        }
+        else if (strcmp(argv[i], "--bulk-reports") == 0 && i + 2 < argc) {
+            return runBulkReports(atoi(argv[i + 1]), atoi(argv[i + 2]), i + 3 < argc ? argv[i + 3] : "");
+        }
+        else if (strcmp(argv[i], "--report-list") == 0 && i + 2 < argc) {
+            return runReportList(atoi(argv[i + 1]), atoi(argv[i + 2]), i + 3 < argc ? argv[i + 3] : "");
+        }
+        else if (strcmp(argv[i], "--report-get") == 0 && i + 2 < argc) {
+            return runReportGet(atoi(argv[i + 1]), argv[i + 2], i + 3 < argc ? argv[i + 3] : "");
+        }
+        else if (strcmp(argv[i], "--attribution") == 0 && i + 2 < argc) {
+            std::string level = i + 3 < argc ? argv[i + 3] : "sector";
+            return runAttribution(atoi(argv[i + 1]), atoi(argv[i + 2]), level);
+        }
     }
     
     if (runAsService) {
@@ -82,6 +188,7 @@ int main(int argc, char* argv[]) {
 void runSystem() {
     try {
         std::cout << "中国REITs 50指数系统启动..." << std::endl;
+        SetConsoleCtrlHandler(ConsoleCtrlHandler, TRUE);
         
         // 初始化组件
         DataLoader loader;
@@ -90,39 +197,232 @@ void runSystem() {
         IndexCalculator calculator;
         calculator.loadRules("../config/reits_index_rule.json");
         
+        IndexHistory history;
+        if (std::ifstream(HISTORY_FILE).good()) {
+            history.loadFromCSV(HISTORY_FILE);
+        }
+        if (std::ifstream(LEVELS_FILE).good()) {
+            calculator.loadLevelState(LEVELS_FILE);
+        }
+        
+        // 协方差引擎仅纳入已完结的期（最新一期当日仍在更新）；历史新增代码时追加到引擎，已有估计保留
+        auto covariance = std::make_unique<CovarianceEngine>(
+            std::vector<std::string>{}, CovarianceSettings::fromRules(calculator.getRules()));
+        size_t covariancePeriods = 1;
+        auto syncCovariance = [&]() {
+            std::vector<std::string> added;
+            for (size_t i = covariance->size(); i < history.constituentCount(); ++i) {
+                added.push_back(history.code(i));
+            }
+            covariance->addCodes(added);
+            for (; covariancePeriods + 1 < history.periodCount(); ++covariancePeriods) {
+                covariance->update(history, covariancePeriods);
+            }
+        };
+        syncCovariance();
+        
+        // 波动率逐期增量更新，同样只纳入已完结的期
+        VolatilityEngine volatility(VolatilitySettings::fromRules(calculator.getRules()));
+        size_t volatilityPeriods = 1;
+        auto syncVolatility = [&]() {
+            for (; volatilityPeriods + 1 < history.periodCount(); ++volatilityPeriods) {
+                volatility.update(history, volatilityPeriods);
+            }
+        };
+        syncVolatility();
+        
         RiskEngine riskEngine;
+        riskEngine.loadLimits(calculator.getRules());
+        riskEngine.updateVolatility(volatility.snapshot());
         riskEngine.setAlertCallback([](const std::string& msg) {
             std::cerr << "[!] " << msg << std::endl;
         });
         riskEngine.startMonitoring();
         
+        const std::string reportPath = "../reports/";
         ComplianceReporter reporter;
-        reporter.setReportPath("../reports/");
+        reporter.setReportPath(reportPath);
+        // 熔断时已排队未写出的报告一并丢弃
+        ReportQueue reportQueue(reporter, ReportQueueSettings::fromRules(calculator.getRules()),
+                                &riskEngine.circuitBreaker());
+        
+        // 以往交易日的报告归入按日期索引的报告存储，早于归档期的月份压缩为月度归档
+        ReportStoreSettings storeSettings = ReportStoreSettings::fromRules(calculator.getRules());
+        std::unique_ptr<ReportStore> reportStore;
+        if (storeSettings.enabled) {
+            try {
+                reportStore = std::make_unique<ReportStore>(storeSettings);
+                printQuarantined(*reportStore);
+            } catch (const std::exception& e) {
+                std::cerr << "报告存储打开失败: " << e.what() << std::endl;
+            }
+        }
+        auto maintainReports = [&](int today) {
+            if (!reportStore) {
+                return;
+            }
+            try {
+                ReportMaintenance done = reportStore->maintain(reportPath, today);
+                if (done.ingested > 0 || done.compaction.months > 0) {
+                    std::cout << "报告存储: 归入 " << done.ingested << " 份"
+                              << ", 归档 " << done.compaction.months << " 个月"
+                              << "(合并 " << done.compaction.segments_merged << " 段, "
+                              << done.compaction.elapsed_ms << "ms)" << std::endl;
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "报告存储维护失败: " << e.what() << std::endl;
+            }
+        };
+        
+        // 每次发布的计算记入只追加审计日志
+        AuditJournalSettings auditSettings = AuditJournalSettings::fromRules(calculator.getRules());
+        std::unique_ptr<AuditJournal> journal;
+        if (auditSettings.enabled) {
+            journal = std::make_unique<AuditJournal>(auditSettings);
+            if (journal->stats().recovered_bytes > 0) {
+                std::cerr << "审计日志截去残缺尾部: " << journal->stats().recovered_bytes
+                          << " 字节" << std::endl;
+            }
+        }
+        const uint64_t rulesHash = AuditJournal::hashRules(calculator.getRules());
+        
+        CircuitBreaker& breaker = riskEngine.circuitBreaker();
+        int sessionDate = 0;
+        uint64_t reportedFailures = 0;
         
         // 主循环
-        while (true) {
+        while (!g_stopRequested.load()) {
+            // 熔断期间暂停行情接入、计算与报告
+            breaker.poll();
+            if (breaker.halted()) {
+                std::this_thread::sleep_for(std::chrono::seconds(1));
+                continue;
+            }
+            
             // 更新数据
             loader.refreshData();
             
             // 计算指数
             auto reits = loader.getCurrentData();
             auto components = calculator.calculateComponents(reits);
-            double indexValue = calculator.calculateIndexValue(components);
+            if (calculator.weightingScheme() != WeightingScheme::Heuristic) {
+                std::vector<std::string> codes;
+                for (const auto& comp : components) {
+                    codes.push_back(comp.reit.code);
+                }
+                calculator.applyOptimizedWeights(components,
+                    covariance->snapshot()->dense(codes));
+            }
+            time_t now = time(nullptr);
+            tm* ltm = localtime(&now);
+            int today = (1900 + ltm->tm_year) * 10000 + (ltm->tm_mon + 1) * 100 + ltm->tm_mday;
+            IndexLevels levels = calculator.calculateIndexLevels(components, reits, today);
+            
+            // 逐笔熔断检查，本笔触发则不再落盘与出报告
+            bool newSession = today != sessionDate;
+            if (newSession) {
+                breaker.startSession();
+                sessionDate = today;
+                
+                // 前一交易日的报告写完后归入报告存储
+                reportQueue.flush();
+                maintainReports(today);
+            }
+            if (riskEngine.onIndexTick(levels.price) != TripReason::None) {
+                continue;
+            }
             
-            // 风险监控
-            riskEngine.performRiskCheck(components);
+            // 记录历史：当日快照每轮在内存中更新，新增一期时连同点位状态落盘（停止时再存当日最终快照），
+            // 新交易日另行重估风险模型
+            bool newPeriod = history.recordSnapshot(today, reits, components);
+            if (newPeriod) {
+                history.saveToCSV(HISTORY_FILE);
+                calculator.saveLevelState(LEVELS_FILE);
+                syncCovariance();
+                syncVolatility();
+                riskEngine.updateVolatility(volatility.snapshot());
+                
+                // 新交易日重估因子模型并输出指数风险分解
+                FactorRiskModel factorModel(history);
+                factorModel.estimate(calculator.getRules()
+                    .value("factor_model", json::object()).value("window", size_t(250)));
+                RiskDecomposition risk = factorModel.decompose(components);
+                std::cout << "指数风险(日方差): " << risk.total_variance
+                          << ", 因子: " << risk.factor_variance
+                          << ", 特异: " << risk.specific_variance << std::endl;
+                
+                // 指数与市值加权跟踪组合的VaR/CVaR
+                VarEngine varEngine(VarSettings::fromRules(calculator.getRules()));
+                printVar("指数(历史模拟)", varEngine.historical(history, components));
+                std::vector<ComponentSnapshot> portfolios = {
+                    std::make_shared<const std::vector<Component>>(components),
+                    marketCapPortfolio(components)
+                };
+                std::vector<VarResult> simulated = varEngine.monteCarlo(
+                    *covariance->snapshot(), portfolios, ThreadPool::shared());
+                printVar("指数(蒙特卡洛)", simulated[0]);
+                printVar("市值加权(蒙特卡洛)", simulated[1]);
+            }
             
-            // 生成报告
-            reporter.generateReport(components);
+            // 记录本次发布的计算（输入版本、规则版本、成分权重与点位）
+            if (journal) {
+                try {
+                    journal->append(today, AuditJournal::hashInputs(reits), rulesHash,
+                                    levels, components);
+                } catch (const std::exception& e) {
+                    std::cerr << "审计日志写入失败: " << e.what() << std::endl;
+                }
+            }
+            
+            // 成分冻结为共享快照，风险监控直接引用
+            ComponentSnapshot snapshot =
+                std::make_shared<const std::vector<Component>>(std::move(components));
+            
+            // 风险监控：开盘以当日成分重建逐笔限额，盘中按最新市值增量更新
+            riskEngine.performRiskCheck(snapshot);
+            if (newSession) {
+                riskEngine.resetTickLimits(snapshot);
+            } else {
+                for (const auto& reit : reits) {
+                    riskEngine.onPriceTick(reit.code, reit.market_cap);
+                }
+            }
+            
+            // 报告交由后台写出线程生成，不阻塞下一轮计算
+            reportQueue.submit(snapshot);
             
             // 打印状态
-            std::cout << "当前指数值: " << indexValue 
-                      << ", 成分股: " << components.size() 
+            ReportQueueMetrics reportMetrics = reportQueue.metrics();
+            ReportWriteStats writeStats = reporter.writeStats();
+            std::cout << "当前指数值: " << levels.price 
+                      << ", 全收益: " << levels.total_return
+                      << ", 净收益: " << levels.net_total_return
+                      << ", 成分股: " << snapshot->size() 
+                      << ", 报告队列: " << reportMetrics.depth
+                      << ", 报告写出(ms): " << reportMetrics.last_write_ms
+                      << ", 落盘/跳过: " << writeStats.written << "/" << writeStats.skipped
+                      << ", 审计序号: " << (journal ? journal->stats().last_sequence : 0)
                       << std::endl;
+            // 报告写出失败只在失败计数变化时输出，同一错误不逐轮重复
+            if (reportMetrics.failed != reportedFailures) {
+                reportedFailures = reportMetrics.failed;
+                std::cerr << "报告写出失败(" << reportMetrics.failed << "): "
+                          << reportMetrics.last_error << std::endl;
+            }
             
-            // 每天更新一次
-            std::this_thread::sleep_for(std::chrono::minutes(1)); // 实际应为86400秒
+            // 每天更新一次（按秒检查停止请求）
+            for (int i = 0; i < 60 && !g_stopRequested.load(); ++i) { // 实际应为86400秒
+                std::this_thread::sleep_for(std::chrono::seconds(1));
+            }
         }
+        
+        // 停止：写完排队的报告，当日最终快照落盘
+        reportQueue.flush();
+        if (history.periodCount() > 0) {
+            history.saveToCSV(HISTORY_FILE);
+            calculator.saveLevelState(LEVELS_FILE);
+        }
+        std::cout << "系统已停止" << std::endl;
     } catch (const std::exception& e) {
         std::cerr << "系统错误: " << e.what() << std::endl;
         int len = MultiByteToWideChar(CP_UTF8, 0, e.what(), -1, NULL, 0);
@@ -132,14 +432,600 @@ void runSystem() {
     }
 }
 
+int runAttribution(int startDate, int endDate, const std::string& level) {
+    try {
+        IndexHistory history;
+        history.loadFromCSV(HISTORY_FILE);
+        
+        AttributionLevel attributionLevel = AttributionLevel::Sector;
+        if (level == "region") {
+            attributionLevel = AttributionLevel::Region;
+        } else if (level == "code") {
+            attributionLevel = AttributionLevel::Constituent;
+        }
+        
+        AttributionEngine engine(history);
+        AttributionResult result = engine.analyze(startDate, endDate, attributionLevel);
+        
+        std::cout << "归因区间: " << result.start_date << " - " << result.end_date
+                  << ", 期数: " << result.periods
+                  << ", 指数收益: " << result.portfolio_return * 100 << "%"
+                  << ", 基准收益: " << result.benchmark_return * 100 << "%" << std::endl;
+        std::cout << "分组,指数权重,基准权重,贡献,配置效应,选择效应,交互效应" << std::endl;
+        for (const auto& g : result.groups) {
+            std::cout << g.name << ","
+                      << g.portfolio_weight << ","
+                      << g.benchmark_weight << ","
+                      << g.contribution << ","
+                      << g.allocation << ","
+                      << g.selection << ","
+                      << g.interaction << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "归因失败: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+ComponentSnapshot marketCapPortfolio(const std::vector<Component>& components) {
+    auto portfolio = std::make_shared<std::vector<Component>>(components);
+    double total = 0.0;
+    for (const auto& comp : *portfolio) {
+        total += comp.reit.market_cap;
+    }
+    for (auto& comp : *portfolio) {
+        comp.weight = total > 0.0 ? comp.reit.market_cap / total : 0.0;
+    }
+    return portfolio;
+}
+
+void printQuarantined(const ReportStore& store) {
+    for (const auto& bad : store.quarantined()) {
+        std::cerr << "报告段损坏已隔离: " << bad.path << " -> "
+                  << (bad.moved_to.empty() ? std::string("(改名失败，已跳过)") : bad.moved_to)
+                  << ", 原因: " << bad.reason << std::endl;
+    }
+}
+
+void printVar(const std::string& label, const VarResult& result) {
+    std::cout << label << " 场景: " << result.scenarios;
+    for (const auto& e : result.estimates) {
+        std::cout << ", VaR" << e.confidence * 100 << "%: " << e.var * 100 << "%"
+                  << ", CVaR: " << e.cvar * 100 << "%";
+    }
+    std::cout << std::endl;
+}
+
+int runVarScaling() {
+    try {
+        DataLoader loader;
+        loader.loadFromCSV("../data/reits_data.csv");
+        
+        IndexCalculator calculator;
+        calculator.loadRules("../config/reits_index_rule.json");
+        auto components = calculator.calculateComponents(loader.getCurrentData());
+        
+        IndexHistory history;
+        history.loadFromCSV(HISTORY_FILE);
+        std::vector<std::string> codes;
+        for (size_t i = 0; i < history.constituentCount(); ++i) {
+            codes.push_back(history.code(i));
+        }
+        CovarianceEngine covariance(std::move(codes),
+                                    CovarianceSettings::fromRules(calculator.getRules()));
+        for (size_t t = 1; t < history.periodCount(); ++t) {
+            covariance.update(history, t);
+        }
+        
+        std::vector<ComponentSnapshot> portfolios = {
+            std::make_shared<const std::vector<Component>>(components),
+            marketCapPortfolio(components)
+        };
+        VarEngine varEngine(VarSettings::fromRules(calculator.getRules()));
+        
+        // 线程数按2的幂递增至硬件并发数，结果应逐位一致
+        std::vector<size_t> threadCounts;
+        size_t hardware = std::thread::hardware_concurrency();
+        if (hardware == 0) {
+            hardware = 1;
+        }
+        for (size_t k = 1; k < hardware; k *= 2) {
+            threadCounts.push_back(k);
+        }
+        threadCounts.push_back(hardware);
+        
+        std::cout << "线程数,耗时(ms),加速比,VaR,CVaR" << std::endl;
+        double baseline = 0.0;
+        for (size_t threads : threadCounts) {
+            ThreadPool pool(threads);
+            VarResult result = varEngine.monteCarlo(*covariance.snapshot(), portfolios, pool)[0];
+            if (baseline == 0.0) {
+                baseline = result.elapsed_ms;
+            }
+            const VarEstimate& tail = result.estimates.back();
+            std::cout << result.threads << ","
+                      << result.elapsed_ms << ","
+                      << baseline / result.elapsed_ms << ","
+                      << tail.var << ","
+                      << tail.cvar << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "VaR测试失败: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int runStress(const std::string& scenarioFile) {
+    try {
+        DataLoader loader;
+        loader.loadFromCSV("../data/reits_data.csv");
+        
+        IndexCalculator calculator;
+        calculator.loadRules("../config/reits_index_rule.json");
+        
+        ComponentSnapshot base = std::make_shared<const std::vector<Component>>(
+            calculator.calculateComponents(loader.getCurrentData()));
+        IndexLevels levels = calculator.calculateIndexLevels(*base, loader.getCurrentData(), 0);
+        
+        StressTester tester(std::make_shared<const RiskLimitTable>(
+            RiskLimitTable::fromRules(calculator.getRules())));
+        std::vector<StressResult> results = tester.run(
+            base, levels, StressScenario::loadFromFile(scenarioFile), ThreadPool::shared());
+        
+        for (const auto& result : results) {
+            std::cout << result.name
+                      << " 指数收益: " << result.index_return * 100 << "%"
+                      << ", 价格指数: " << result.levels.price
+                      << ", 越限: " << result.breaches.size();
+            if (result.unmatched_shocks > 0) {
+                std::cout << ", 未命中冲击: " << result.unmatched_shocks;
+            }
+            std::cout << std::endl;
+            for (const auto& breach : result.breaches) {
+                std::cout << "  " << formatAlert(breach) << std::endl;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "压力测试失败: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int runPortfolioRisk(const std::string& holdingsFile) {
+    try {
+        DataLoader loader;
+        loader.loadFromCSV("../data/reits_data.csv");
+        
+        IndexCalculator calculator;
+        calculator.loadRules("../config/reits_index_rule.json");
+        
+        ComponentSnapshot benchmark = std::make_shared<const std::vector<Component>>(
+            calculator.calculateComponents(loader.getCurrentData()));
+        // 基准外持仓按基准权重0计入，行业/区域取自全市场数据
+        auto book = std::make_shared<PortfolioBook>(benchmark, loader.getCurrentData());
+        book->loadFromCSV(holdingsFile);
+        
+        PortfolioRiskService service(std::make_shared<const RiskLimitTable>(
+            RiskLimitTable::fromRules(calculator.getRules())));
+        service.load(book);
+        
+        // 有指数历史时按协方差检查跟踪误差
+        if (std::ifstream(HISTORY_FILE).good()) {
+            IndexHistory history;
+            history.loadFromCSV(HISTORY_FILE);
+            std::vector<std::string> codes;
+            for (size_t i = 0; i < history.constituentCount(); ++i) {
+                codes.push_back(history.code(i));
+            }
+            CovarianceEngine covariance(std::move(codes),
+                                        CovarianceSettings::fromRules(calculator.getRules()));
+            for (size_t t = 1; t < history.periodCount(); ++t) {
+                covariance.update(history, t);
+            }
+            service.setCovariance(*covariance.snapshot(),
+                VolatilitySettings::fromRules(calculator.getRules()).periods_per_year);
+        }
+        
+        const PortfolioBreachBatch& breaches = service.evaluate(ThreadPool::shared());
+        std::cout << "组合数: " << breaches.portfolios
+                  << ", 持仓数: " << book->holdingCount()
+                  << ", 基准外标的: " << book->offBenchmarkCount()
+                  << ", 越限: " << breaches.size()
+                  << ", 线程: " << breaches.threads
+                  << ", 耗时: " << breaches.elapsed_ms << "ms" << std::endl;
+        for (size_t k = 0; k < breaches.size(); ++k) {
+            std::cout << "  " << formatAlert(service.toAlert(breaches, k)) << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "组合风险检查失败: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// 进程峰值工作集（MB）
+double peakWorkingSetMB() {
+    PROCESS_MEMORY_COUNTERS counters{};
+    counters.cb = sizeof(counters);
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0.0;
+    }
+    return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+}
+
+int runReportBench(size_t componentCount) {
+    try {
+        DataLoader loader;
+        loader.loadFromCSV("../data/reits_data.csv");
+        
+        IndexCalculator calculator;
+        calculator.loadRules("../config/reits_index_rule.json");
+        auto base = calculator.calculateComponents(loader.getCurrentData());
+        if (base.empty()) {
+            throw std::runtime_error("无成分数据");
+        }
+        
+        // 复制当前成分至目标规模模拟全市场/多基金报告
+        std::vector<Component> components;
+        components.reserve(componentCount);
+        for (size_t i = 0; i < componentCount; ++i) {
+            Component comp = base[i % base.size()];
+            comp.reit.code += "_" + std::to_string(i / base.size());
+            components.push_back(std::move(comp));
+        }
+        
+        std::filesystem::create_directories("../reports/");
+        const std::string streamFile = "../reports/bench_stream.json";
+        const std::string domFile = "../reports/bench_dom.json";
+        const std::string csvFile = "../reports/bench.csv";
+        
+        // 峰值为进程级高水位，先测流式再测DOM
+        double baselinePeak = peakWorkingSetMB();
+        
+        auto started = std::chrono::steady_clock::now();
+        ComplianceReporter reporter;
+        reporter.writeReport(components, streamFile, streamFile);
+        double streamMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - started).count();
+        double streamPeak = peakWorkingSetMB();
+        
+        started = std::chrono::steady_clock::now();
+        reporter.exportToCSV(components, csvFile);
+        double csvMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - started).count();
+        double csvPeak = peakWorkingSetMB();
+        
+        started = std::chrono::steady_clock::now();
+        {
+            json report;
+            report["report_date"] = domFile;
+            report["component_count"] = components.size();
+            json componentsJson = json::array();
+            for (const auto& comp : components) {
+                json compJson;
+                compJson["code"] = comp.reit.code;
+                compJson["name"] = comp.reit.name;
+                compJson["sector"] = comp.reit.sector;
+                compJson["weight"] = comp.weight;
+                compJson["market_cap"] = comp.reit.market_cap;
+                compJson["dividend"] = comp.reit.dividend_amt;
+                componentsJson.push_back(compJson);
+            }
+            report["components"] = componentsJson;
+            std::ofstream outFile(domFile);
+            outFile << std::setw(4) << report << std::endl;
+        }
+        double domMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - started).count();
+        double domPeak = peakWorkingSetMB();
+        
+        double streamMB = std::filesystem::file_size(streamFile) / (1024.0 * 1024.0);
+        double domMB = std::filesystem::file_size(domFile) / (1024.0 * 1024.0);
+        double csvMB = std::filesystem::file_size(csvFile) / (1024.0 * 1024.0);
+        std::cout << "方式,成分数,文件(MB),耗时(ms),吞吐(MB/s),峰值工作集(MB),峰值增量(MB)" << std::endl;
+        std::cout << "流式," << componentCount << "," << streamMB << "," << streamMs << ","
+                  << streamMB / (streamMs / 1000.0) << "," << streamPeak << ","
+                  << streamPeak - baselinePeak << std::endl;
+        std::cout << "CSV," << componentCount << "," << csvMB << "," << csvMs << ","
+                  << csvMB / (csvMs / 1000.0) << "," << csvPeak << ","
+                  << csvPeak - streamPeak << std::endl;
+        std::cout << "DOM," << componentCount << "," << domMB << "," << domMs << ","
+                  << domMB / (domMs / 1000.0) << "," << domPeak << ","
+                  << domPeak - csvPeak << std::endl;
+        
+        // 编码对比：体积相对流式JSON，解码为读回完整成分报告
+        std::cout << std::endl << "编码,文件(MB),体积比,编码(ms),解码(ms)" << std::endl;
+        for (ReportFormat format : {ReportFormat::Json, ReportFormat::Cbor, ReportFormat::MsgPack,
+                                    ReportFormat::Ubjson, ReportFormat::Bson}) {
+            std::string file = std::string("../reports/bench") + reportExtension(format);
+            started = std::chrono::steady_clock::now();
+            if (format == ReportFormat::Json) {
+                reporter.writeReport(components, file, streamFile);
+            } else {
+                reporter.writeBinaryReport(components, format, file, streamFile);
+            }
+            double encodeMs = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - started).count();
+            
+            started = std::chrono::steady_clock::now();
+            LoadedReport loaded = ComplianceReporter::loadReport(file);
+            double decodeMs = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - started).count();
+            if (loaded.components.size() != components.size()) {
+                throw std::runtime_error(std::string("读回成分数不一致: ") + file);
+            }
+            
+            double fileMB = std::filesystem::file_size(file) / (1024.0 * 1024.0);
+            std::cout << reportFormatName(format) << "," << fileMB << "," << fileMB / streamMB << ","
+                      << encodeMs << "," << decodeMs << std::endl;
+        }
+        
+        // 单遍流水线：各格式分别生成之和 对比 一次遍历并行写出全部格式（两组写入不同目录，互不命中跳过）
+        const std::vector<ReportFormat> formats{ReportFormat::Json, ReportFormat::Csv,
+                                                ReportFormat::Xbrl, ReportFormat::Cbor};
+        ComplianceReporter separate;
+        separate.setReportPath("../reports/bench_separate/");
+        std::cout << std::endl << "方式,格式,耗时(ms)" << std::endl;
+        double separateMs = 0.0;
+        double slowestMs = 0.0;
+        for (ReportFormat format : formats) {
+            started = std::chrono::steady_clock::now();
+            separate.generate(format, components);
+            double ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - started).count();
+            separateMs += ms;
+            slowestMs = slowestMs < ms ? ms : slowestMs;
+            std::cout << "单独," << reportFormatName(format) << "," << ms << std::endl;
+        }
+        std::cout << "单独合计,全部," << separateMs << std::endl;
+        
+        ComplianceReporter pipelined;
+        pipelined.setReportPath("../reports/bench_pipeline/");
+        started = std::chrono::steady_clock::now();
+        pipelined.generate(formats, components);
+        double pipelineMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - started).count();
+        std::cout << "流水线,全部," << pipelineMs << "（最慢单一格式 " << slowestMs << "）" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "报告基准测试失败: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int runExport(const std::string& kind, const std::string& filename) {
+    try {
+        ComplianceReporter reporter;
+        auto started = std::chrono::steady_clock::now();
+        size_t rows = 0;
+        if (kind == "history") {
+            IndexHistory history;
+            history.loadFromCSV(HISTORY_FILE);
+            started = std::chrono::steady_clock::now();
+            reporter.exportToCSV(history, filename);
+            for (size_t t = 0; t < history.periodCount(); ++t) {
+                const double* marketCaps = history.marketCaps(t);
+                for (size_t i = 0; i < history.constituentCount(); ++i) {
+                    rows += marketCaps[i] > 0.0;
+                }
+            }
+        } else if (kind == "rankings") {
+            DataLoader loader;
+            loader.loadFromCSV("../data/reits_data.csv");
+            IndexCalculator calculator;
+            calculator.loadRules("../config/reits_index_rule.json");
+            std::vector<UniverseRank> ranks = calculator.rankUniverse(loader.getCurrentData());
+            started = std::chrono::steady_clock::now();
+            reporter.exportToCSV(loader.getCurrentData(), ranks, filename);
+            rows = ranks.size();
+        } else {
+            throw std::runtime_error("未知导出类型: " + kind + "（history/rankings）");
+        }
+        double elapsedMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - started).count();
+        double sizeMB = std::filesystem::file_size(filename) / (1024.0 * 1024.0);
+        std::cout << "已导出 " << rows << " 行到 " << filename
+                  << " (" << sizeMB << "MB, " << elapsedMs << "ms, "
+                  << sizeMB / (elapsedMs / 1000.0) << "MB/s)" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "CSV导出失败: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int runBulkReports(int startDate, int endDate, const std::string& fundsFile) {
+    try {
+        IndexHistory history;
+        history.loadFromCSV(HISTORY_FILE);
+        
+        IndexCalculator calculator;
+        calculator.loadRules("../config/reits_index_rule.json");
+        BulkReportSettings settings = BulkReportSettings::fromRules(calculator.getRules());
+        
+        std::shared_ptr<PortfolioBook> funds;
+        if (!fundsFile.empty()) {
+            funds = BulkReporter::fundBook(history);
+            funds->loadFromCSV(fundsFile);
+        }
+        
+        ComplianceReporter reporter;
+        BulkReporter bulk(reporter, settings);
+        BulkReportMetrics metrics = bulk.run(history, funds.get(),
+            history.upperBound(startDate - 1), history.upperBound(endDate),
+            [](const BulkReportMetrics& m) {
+                std::cout << "进度: " << m.completed << "/" << m.jobs
+                          << ", 失败: " << m.failed
+                          << ", " << m.jobs_per_second << " 份/s"
+                          << ", " << m.mb_per_second << " MB/s" << std::endl;
+            });
+        
+        std::cout << "基金: " << (funds ? funds->size() : 1)
+                  << ", 任务: " << metrics.jobs
+                  << ", 文件: " << metrics.files
+                  << ", 失败: " << metrics.failed
+                  << ", 线程: " << metrics.threads
+                  << ", 耗时: " << metrics.elapsed_ms << "ms"
+                  << ", " << metrics.jobs_per_second << " 份/s"
+                  << ", " << metrics.mb_per_second << " MB/s"
+                  << ", 输出: " << settings.output_path << std::endl;
+        if (metrics.failed > 0) {
+            std::cerr << "首个失败任务: " << metrics.first_error << std::endl;
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "批量报告失败: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int runReportList(int startDate, int endDate, const std::string& formatName) {
+    try {
+        IndexCalculator calculator;
+        calculator.loadRules("../config/reits_index_rule.json");
+        ReportStore store(ReportStoreSettings::fromRules(calculator.getRules()));
+        printQuarantined(store);
+        
+        std::optional<ReportFormat> format;
+        if (!formatName.empty()) {
+            format = parseReportFormat(formatName);
+        }
+        uint64_t bytes = 0;
+        size_t count = store.scan(makeReportKey(startDate), makeReportKey(endDate, 235959), format,
+            [&](const StoredReport& report) {
+                std::cout << report.key << "  " << std::left << std::setw(8)
+                          << reportFormatName(report.format) << std::right
+                          << report.data.size() << std::endl;
+                bytes += report.data.size();
+                return true;
+            });
+        
+        ReportStoreStats stats = store.stats();
+        std::cout << "报告: " << count << " 份, " << bytes << " 字节"
+                  << "; 存储段: " << stats.segments << "(归档 " << stats.archives << ")"
+                  << ", " << stats.bytes << " 字节" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "报告查询失败: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int runReportGet(int date, const std::string& formatName, const std::string& filename) {
+    try {
+        IndexCalculator calculator;
+        calculator.loadRules("../config/reits_index_rule.json");
+        ReportStore store(ReportStoreSettings::fromRules(calculator.getRules()));
+        printQuarantined(store);
+        
+        ReportFormat format = parseReportFormat(formatName);
+        std::optional<StoredReport> report = store.latest(date, format);
+        if (!report) {
+            std::cerr << "报告存储中没有 " << date << " 的 " << formatName << " 报告" << std::endl;
+            return 1;
+        }
+        std::string path = filename.empty()
+            ? "REITs_Report_" + std::to_string(date) + reportExtension(format) : filename;
+        std::ofstream out(path, std::ios::binary);
+        if (!out.write(report->data.data(), static_cast<std::streamsize>(report->data.size()))) {
+            throw std::runtime_error("无法写入文件: " + path);
+        }
+        std::cout << "报告 " << report->key << " (" << report->data.size() << " 字节) 已写入 "
+                  << path << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "报告读取失败: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int runAuditQuery(const std::string& timeText, const std::string& journalFile) {
+    try {
+        std::string path = journalFile;
+        if (path.empty()) {
+            IndexCalculator calculator;
+            calculator.loadRules("../config/reits_index_rule.json");
+            path = AuditJournalSettings::fromRules(calculator.getRules()).path;
+        }
+        
+        std::string text = timeText;
+        std::replace(text.begin(), text.end(), 'T', ' ');
+        std::tm local{};
+        std::istringstream in(text);
+        in >> std::get_time(&local, "%Y-%m-%d %H:%M:%S");
+        if (in.fail()) {
+            throw std::runtime_error("时间格式应为 YYYY-MM-DD HH:MM:SS: " + timeText);
+        }
+        local.tm_isdst = -1;
+        // 精确到秒：该秒内发布的记录均计入
+        int64_t at = static_cast<int64_t>(mktime(&local)) * 1000000000LL + 999999999LL;
+        
+        AuditJournalReader reader(path);
+        auto started = std::chrono::steady_clock::now();
+        std::optional<AuditRecord> record = reader.publishedAt(at);
+        double elapsedMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - started).count();
+        if (!record) {
+            std::cout << "该时刻之前无发布记录 (查询耗时 " << elapsedMs << "ms)" << std::endl;
+            return 1;
+        }
+        
+        const AuditRecordHeader& h = record->header;
+        time_t seconds = static_cast<time_t>(h.timestamp_ns / 1000000000LL);
+        std::cout << "序号: " << h.sequence
+                  << ", 发布时刻: " << std::put_time(localtime(&seconds), "%Y-%m-%d %H:%M:%S")
+                  << ", 计算日: " << h.date
+                  << ", 查询耗时: " << elapsedMs << "ms" << std::endl;
+        std::cout << "输入版本: " << std::hex << h.inputs_hash
+                  << ", 规则版本: " << h.rules_hash << std::dec << std::endl;
+        std::cout << "价格指数: " << h.levels.price
+                  << ", 全收益: " << h.levels.total_return
+                  << ", 净收益: " << h.levels.net_total_return << std::endl;
+        std::cout << "代码,权重" << std::endl;
+        for (const auto& comp : record->components) {
+            std::cout << comp.code << "," << comp.weight << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "审计日志查询失败: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int runAuditRepair(const std::string& journalFile) {
+    try {
+        std::string path = journalFile;
+        if (path.empty()) {
+            IndexCalculator calculator;
+            calculator.loadRules("../config/reits_index_rule.json");
+            path = AuditJournalSettings::fromRules(calculator.getRules()).path;
+        }
+        
+        AuditRepairResult result = AuditJournal::repair(path);
+        if (result.backup.empty()) {
+            std::cout << "审计日志无损坏，共 " << result.records << " 条记录" << std::endl;
+            return 0;
+        }
+        std::cout << "审计日志已修复: 保留 " << result.records << " 条记录, 丢弃 "
+                  << result.dropped_bytes << " 字节, 原文件备份为 " << result.backup << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "审计日志修复失败: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
 // Windows服务管理实现
 VOID WINAPI ServiceCtrlHandler(DWORD dwCtrl) {
     switch (dwCtrl) {
     case SERVICE_CONTROL_STOP:
+        // 主循环退出并落盘后由ServiceMain报告已停止
         g_serviceStatus.dwCurrentState = SERVICE_STOP_PENDING;
-        SetServiceStatus(g_statusHandle, &g_serviceStatus);
-        // 清理资源
-        g_serviceStatus.dwCurrentState = SERVICE_STOPPED;
+        g_stopRequested = true;
         break;
     default:
         break;
@@ -147,6 +1033,18 @@ VOID WINAPI ServiceCtrlHandler(DWORD dwCtrl) {
     SetServiceStatus(g_statusHandle, &g_serviceStatus);
 }
 
+BOOL WINAPI ConsoleCtrlHandler(DWORD ctrlType) {
+    switch (ctrlType) {
+    case CTRL_C_EVENT:
+    case CTRL_BREAK_EVENT:
+    case CTRL_CLOSE_EVENT:
+        g_stopRequested = true;
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
 VOID WINAPI ServiceMain(DWORD argc, LPWSTR* argv) {
     g_statusHandle = RegisterServiceCtrlHandlerW(L"REITsIndexService", ServiceCtrlHandler);
     
@@ -0,0 +1,199 @@
+﻿#include "AlertBus.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    // 按UTF-8字符边界截断复制
+    void copyTruncated(char* dst, size_t size, const std::string& src) {
+        size_t len = std::min(src.size(), size - 1);
+        while (len > 0 && len < src.size() &&
+               (static_cast<unsigned char>(src[len]) & 0xC0) == 0x80) {
+            --len;
+        }
+        std::memcpy(dst, src.data(), len);
+        dst[len] = '\0';
+    }
+
+    int64_t steadyNanos() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+AlertEvent AlertEvent::make(AlertType type, AlertLevel level, const std::string& subject,
+                            const std::string& label, double value, double threshold) {
+    AlertEvent event;
+    event.type = type;
+    event.level = level;
+    copyTruncated(event.subject, sizeof(event.subject), subject);
+    copyTruncated(event.label, sizeof(event.label), label);
+    event.value = value;
+    event.threshold = threshold;
+    event.timestamp = steadyNanos();
+    return event;
+}
+
+std::string formatAlert(const AlertEvent& event) {
+    switch (event.type) {
+    case AlertType::PositionConcentration:
+        return std::string(event.level == AlertLevel::Critical ? "REIT超限警告: " : "REIT接近超限: ") +
+               event.label + " 权重: " + std::to_string(event.value * 100) + "%";
+    case AlertType::SectorConcentration:
+        return std::string("行业集中度警告: ") + event.label +
+               " 总权重: " + std::to_string(event.value * 100) + "%";
+    case AlertType::RegionConcentration:
+        return std::string("区域集中度警告: ") + event.label +
+               " 总权重: " + std::to_string(event.value * 100) + "%";
+    case AlertType::Volatility:
+        return "波动率过高警告: " + std::to_string(event.value * 100) + "%";
+    case AlertType::CircuitBreaker:
+        if (event.threshold > 0.0) {
+            return std::string("系统熔断已触发（") + event.label + " " +
+                   std::to_string(event.value * 100) + "%）！暂停所有交易操作";
+        }
+        return "系统熔断已触发！暂停所有交易操作";
+    case AlertType::TrackingError:
+        return std::string("跟踪误差警告: ") + event.label +
+               " 年化: " + std::to_string(event.value * 100) + "%";
+    }
+    return "未知警报";
+}
+
+AlertBus::AlertBus(size_t capacity) : m_queue(capacity) {
+    m_dispatcher = std::thread(&AlertBus::dispatchLoop, this);
+}
+
+AlertBus::~AlertBus() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    if (m_dispatcher.joinable()) {
+        m_dispatcher.join();
+    }
+}
+
+void AlertBus::publish(const AlertEvent& event) {
+    if (!m_queue.tryPush(event)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    m_published.fetch_add(1, std::memory_order_release);
+
+    // 仅在分发线程休眠时才进入内核唤醒
+    if (m_sleeping.load()) {
+        std::lock_guard lock(m_mutex);
+        m_wake.notify_one();
+    }
+}
+
+uint64_t AlertBus::subscribe(Handler handler, SubscriberOptions options) {
+    auto sub = std::make_shared<Subscriber>();
+    sub->handler = std::move(handler);
+    sub->options = options;
+
+    std::lock_guard lock(m_subscriberMutex);
+    const uint64_t id = m_nextId++;
+    sub->id = id;
+    auto list = std::make_shared<SubscriberList>(*m_subscribers.load());
+    list->push_back(std::move(sub));
+    m_subscribers.store(std::move(list));
+    return id;
+}
+
+void AlertBus::unsubscribe(uint64_t id) {
+    std::lock_guard lock(m_subscriberMutex);
+    auto list = std::make_shared<SubscriberList>(*m_subscribers.load());
+    for (const auto& sub : *list) {
+        if (sub->id == id) {
+            sub->active = false;
+        }
+    }
+    list->erase(
+        std::remove_if(list->begin(), list->end(),
+            [id](const std::shared_ptr<Subscriber>& s) { return s->id == id; }),
+        list->end());
+    m_subscribers.store(std::move(list));
+}
+
+void AlertBus::flush() {
+    uint64_t target = m_published.load(std::memory_order_acquire);
+    std::unique_lock lock(m_mutex);
+    m_wake.notify_one();
+    m_drained.wait(lock, [&] {
+        return m_dispatched.load(std::memory_order_acquire) >= target || m_stopping;
+    });
+}
+
+void AlertBus::dispatchLoop() {
+    using namespace std::chrono_literals;
+
+    while (true) {
+        AlertEvent event;
+        bool drained = false;
+        while (m_queue.tryPop(event)) {
+            dispatch(event);
+            m_dispatched.fetch_add(1, std::memory_order_release);
+            drained = true;
+        }
+
+        std::unique_lock lock(m_mutex);
+        if (drained) {
+            m_drained.notify_all();
+        }
+        if (m_stopping && !m_queue.readable()) {
+            m_drained.notify_all();
+            return;
+        }
+
+        m_sleeping.store(true);
+        m_wake.wait_for(lock, 100ms, [&] {
+            return m_stopping || m_queue.readable();
+        });
+        m_sleeping.store(false);
+    }
+}
+
+void AlertBus::dispatch(const AlertEvent& event) {
+    // 取订阅表快照后不再持锁：处理函数可修改订阅，慢处理函数也不阻塞订阅变更
+    std::shared_ptr<const SubscriberList> subscribers = m_subscribers.load();
+    std::string key;
+
+    for (const auto& entry : *subscribers) {
+        Subscriber& sub = *entry;
+        if (!sub.active.load()) {
+            continue;
+        }
+        const SubscriberOptions& opt = sub.options;
+        if (event.level < opt.min_level ||
+            !(opt.type_mask & (1u << static_cast<uint32_t>(event.type)))) {
+            continue;
+        }
+
+        if (key.empty()) {
+            key.assign(1, static_cast<char>(event.type));
+            key += event.subject;
+        }
+
+        auto [it, fresh] = sub.delivered.try_emplace(key);
+        DeliveryState& state = it->second;
+        if (!fresh) {
+            bool escalated = event.level > state.level;
+            bool withinWindow = event.timestamp - state.timestamp <
+                std::chrono::duration_cast<std::chrono::nanoseconds>(opt.dedup_window).count();
+            double band = opt.hysteresis * std::max(std::fabs(state.value), std::fabs(event.threshold));
+            bool moved = std::fabs(event.value - state.value) > band;
+            if (withinWindow && !escalated && !moved) {
+                m_suppressed.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+        }
+
+        state.timestamp = event.timestamp;
+        state.value = event.value;
+        state.level = event.level;
+        sub.handler(event);
+    }
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "core/MpscQueue.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// 警报类型
+enum class AlertType : uint8_t {
+    PositionConcentration,  // 单只权重
+    SectorConcentration,    // 行业权重
+    RegionConcentration,    // 区域权重
+    Volatility,             // 波动率
+    CircuitBreaker,         // 熔断
+    TrackingError           // 跟踪组合跟踪误差
+};
+
+// 警报级别
+enum class AlertLevel : uint8_t {
+    Info,
+    Warning,
+    Critical
+};
+
+// 结构化警报事件（定长POD，生产者侧不做字符串格式化与堆分配）
+struct AlertEvent {
+    AlertType type = AlertType::PositionConcentration;
+    AlertLevel level = AlertLevel::Warning;
+    char subject[32] = {};      // 去重对象：REIT代码或行业/区域名称（跟踪组合为组合与持仓/限额）
+    char label[64] = {};        // 展示名称
+    double value = 0.0;
+    double threshold = 0.0;
+    int64_t timestamp = 0;      // steady_clock纳秒
+
+    static AlertEvent make(AlertType type, AlertLevel level, const std::string& subject,
+                           const std::string& label, double value, double threshold);
+};
+
+// 格式化警报文本（在消费者侧调用）
+std::string formatAlert(const AlertEvent& event);
+
+// 订阅选项
+struct SubscriberOptions {
+    AlertLevel min_level = AlertLevel::Info;
+    uint32_t type_mask = UINT32_MAX;    // 按 1 << AlertType 过滤
+    // 去重窗口：窗口内同一(类型, 对象)的重复警报被抑制，级别升高除外
+    std::chrono::milliseconds dedup_window{std::chrono::minutes(5)};
+    // 迟滞：窗口内数值相对上次送达值变化超过该比例才再次送达
+    double hysteresis = 0.05;
+};
+
+// 异步警报总线：无锁MPSC入队，分发线程批量取出后按订阅过滤、去重、迟滞送达
+// 订阅表为写时复制的共享快照，分发时不持有锁，处理函数内可订阅/取消订阅
+class AlertBus {
+public:
+    using Handler = std::function<void(const AlertEvent&)>;
+
+    explicit AlertBus(size_t capacity = 4096);
+    ~AlertBus();
+
+    AlertBus(const AlertBus&) = delete;
+    AlertBus& operator=(const AlertBus&) = delete;
+
+    // 发布警报（无锁；队列满时丢弃并计数）
+    void publish(const AlertEvent& event);
+
+    // 订阅/取消订阅（取消时正在进行的一次送达可能仍会完成）
+    uint64_t subscribe(Handler handler, SubscriberOptions options = {});
+    void unsubscribe(uint64_t id);
+
+    // 阻塞至此前发布的警报全部分发完毕
+    void flush();
+
+    uint64_t publishedCount() const { return m_published.load(std::memory_order_relaxed); }
+    uint64_t droppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+    uint64_t suppressedCount() const { return m_suppressed.load(std::memory_order_relaxed); }
+
+private:
+    struct DeliveryState {
+        int64_t timestamp = 0;
+        double value = 0.0;
+        AlertLevel level = AlertLevel::Info;
+    };
+
+    struct Subscriber {
+        uint64_t id;
+        Handler handler;
+        SubscriberOptions options;
+        std::atomic<bool> active{true};
+        std::unordered_map<std::string, DeliveryState> delivered;   // 仅分发线程访问
+    };
+    using SubscriberList = std::vector<std::shared_ptr<Subscriber>>;
+
+    void dispatchLoop();
+    void dispatch(const AlertEvent& event);
+
+    MpscQueue<AlertEvent> m_queue;
+    std::atomic<uint64_t> m_published{0};
+    std::atomic<uint64_t> m_dispatched{0};
+    std::atomic<uint64_t> m_dropped{0};
+    std::atomic<uint64_t> m_suppressed{0};
+    std::atomic<bool> m_sleeping{false};
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_drained;
+    bool m_stopping = false;
+
+    std::mutex m_subscriberMutex;       // 串行化订阅表的修改
+    std::atomic<std::shared_ptr<const SubscriberList>> m_subscribers{
+        std::make_shared<const SubscriberList>()};
+    uint64_t m_nextId = 1;
+
+    std::thread m_dispatcher;
+};
@@ -0,0 +1,102 @@
+﻿#include "CircuitBreaker.hpp"
+#include <cmath>
+
+BreakerSettings BreakerSettings::fromRules(const json& rules) {
+    BreakerSettings settings;
+    json cfg = rules.value("circuit_breaker", json::object());
+
+    settings.max_drawdown = cfg.value("max_drawdown", settings.max_drawdown);
+    settings.max_tick_move = cfg.value("max_tick_move", settings.max_tick_move);
+    settings.halt = std::chrono::seconds(cfg.value("halt_seconds",
+        std::chrono::duration_cast<std::chrono::seconds>(settings.halt).count()));
+    settings.cooldown = std::chrono::seconds(cfg.value("cooldown_seconds",
+        std::chrono::duration_cast<std::chrono::seconds>(settings.cooldown).count()));
+    return settings;
+}
+
+CircuitBreaker::CircuitBreaker(BreakerSettings settings)
+    : m_settings(settings),
+      m_word(pack(BreakerState::Armed, TripReason::None, Clock::now())) {}
+
+uint64_t CircuitBreaker::pack(BreakerState state, TripReason reason, Clock::time_point since) {
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(since.time_since_epoch()).count();
+    return (static_cast<uint64_t>(ms) << 16) |
+           (static_cast<uint64_t>(reason) << 8) |
+           static_cast<uint64_t>(state);
+}
+
+CircuitBreaker::Clock::time_point CircuitBreaker::sinceOf(uint64_t word) {
+    return Clock::time_point(std::chrono::milliseconds(static_cast<int64_t>(word >> 16)));
+}
+
+void CircuitBreaker::startSession() {
+    m_high = 0.0;
+    m_previous = 0.0;
+    m_drawdown = 0.0;
+    m_lastMove = 0.0;
+}
+
+void CircuitBreaker::poll(Clock::time_point now) {
+    uint64_t word = m_word.load(std::memory_order_acquire);
+    while (true) {
+        BreakerState state = stateOf(word);
+        Clock::time_point since = sinceOf(word);
+        uint64_t next = word;
+        if (state == BreakerState::Tripped && now - since >= m_settings.halt) {
+            next = pack(BreakerState::Cooldown, reasonOf(word), now);
+        } else if (state == BreakerState::Cooldown && now - since >= m_settings.cooldown) {
+            next = pack(BreakerState::Armed, TripReason::None, now);
+        }
+        if (next == word) {
+            return;
+        }
+        // 与其他线程的trip/reset竞争时以最新状态重试
+        if (m_word.compare_exchange_weak(word, next, std::memory_order_acq_rel)) {
+            word = next;
+        }
+    }
+}
+
+bool CircuitBreaker::trip(TripReason reason, Clock::time_point now) {
+    uint64_t word = m_word.load(std::memory_order_acquire);
+    do {
+        if (stateOf(word) == BreakerState::Tripped) {
+            return false;
+        }
+    } while (!m_word.compare_exchange_weak(word, pack(BreakerState::Tripped, reason, now),
+                                           std::memory_order_acq_rel));
+    return true;
+}
+
+void CircuitBreaker::reset() {
+    m_word.store(pack(BreakerState::Armed, TripReason::None, Clock::now()), std::memory_order_release);
+}
+
+TripReason CircuitBreaker::onTick(double level, Clock::time_point now) {
+    poll(now);
+    if (level <= 0.0) {
+        return TripReason::None;
+    }
+
+    // 日内高点回撤与相邻两笔跳变，均为O(1)
+    m_lastMove = m_previous > 0.0 ? level / m_previous - 1.0 : 0.0;
+    m_previous = level;
+    if (level > m_high) {
+        m_high = level;
+    }
+    m_drawdown = 1.0 - level / m_high;
+
+    TripReason reason = TripReason::None;
+    if (m_drawdown >= m_settings.max_drawdown) {
+        reason = TripReason::Drawdown;
+    } else if (std::fabs(m_lastMove) >= m_settings.max_tick_move) {
+        reason = TripReason::TickMove;
+    }
+
+    // Armed与Cooldown状态下均可触发；已熔断时不重复计时
+    if (reason != TripReason::None && trip(reason, now)) {
+        m_high = level;
+        return reason;
+    }
+    return TripReason::None;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+// 熔断状态
+enum class BreakerState : uint8_t {
+    Armed,      // 正常运行，监测触发条件
+    Tripped,    // 已熔断，下游暂停
+    Cooldown    // 恢复观察期：下游恢复，期间再次触发立即熔断
+};
+
+// 熔断原因
+enum class TripReason : uint8_t {
+    None,
+    Drawdown,   // 日内自高点回撤
+    TickMove,   // 相邻两笔跳变
+    Manual      // 人工触发
+};
+
+struct BreakerSettings {
+    double max_drawdown = 0.07;     // 日内回撤阈值
+    double max_tick_move = 0.03;    // 相邻两笔涨跌幅阈值
+    std::chrono::milliseconds halt{std::chrono::minutes(15)};
+    std::chrono::milliseconds cooldown{std::chrono::minutes(30)};
+
+    // 从规则配置的 "circuit_breaker" 节解析
+    static BreakerSettings fromRules(const json& rules);
+};
+
+// 熔断器：状态、原因与状态起始时间打包于单个原子字，热路径仅需一次acquire读取
+// onTick/startSession须由单一行情线程调用；trip/reset/halted可在任意线程调用
+class CircuitBreaker {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit CircuitBreaker(BreakerSettings settings = {});
+
+    // 更新阈值（须在行情线程或行情开始前调用）
+    void configure(BreakerSettings settings) { m_settings = settings; }
+    const BreakerSettings& settings() const { return m_settings; }
+
+    // 开始新交易日：清空日内高点与上一笔
+    void startSession();
+
+    // 每笔指数点位O(1)评估，推进状态机；本笔导致熔断时返回触发原因，否则返回None
+    // 熔断后以触发点位为新的回撤基准，恢复后需再回撤同样幅度才会再次触发
+    TripReason onTick(double level, Clock::time_point now = Clock::now());
+
+    // 按时间推进 Tripped -> Cooldown -> Armed（无行情时由下游循环调用）
+    void poll(Clock::time_point now = Clock::now());
+
+    // 人工熔断/人工解除（立即恢复Armed）
+    bool trip(TripReason reason, Clock::time_point now = Clock::now());
+    void reset();
+
+    // 下游循环检查：是否处于熔断
+    bool halted() const {
+        return stateOf(m_word.load(std::memory_order_acquire)) == BreakerState::Tripped;
+    }
+
+    BreakerState state() const { return stateOf(m_word.load(std::memory_order_acquire)); }
+    TripReason reason() const { return reasonOf(m_word.load(std::memory_order_acquire)); }
+
+    double drawdown() const { return m_drawdown; }
+    double lastMove() const { return m_lastMove; }
+
+private:
+    // 字布局：[63:16] 状态起始毫秒 | [15:8] 原因 | [7:0] 状态
+    static uint64_t pack(BreakerState state, TripReason reason, Clock::time_point since);
+    static BreakerState stateOf(uint64_t word) { return static_cast<BreakerState>(word & 0xFF); }
+    static TripReason reasonOf(uint64_t word) { return static_cast<TripReason>((word >> 8) & 0xFF); }
+    static Clock::time_point sinceOf(uint64_t word);
+
+    BreakerSettings m_settings;
+    std::atomic<uint64_t> m_word;
+
+    // 行情线程私有的日内状态
+    double m_high = 0.0;
+    double m_previous = 0.0;
+    double m_drawdown = 0.0;
+    double m_lastMove = 0.0;
+};
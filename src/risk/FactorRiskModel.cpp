@@ -0,0 +1,293 @@
+﻿#include "FactorRiskModel.hpp"
+#include "core/LinearAlgebra.hpp"
+#include "core/ThreadPool.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    const size_t STYLE_FACTORS = 3;
+    const char* const STYLE_NAMES[STYLE_FACTORS] = {"股息率", "规模", "杠杆"};
+
+    // 风格原始值：股息率、对数市值、负债率
+    void styleRaw(double marketCap, double dividend, double debtRatio, double* out) {
+        out[0] = dividend / marketCap;
+        out[1] = std::log(marketCap);
+        out[2] = debtRatio;
+    }
+}
+
+FactorRiskModel::FactorRiskModel(const IndexHistory& history) : m_history(history) {}
+
+FactorRiskModel::StyleStats FactorRiskModel::styleStats(size_t t) const {
+    StyleStats stats;
+    const double* caps = m_history.marketCaps(t);
+    const double* divs = m_history.dividends(t);
+    const double* debts = m_history.debtRatios(t);
+    const size_t n = m_history.constituentCount();
+
+    // 市值加权均值、等权标准差
+    double totalCap = 0.0;
+    size_t count = 0;
+    double raw[STYLE_FACTORS];
+    for (size_t i = 0; i < n; ++i) {
+        if (caps[i] <= 0.0) {
+            continue;
+        }
+        styleRaw(caps[i], divs[i], debts[i], raw);
+        for (size_t k = 0; k < STYLE_FACTORS; ++k) {
+            stats.mean[k] += caps[i] * raw[k];
+        }
+        totalCap += caps[i];
+        ++count;
+    }
+    if (count < 2) {
+        return stats;
+    }
+    for (size_t k = 0; k < STYLE_FACTORS; ++k) {
+        stats.mean[k] /= totalCap;
+    }
+
+    double sq[STYLE_FACTORS] = {};
+    for (size_t i = 0; i < n; ++i) {
+        if (caps[i] <= 0.0) {
+            continue;
+        }
+        styleRaw(caps[i], divs[i], debts[i], raw);
+        for (size_t k = 0; k < STYLE_FACTORS; ++k) {
+            double d = raw[k] - stats.mean[k];
+            sq[k] += d * d;
+        }
+    }
+    for (size_t k = 0; k < STYLE_FACTORS; ++k) {
+        double sd = std::sqrt(sq[k] / static_cast<double>(count - 1));
+        stats.stdev[k] = sd > 0.0 ? sd : 1.0;
+    }
+    return stats;
+}
+
+void FactorRiskModel::fillExposure(uint32_t sector, uint32_t region, double marketCap,
+                                   double dividend, double debtRatio,
+                                   const StyleStats& stats, double* row) const {
+    std::fill_n(row, factorCount(), 0.0);
+
+    if (sector < m_sectorCount) {
+        row[sector] = 1.0;
+    }
+    if (region > 0 && region < m_regionCount) {
+        row[m_sectorCount + region - 1] = 1.0;
+    }
+
+    double raw[STYLE_FACTORS];
+    styleRaw(marketCap, dividend, debtRatio, raw);
+    double* style = row + factorCount() - STYLE_FACTORS;
+    for (size_t k = 0; k < STYLE_FACTORS; ++k) {
+        style[k] = (raw[k] - stats.mean[k]) / stats.stdev[k];
+    }
+}
+
+void FactorRiskModel::estimate(size_t window) {
+    m_sectorCount = m_history.sectors().size();
+    m_regionCount = m_history.regions().size();
+
+    m_factorNames.clear();
+    for (uint32_t s = 0; s < m_sectorCount; ++s) {
+        m_factorNames.push_back("行业:" + m_history.sectors().name(s));
+    }
+    for (uint32_t r = 1; r < m_regionCount; ++r) {
+        m_factorNames.push_back("区域:" + m_history.regions().name(r));
+    }
+    for (const char* name : STYLE_NAMES) {
+        m_factorNames.push_back(name);
+    }
+
+    const size_t k = factorCount();
+    const size_t n = m_history.constituentCount();
+    const size_t periods = m_history.periodCount();
+
+    m_factorReturns.clear();
+    m_factorDates.clear();
+    m_factorCovariance.assign(k * k, 0.0);
+    m_specificVariance.assign(n, 0.0);
+    m_meanSpecificVariance = 0.0;
+    if (periods < 2) {
+        return;
+    }
+    m_latestStats = styleStats(periods - 1);
+
+    size_t first = 1;
+    if (window > 0 && periods - 1 > window) {
+        first = periods - window;
+    }
+    const size_t count = periods - first;
+    m_factorReturns.assign(count * k, 0.0);
+    std::vector<uint8_t> solved(count, 0);     // 样本不足或求解失败的期不参与因子协方差
+
+    ThreadPool& pool = ThreadPool::shared();
+    const size_t workers = pool.size();
+    std::vector<double> residualSq(workers * n, 0.0);
+    std::vector<size_t> residualCount(workers * n, 0);
+
+    // 按期并行：各期独立做加权最小二乘（XᵀVX）f = XᵀVr
+    pool.parallelFor(0, count, 8, [&](size_t lo, size_t hi, size_t worker) {
+        std::vector<double> z(n * k), y(n), scale(n), a(k * k), b(k);
+        std::vector<size_t> members(n);
+        double* sq = &residualSq[worker * n];
+        size_t* cnt = &residualCount[worker * n];
+
+        for (size_t p = lo; p < hi; ++p) {
+            size_t t = first + p;
+            StyleStats stats = styleStats(t - 1);
+            const double* caps = m_history.marketCaps(t - 1);
+            const double* capsNow = m_history.marketCaps(t);
+            const double* divs = m_history.dividends(t - 1);
+            const double* debts = m_history.debtRatios(t - 1);
+            const double* ret = m_history.returns(t);
+
+            // 组装按 sqrt(权重) 缩放的设计矩阵，权重取市值平方根
+            size_t m = 0;
+            for (size_t i = 0; i < n; ++i) {
+                if (caps[i] <= 0.0 || capsNow[i] <= 0.0) {
+                    continue;
+                }
+                double* row = &z[m * k];
+                fillExposure(m_history.sectorId(i), m_history.regionId(i),
+                             caps[i], divs[i], debts[i], stats, row);
+                double sw = std::sqrt(std::sqrt(caps[i]));
+                for (size_t c = 0; c < k; ++c) {
+                    row[c] *= sw;
+                }
+                y[m] = ret[i] * sw;
+                scale[m] = sw;
+                members[m] = i;
+                ++m;
+            }
+            if (m <= k) {
+                continue;
+            }
+
+            linalg::gram(z.data(), m, k, a.data());
+            std::fill(b.begin(), b.end(), 0.0);
+            for (size_t r = 0; r < m; ++r) {
+                const double* row = &z[r * k];
+                for (size_t c = 0; c < k; ++c) {
+                    b[c] += row[c] * y[r];
+                }
+            }
+
+            // 微小岭项保证本期缺席的行业列仍可求解（对应因子收益为0）
+            double trace = 0.0;
+            for (size_t c = 0; c < k; ++c) {
+                trace += a[c * k + c];
+            }
+            double ridge = 1e-10 * trace / static_cast<double>(k) + 1e-300;
+            for (size_t c = 0; c < k; ++c) {
+                a[c * k + c] += ridge;
+            }
+            if (!linalg::choleskySolve(a.data(), b.data(), k)) {
+                continue;
+            }
+
+            std::copy(b.begin(), b.end(), &m_factorReturns[p * k]);
+            solved[p] = 1;
+            for (size_t r = 0; r < m; ++r) {
+                double e = (y[r] - linalg::dot(&z[r * k], b.data(), k)) / scale[r];
+                sq[members[r]] += e * e;
+                ++cnt[members[r]];
+            }
+        }
+    });
+
+    // 只保留成功估计的期，跳过的期不以零收益计入
+    size_t valid = 0;
+    for (size_t p = 0; p < count; ++p) {
+        if (!solved[p]) {
+            continue;
+        }
+        if (valid != p) {
+            std::copy_n(&m_factorReturns[p * k], k, &m_factorReturns[valid * k]);
+        }
+        m_factorDates.push_back(m_history.dates()[first + p]);
+        ++valid;
+    }
+    m_factorReturns.resize(valid * k);
+
+    // 因子协方差：有效期因子收益的样本协方差
+    if (valid >= 2) {
+        std::vector<double> centered(m_factorReturns);
+        for (size_t c = 0; c < k; ++c) {
+            double mean = 0.0;
+            for (size_t p = 0; p < valid; ++p) {
+                mean += centered[p * k + c];
+            }
+            mean /= static_cast<double>(valid);
+            for (size_t p = 0; p < valid; ++p) {
+                centered[p * k + c] -= mean;
+            }
+        }
+        linalg::gram(centered.data(), valid, k, m_factorCovariance.data());
+        for (double& v : m_factorCovariance) {
+            v /= static_cast<double>(valid - 1);
+        }
+    }
+
+    // 特异方差：残差均方
+    size_t estimated = 0;
+    for (size_t i = 0; i < n; ++i) {
+        double sum = 0.0;
+        size_t obs = 0;
+        for (size_t w = 0; w < workers; ++w) {
+            sum += residualSq[w * n + i];
+            obs += residualCount[w * n + i];
+        }
+        if (obs >= 2) {
+            m_specificVariance[i] = sum / static_cast<double>(obs - 1);
+            m_meanSpecificVariance += m_specificVariance[i];
+            ++estimated;
+        } else {
+            m_specificVariance[i] = -1.0;
+        }
+    }
+    if (estimated > 0) {
+        m_meanSpecificVariance /= static_cast<double>(estimated);
+    }
+}
+
+RiskDecomposition FactorRiskModel::decompose(const std::vector<Component>& components) const {
+    RiskDecomposition result;
+    const size_t k = factorCount();
+    if (k == 0 || m_factorReturns.empty()) {
+        return result;
+    }
+
+    // 组合暴露 x = Σ w_i·X_i
+    std::vector<double> exposure(k, 0.0), row(k);
+    for (const auto& comp : components) {
+        fillExposure(m_history.sectors().find(comp.reit.sector),
+                     m_history.regions().find(comp.reit.region),
+                     comp.reit.market_cap, comp.reit.dividend_amt, comp.reit.debt_ratio,
+                     m_latestStats, row.data());
+        for (size_t c = 0; c < k; ++c) {
+            exposure[c] += comp.weight * row[c];
+        }
+
+        // 无估计值的成分使用全样本平均特异方差
+        int col = m_history.columnOf(comp.reit.code);
+        double specific = col >= 0 && static_cast<size_t>(col) < m_specificVariance.size()
+            ? m_specificVariance[col] : -1.0;
+        if (specific < 0.0) {
+            specific = m_meanSpecificVariance;
+        }
+        result.specific_variance += comp.weight * comp.weight * specific;
+    }
+
+    std::vector<double> fx(k);
+    linalg::gemv(m_factorCovariance.data(), exposure.data(), fx.data(), k);
+    for (size_t c = 0; c < k; ++c) {
+        double contribution = exposure[c] * fx[c];
+        result.factor_variance += contribution;
+        result.factor_contributions.emplace_back(m_factorNames[c], contribution);
+    }
+
+    result.total_variance = result.factor_variance + result.specific_variance;
+    return result;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "core/IndexHistory.hpp"
+#include <string>
+#include <vector>
+
+// 指数风险分解结果（单期方差口径）
+struct RiskDecomposition {
+    double total_variance = 0.0;
+    double factor_variance = 0.0;
+    double specific_variance = 0.0;
+
+    // 各因子对组合方差的贡献 x_k·(F·x)_k，合计等于factor_variance
+    std::vector<std::pair<std::string, double>> factor_contributions;
+};
+
+// 基本面因子风险模型：行业/区域哑变量 + 股息率、规模、杠杆风格因子
+// 每期以上期末暴露对本期收益做市值平方根加权的截面回归，估计因子收益
+class FactorRiskModel {
+public:
+    explicit FactorRiskModel(const IndexHistory& history);
+
+    // 批量估计最近window期（0为全部历史）的因子收益、因子协方差与特异方差
+    void estimate(size_t window = 0);
+
+    // 分解成分组合的风险为因子与特异部分
+    RiskDecomposition decompose(const std::vector<Component>& components) const;
+
+    size_t factorCount() const { return m_factorNames.size(); }
+    const std::vector<std::string>& factorNames() const { return m_factorNames; }
+
+    // 因子收益（成功估计的期数 × 因子数，行主序），各行对应的期日期见factorDates
+    const std::vector<double>& factorReturns() const { return m_factorReturns; }
+    const std::vector<int>& factorDates() const { return m_factorDates; }
+    const std::vector<double>& factorCovariance() const { return m_factorCovariance; }
+
+private:
+    // 风格因子截面标准化参数
+    struct StyleStats {
+        double mean[3] = {};
+        double stdev[3] = {1.0, 1.0, 1.0};
+    };
+
+    // 计算第t期样本的风格原始值与标准化参数
+    StyleStats styleStats(size_t t) const;
+
+    // 填充单个REIT的暴露行
+    void fillExposure(uint32_t sector, uint32_t region, double marketCap, double dividend,
+                      double debtRatio, const StyleStats& stats, double* row) const;
+
+    const IndexHistory& m_history;
+
+    // 因子布局：[行业哑变量 | 区域哑变量（去除首个区域作基准）| 风格因子]
+    size_t m_sectorCount = 0;
+    size_t m_regionCount = 0;
+    std::vector<std::string> m_factorNames;
+
+    std::vector<double> m_factorReturns;
+    std::vector<int> m_factorDates;
+    std::vector<double> m_factorCovariance;
+    std::vector<double> m_specificVariance;     // 按历史列索引
+    double m_meanSpecificVariance = 0.0;
+    StyleStats m_latestStats;
+};
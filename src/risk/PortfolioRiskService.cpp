@@ -0,0 +1,338 @@
+﻿#include "PortfolioRiskService.hpp"
+#include "core/ThreadPool.hpp"
+#include "core/XxHash64.hpp"
+#include "data/SymbolTable.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+    // 每块组合数：块内越限按组合顺序写入独立暂存，合并后整体有序
+    constexpr size_t kGrain = 64;
+
+    // 0为未越限，1为预警，2为严重
+    uint8_t levelOf(double value, double warning, double critical) {
+        return static_cast<uint8_t>(value >= warning) + static_cast<uint8_t>(value >= critical);
+    }
+}
+
+PortfolioBook::PortfolioBook(ComponentSnapshot benchmark, const REITList& universe)
+    : m_benchmark(std::move(benchmark)) {
+    const std::vector<Component>& components = *m_benchmark;
+    for (size_t i = 0; i < components.size(); ++i) {
+        m_index.emplace(components[i].reit.code, static_cast<uint32_t>(i));
+        m_instruments.push_back(components[i].reit);
+    }
+    for (const auto& reit : universe) {
+        if (!m_index.count(reit.code)) {
+            m_universe.emplace(reit.code, reit);
+        }
+    }
+}
+
+size_t PortfolioBook::add(const std::string& id,
+                          const std::vector<std::pair<std::string, double>>& holdings) {
+    std::vector<std::pair<uint32_t, double>> rows;
+    rows.reserve(holdings.size());
+    for (const auto& [code, weight] : holdings) {
+        auto [it, added] = m_index.emplace(code, static_cast<uint32_t>(m_instruments.size()));
+        if (added) {
+            // 基准外持仓：基准权重为0，行业/区域取自全市场数据
+            auto found = m_universe.find(code);
+            REIT reit{};
+            if (found != m_universe.end()) {
+                reit = found->second;
+            } else {
+                reit.code = code;
+            }
+            m_instruments.push_back(std::move(reit));
+        }
+        rows.emplace_back(it->second, weight);
+    }
+    std::sort(rows.begin(), rows.end());
+
+    for (size_t k = 0; k < rows.size(); ++k) {
+        if (k > 0 && rows[k].first == rows[k - 1].first) {
+            m_weight.back() += rows[k].second;
+            continue;
+        }
+        m_component.push_back(rows[k].first);
+        m_weight.push_back(rows[k].second);
+    }
+    m_ids.push_back(id);
+    m_offset.push_back(m_component.size());
+    return m_ids.size() - 1;
+}
+
+void PortfolioBook::loadFromCSV(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("无法打开组合持仓文件: " + filename);
+    }
+
+    // 跳过标题行
+    std::string line;
+    std::getline(file, line);
+
+    // 按组合首次出现顺序归集
+    std::unordered_map<std::string, size_t> order;
+    std::vector<std::string> ids;
+    std::vector<std::vector<std::pair<std::string, double>>> holdings;
+    while (std::getline(file, line)) {
+        if (line.empty() || line == "\r") {
+            continue;
+        }
+        std::istringstream iss(line);
+        std::string id;
+        std::string code;
+        std::string field;
+        std::getline(iss, id, ',');
+        std::getline(iss, code, ',');
+        std::getline(iss, field, ',');
+
+        auto [it, inserted] = order.emplace(id, ids.size());
+        if (inserted) {
+            ids.push_back(id);
+            holdings.emplace_back();
+        }
+        holdings[it->second].emplace_back(code, std::stod(field));
+    }
+
+    for (size_t k = 0; k < ids.size(); ++k) {
+        add(ids[k], holdings[k]);
+    }
+}
+
+void PortfolioBreachBatch::clear() {
+    portfolio.clear();
+    type.clear();
+    level.clear();
+    index.clear();
+    value.clear();
+    threshold.clear();
+}
+
+void PortfolioBreachBatch::push(uint32_t p, AlertType t, AlertLevel l, uint32_t i,
+                                double v, double th) {
+    portfolio.push_back(p);
+    type.push_back(t);
+    level.push_back(l);
+    index.push_back(i);
+    value.push_back(v);
+    threshold.push_back(th);
+}
+
+void PortfolioBreachBatch::append(const PortfolioBreachBatch& other) {
+    portfolio.insert(portfolio.end(), other.portfolio.begin(), other.portfolio.end());
+    type.insert(type.end(), other.type.begin(), other.type.end());
+    level.insert(level.end(), other.level.begin(), other.level.end());
+    index.insert(index.end(), other.index.begin(), other.index.end());
+    value.insert(value.end(), other.value.begin(), other.value.end());
+    threshold.insert(threshold.end(), other.threshold.begin(), other.threshold.end());
+}
+
+PortfolioRiskService::PortfolioRiskService(std::shared_ptr<const RiskLimitTable> limits)
+    : m_limits(std::move(limits)) {}
+
+void PortfolioRiskService::load(std::shared_ptr<const PortfolioBook> book) {
+    const std::vector<Component>& benchmark = *book->benchmark();
+    if (book != m_book) {
+        m_hasCovariance = false;
+    }
+
+    // 按标的序号绑定限额，基准外持仓的基准权重为0
+    std::vector<Component> instruments;
+    instruments.reserve(book->instrumentCount());
+    m_benchmarkWeight.assign(book->instrumentCount(), 0.0);
+    for (size_t i = 0; i < book->instrumentCount(); ++i) {
+        double weight = i < benchmark.size() ? benchmark[i].weight : 0.0;
+        instruments.push_back({book->instrument(i), weight});
+        m_benchmarkWeight[i] = weight;
+    }
+    m_limits->bind(instruments, m_binding);
+    m_book = std::move(book);
+}
+
+void PortfolioRiskService::setCovariance(const CovarianceSnapshot& covariance, double periodsPerYear) {
+    if (!m_book) {
+        throw std::runtime_error("设置协方差前须先加载组合持仓");
+    }
+    std::vector<std::string> codes;
+    codes.reserve(m_book->instrumentCount());
+    for (size_t i = 0; i < m_book->instrumentCount(); ++i) {
+        codes.push_back(m_book->instrument(i).code);
+    }
+
+    m_n = codes.size();
+    m_sigma = covariance.dense(codes);
+    for (double& v : m_sigma) {
+        v *= periodsPerYear;
+    }
+
+    // Σb 与 bᵀΣb
+    m_sigmaB.assign(m_n, 0.0);
+    m_benchmarkVariance = 0.0;
+    for (size_t i = 0; i < m_n; ++i) {
+        const double* row = &m_sigma[i * m_n];
+        double s = 0.0;
+        for (size_t j = 0; j < m_n; ++j) {
+            s += row[j] * m_benchmarkWeight[j];
+        }
+        m_sigmaB[i] = s;
+        m_benchmarkVariance += m_benchmarkWeight[i] * s;
+    }
+    m_hasCovariance = true;
+}
+
+double PortfolioRiskService::trackingError(size_t p) const {
+    if (!m_hasCovariance) {
+        return -1.0;
+    }
+    const uint32_t* comp = m_book->components();
+    const double* weight = m_book->weights();
+    const size_t begin = m_book->begin(p);
+    const size_t end = m_book->end(p);
+
+    // 仅遍历下三角：wᵀΣw = 2·Σ_a w_a(½w_aΣ_aa + Σ_{b<a} w_bΣ_ab)
+    double quad = 0.0;
+    double cross = 0.0;
+    for (size_t a = begin; a < end; ++a) {
+        const double* row = &m_sigma[static_cast<size_t>(comp[a]) * m_n];
+        double s = 0.5 * weight[a] * row[comp[a]];
+        for (size_t b = begin; b < a; ++b) {
+            s += weight[b] * row[comp[b]];
+        }
+        quad += weight[a] * s;
+        cross += weight[a] * m_sigmaB[comp[a]];
+    }
+    double variance = 2.0 * quad - 2.0 * cross + m_benchmarkVariance;
+    return std::sqrt(std::max(variance, 0.0));
+}
+
+void PortfolioRiskService::evaluateRange(size_t lo, size_t hi, double* exposure,
+                                         PortfolioBreachBatch& out) const {
+    const RiskLimitTable& limits = *m_limits;
+    const uint32_t* comp = m_book->components();
+    const double* weight = m_book->weights();
+    const double positionWarning = limits.positionWarning();
+    const double positionCritical = limits.positionCritical();
+
+    for (size_t p = lo; p < hi; ++p) {
+        const uint32_t id = static_cast<uint32_t>(p);
+        const size_t begin = m_book->begin(p);
+        const size_t end = m_book->end(p);
+
+        // 单只权重并累计行业/区域暴露
+        for (size_t h = begin; h < end; ++h) {
+            const double w = weight[h];
+            if (uint8_t level = levelOf(w, positionWarning, positionCritical)) {
+                out.push(id, AlertType::PositionConcentration,
+                         level >= 2 ? AlertLevel::Critical : AlertLevel::Warning, comp[h], w,
+                         level >= 2 ? positionCritical : positionWarning);
+            }
+            if (m_binding.sector_limit[comp[h]] != SymbolTable::npos) {
+                exposure[m_binding.sector_limit[comp[h]]] += w;
+            }
+            if (m_binding.region_limit[comp[h]] != SymbolTable::npos) {
+                exposure[m_binding.region_limit[comp[h]]] += w;
+            }
+        }
+
+        // 仅检查本组合触及的限额，检查后清零（同一限额再次出现时已为0而跳过）
+        for (size_t h = begin; h < end; ++h) {
+            for (uint32_t j : {m_binding.sector_limit[comp[h]], m_binding.region_limit[comp[h]]}) {
+                if (j == SymbolTable::npos || exposure[j] == 0.0) {
+                    continue;
+                }
+                const double e = exposure[j];
+                exposure[j] = 0.0;
+                if (uint8_t level = levelOf(e, limits.warning(j), limits.critical(j))) {
+                    out.push(id, limits.scope(j) == LimitScope::Sector ? AlertType::SectorConcentration
+                                                                       : AlertType::RegionConcentration,
+                             level >= 2 ? AlertLevel::Critical : AlertLevel::Warning, j, e,
+                             level >= 2 ? limits.critical(j) : limits.warning(j));
+                }
+            }
+        }
+
+        if (m_hasCovariance) {
+            const double te = trackingError(p);
+            if (uint8_t level = levelOf(te, limits.trackingErrorWarning(), limits.trackingErrorCritical())) {
+                out.push(id, AlertType::TrackingError,
+                         level >= 2 ? AlertLevel::Critical : AlertLevel::Warning, 0, te,
+                         level >= 2 ? limits.trackingErrorCritical() : limits.trackingErrorWarning());
+            }
+        }
+    }
+}
+
+const PortfolioBreachBatch& PortfolioRiskService::evaluate(ThreadPool& pool) {
+    auto started = std::chrono::steady_clock::now();
+    m_batch.clear();
+    if (!m_book) {
+        m_batch.portfolios = 0;
+        m_batch.elapsed_ms = 0.0;
+        return m_batch;
+    }
+
+    const size_t count = m_book->size();
+    const size_t chunks = (count + kGrain - 1) / kGrain;
+    if (m_chunks.size() < chunks) {
+        m_chunks.resize(chunks);
+    }
+    m_exposure.resize(pool.size());
+    for (auto& exposure : m_exposure) {
+        exposure.assign(m_limits->size(), 0.0);
+    }
+
+    // 动态分块：空闲线程从共享计数器领取下一块，持仓数不均时自动均衡
+    pool.parallelFor(0, count, kGrain, [&](size_t lo, size_t hi, size_t worker) {
+        // 串行回退时整个区间作为一次调用，按块拆分以保持各块暂存独立
+        for (size_t base = lo; base < hi; base += kGrain) {
+            PortfolioBreachBatch& out = m_chunks[base / kGrain];
+            out.clear();
+            evaluateRange(base, std::min(hi, base + kGrain), m_exposure[worker].data(), out);
+        }
+    });
+
+    for (size_t c = 0; c < chunks; ++c) {
+        m_batch.append(m_chunks[c]);
+    }
+    m_batch.portfolios = count;
+    m_batch.threads = pool.size();
+    m_batch.elapsed_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - started).count();
+    return m_batch;
+}
+
+AlertEvent PortfolioRiskService::toAlert(const PortfolioBreachBatch& batch, size_t k) const {
+    // 展示为 "组合 持仓代码/限额名称"，同一组合的不同越限项互不去重
+    std::string label = m_book->id(batch.portfolio[k]);
+    switch (batch.type[k]) {
+    case AlertType::PositionConcentration:
+        label += " " + m_book->instrument(batch.index[k]).code;
+        break;
+    case AlertType::SectorConcentration:
+    case AlertType::RegionConcentration:
+        label += " " + m_limits->name(batch.index[k]);
+        break;
+    default:
+        break;
+    }
+
+    // 去重对象截断后不同越限项可能相同，放不下时取摘要
+    std::string subject = label;
+    if (subject.size() >= sizeof(AlertEvent::subject)) {
+        char digest[24];
+        std::snprintf(digest, sizeof(digest), "#%016" PRIx64,
+                      XxHash64::hash(label.data(), label.size()));
+        subject = digest;
+    }
+    return AlertEvent::make(batch.type[k], batch.level[k], subject, label,
+                            batch.value[k], batch.threshold[k]);
+}
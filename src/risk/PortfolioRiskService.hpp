@@ -0,0 +1,125 @@
+#pragma once
+
+#include "core/CovarianceEngine.hpp"
+#include "core/IndexCalculator.hpp"
+#include "risk/AlertBus.hpp"
+#include "risk/RiskLimits.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class ThreadPool;
+
+// 跟踪组合持仓（列式）：各组合持仓按组合分段连续存放，组合内按标的序号升序，权重为占组合净值比例
+// 标的序号先为基准成分（与基准同序），其后为基准外持仓（基准权重为0），按首次出现追加
+class PortfolioBook {
+public:
+    // universe用于补全基准外持仓的行业/区域，未找到的基准外持仓不计入行业/区域暴露
+    explicit PortfolioBook(ComponentSnapshot benchmark, const REITList& universe = {});
+
+    // 追加组合，返回组合序号；同一代码重复出现时权重合并
+    size_t add(const std::string& id, const std::vector<std::pair<std::string, double>>& holdings);
+
+    // 从CSV加载（列：组合,代码,权重；首行为标题），同一组合的行无需相邻
+    void loadFromCSV(const std::string& filename);
+
+    size_t size() const { return m_ids.size(); }
+    size_t holdingCount() const { return m_component.size(); }
+    const std::string& id(size_t p) const { return m_ids[p]; }
+
+    // 第p个组合的持仓区间[begin(p), end(p))
+    size_t begin(size_t p) const { return m_offset[p]; }
+    size_t end(size_t p) const { return m_offset[p + 1]; }
+
+    const uint32_t* components() const { return m_component.data(); }
+    const double* weights() const { return m_weight.data(); }
+
+    const ComponentSnapshot& benchmark() const { return m_benchmark; }
+
+    // 全部标的（基准成分在前，基准外持仓在后）
+    size_t instrumentCount() const { return m_instruments.size(); }
+    const REIT& instrument(size_t i) const { return m_instruments[i]; }
+    size_t offBenchmarkCount() const { return m_instruments.size() - m_benchmark->size(); }
+
+private:
+    ComponentSnapshot m_benchmark;
+    std::unordered_map<std::string, uint32_t> m_index;
+    std::vector<REIT> m_instruments;
+    std::unordered_map<std::string, REIT> m_universe;
+
+    std::vector<std::string> m_ids;
+    std::vector<size_t> m_offset{0};
+    std::vector<uint32_t> m_component;
+    std::vector<double> m_weight;
+};
+
+// 批量越限结果（列式），按组合序号有序
+struct PortfolioBreachBatch {
+    std::vector<uint32_t> portfolio;
+    std::vector<AlertType> type;
+    std::vector<AlertLevel> level;
+    std::vector<uint32_t> index;    // 单只为基准成分序号，行业/区域为限额序号，跟踪误差为0
+    std::vector<double> value;
+    std::vector<double> threshold;
+
+    size_t portfolios = 0;
+    size_t threads = 0;
+    double elapsed_ms = 0.0;
+
+    size_t size() const { return portfolio.size(); }
+    void clear();
+    void push(uint32_t p, AlertType t, AlertLevel l, uint32_t i, double v, double th);
+    void append(const PortfolioBreachBatch& other);
+};
+
+// 多组合风险服务：每轮对全部跟踪组合并行检查单只权重、行业/区域暴露与事前跟踪误差
+// 跟踪误差 TE² = wᵀΣw - 2wᵀ(Σb) + bᵀΣb，Σb与bᵀΣb每次更新协方差时预计算，
+// 每组合成本 O(h²/2)（h为持仓数），与基准成分数无关
+// load/setCovariance/evaluate须由同一调度线程调用
+class PortfolioRiskService {
+public:
+    explicit PortfolioRiskService(std::shared_ptr<const RiskLimitTable> limits);
+
+    // 替换持仓（重建限额绑定与基准权重）
+    void load(std::shared_ptr<const PortfolioBook> book);
+
+    // 更新单期协方差（按periodsPerYear年化）；须在load之后调用，更换持仓后需重新设置
+    // 未设置时不检查跟踪误差
+    void setCovariance(const CovarianceSnapshot& covariance, double periodsPerYear = 250.0);
+
+    // 评估全部组合，返回本轮越限（引用在下次evaluate前有效）
+    const PortfolioBreachBatch& evaluate(ThreadPool& pool);
+
+    // 单个组合的年化跟踪误差（未设置协方差时为-1）
+    double trackingError(size_t p) const;
+
+    // 越限转为警报事件：展示名称为组合编号加持仓代码或限额名称；
+    // 去重对象取同一文本，超出AlertEvent::subject容量时改用其64位摘要
+    AlertEvent toAlert(const PortfolioBreachBatch& batch, size_t k) const;
+
+    const PortfolioBook* book() const { return m_book.get(); }
+
+private:
+    // 评估组合[lo, hi)，越限追加到out；exposure为按限额的清零暂存
+    void evaluateRange(size_t lo, size_t hi, double* exposure, PortfolioBreachBatch& out) const;
+
+    std::shared_ptr<const RiskLimitTable> m_limits;
+    std::shared_ptr<const PortfolioBook> m_book;
+    LimitBinding m_binding;
+    std::vector<double> m_benchmarkWeight;
+
+    // 按标的序号的稠密协方差、Σb与bᵀΣb（已年化）
+    size_t m_n = 0;
+    std::vector<double> m_sigma;
+    std::vector<double> m_sigmaB;
+    double m_benchmarkVariance = 0.0;
+    bool m_hasCovariance = false;
+
+    // 按执行线程的限额暴露暂存与按块的越限暂存，轮次间复用
+    std::vector<std::vector<double>> m_exposure;
+    std::vector<PortfolioBreachBatch> m_chunks;
+    PortfolioBreachBatch m_batch;
+};
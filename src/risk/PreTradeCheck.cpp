@@ -0,0 +1,195 @@
+﻿#include "PreTradeCheck.hpp"
+#include "data/SymbolTable.hpp"
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+namespace {
+    // 0为未越限，1为预警，2为严重
+    uint8_t levelOf(double value, double warning, double critical) {
+        return static_cast<uint8_t>(value >= warning) + static_cast<uint8_t>(value >= critical);
+    }
+
+    // 栈上的（序号, 变化量）暂存
+    struct Delta {
+        uint32_t index;
+        double change;
+    };
+
+    // 在前n项中累加到同一序号，不存在时追加
+    void accumulate(Delta* deltas, size_t& n, uint32_t index, double change) {
+        for (size_t k = 0; k < n; ++k) {
+            if (deltas[k].index == index) {
+                deltas[k].change += change;
+                return;
+            }
+        }
+        deltas[n++] = {index, change};
+    }
+
+    // 负权重容差
+    constexpr double kWeightEpsilon = 1e-12;
+}
+
+PreTradeCheck::PreTradeCheck(ComponentSnapshot components,
+                             std::shared_ptr<const RiskLimitTable> limits, uint64_t version)
+    : m_components(std::move(components)), m_limits(std::move(limits)), m_version(version) {
+    const std::vector<Component>& comps = *m_components;
+    const size_t n = comps.size();
+
+    m_codeIndex.resize(n);
+    std::iota(m_codeIndex.begin(), m_codeIndex.end(), 0u);
+    std::sort(m_codeIndex.begin(), m_codeIndex.end(), [&](uint32_t a, uint32_t b) {
+        return comps[a].reit.code < comps[b].reit.code;
+    });
+    m_codes.reserve(n);
+    for (uint32_t i : m_codeIndex) {
+        m_codes.push_back(comps[i].reit.code);
+    }
+
+    m_weights.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        m_weights[i] = comps[i].weight;
+        m_total += comps[i].weight;
+    }
+    if (m_total <= 0.0) {
+        m_total = 1.0;
+    }
+
+    m_byWeight.resize(n);
+    std::iota(m_byWeight.begin(), m_byWeight.end(), 0u);
+    std::sort(m_byWeight.begin(), m_byWeight.end(), [&](uint32_t a, uint32_t b) {
+        return m_weights[a] > m_weights[b];
+    });
+
+    m_limits->bind(comps, m_binding);
+    m_exposure.assign(m_limits->size(), 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        if (m_binding.sector_limit[i] != SymbolTable::npos) {
+            m_exposure[m_binding.sector_limit[i]] += m_weights[i];
+        }
+        if (m_binding.region_limit[i] != SymbolTable::npos) {
+            m_exposure[m_binding.region_limit[i]] += m_weights[i];
+        }
+    }
+}
+
+uint32_t PreTradeCheck::find(std::string_view code) const {
+    auto it = std::lower_bound(m_codes.begin(), m_codes.end(), code);
+    if (it == m_codes.end() || *it != code) {
+        return SymbolTable::npos;
+    }
+    return m_codeIndex[it - m_codes.begin()];
+}
+
+void PreTradeCheck::check(std::span<const WeightChange> changes, WhatIfResult& result) const {
+    const RiskLimitTable& limits = *m_limits;
+    const std::vector<Component>& comps = *m_components;
+
+    result.status = WhatIfStatus::Ok;
+    result.version = m_version;
+    result.unmatched = 0;
+    result.count = 0;
+    if (changes.size() > kMaxChanges) {
+        result.status = WhatIfStatus::TooManyChanges;
+        return;
+    }
+
+    // 解析代码并合并同一成分，按序号排序以便二分判断是否被触及
+    std::array<Delta, kMaxChanges> positions;
+    size_t touched = 0;
+    double net = 0.0;
+    for (const auto& change : changes) {
+        uint32_t i = find(change.code);
+        if (i == SymbolTable::npos) {
+            ++result.unmatched;
+            continue;
+        }
+        accumulate(positions.data(), touched, i, change.delta);
+        net += change.delta;
+    }
+    std::sort(positions.begin(), positions.begin() + touched,
+              [](const Delta& a, const Delta& b) { return a.index < b.index; });
+
+    const double total = m_total + net;
+    if (total <= 0.0) {
+        result.status = WhatIfStatus::InvalidWeight;
+        return;
+    }
+
+    auto record = [&](AlertType type, uint8_t level, uint8_t before, const std::string& subject,
+                      const std::string& label, double value, double warning, double critical) {
+        if (level == 0) {
+            return;
+        }
+        if (result.count < WhatIfResult::kCapacity) {
+            WhatIfBreach& breach = result.breaches[result.count];
+            breach.event = AlertEvent::make(type, level >= 2 ? AlertLevel::Critical : AlertLevel::Warning,
+                                            subject, label, value, level >= 2 ? critical : warning);
+            breach.introduced = level > before;
+        }
+        ++result.count;
+    };
+
+    // 被触及的单只，同时归集所属行业/区域的变化量
+    std::array<Delta, kMaxChanges * 2> groups;
+    size_t groupCount = 0;
+    for (size_t k = 0; k < touched; ++k) {
+        const uint32_t i = positions[k].index;
+        const double w = m_weights[i] + positions[k].change;
+        if (w < -kWeightEpsilon) {
+            result.status = WhatIfStatus::InvalidWeight;
+            result.count = 0;
+            return;
+        }
+        record(AlertType::PositionConcentration,
+               levelOf(w / total, limits.positionWarning(), limits.positionCritical()),
+               levelOf(m_weights[i] / m_total, limits.positionWarning(), limits.positionCritical()),
+               comps[i].reit.code, comps[i].reit.name, w / total,
+               limits.positionWarning(), limits.positionCritical());
+
+        if (m_binding.sector_limit[i] != SymbolTable::npos) {
+            accumulate(groups.data(), groupCount, m_binding.sector_limit[i], positions[k].change);
+        }
+        if (m_binding.region_limit[i] != SymbolTable::npos) {
+            accumulate(groups.data(), groupCount, m_binding.region_limit[i], positions[k].change);
+        }
+    }
+
+    // 未触及的单只仅随总权重缩放，按权重降序扫描至低于预警线
+    auto isTouched = [&](uint32_t i) {
+        return std::binary_search(positions.begin(), positions.begin() + touched, Delta{i, 0.0},
+                                  [](const Delta& a, const Delta& b) { return a.index < b.index; });
+    };
+    for (uint32_t i : m_byWeight) {
+        const double w = m_weights[i] / total;
+        if (w < limits.positionWarning()) {
+            break;
+        }
+        if (isTouched(i)) {
+            continue;
+        }
+        record(AlertType::PositionConcentration,
+               levelOf(w, limits.positionWarning(), limits.positionCritical()),
+               levelOf(m_weights[i] / m_total, limits.positionWarning(), limits.positionCritical()),
+               comps[i].reit.code, comps[i].reit.name, w,
+               limits.positionWarning(), limits.positionCritical());
+    }
+
+    // 行业/区域：合计叠加变化量后按新总权重归一
+    std::sort(groups.begin(), groups.begin() + groupCount,
+              [](const Delta& a, const Delta& b) { return a.index < b.index; });
+    size_t next = 0;
+    for (size_t j = 0; j < limits.size(); ++j) {
+        double exposure = m_exposure[j];
+        if (next < groupCount && groups[next].index == j) {
+            exposure += groups[next++].change;
+        }
+        const std::string& name = limits.name(j);
+        record(limits.scope(j) == LimitScope::Sector ? AlertType::SectorConcentration
+                                                     : AlertType::RegionConcentration,
+               levelOf(exposure / total, limits.warning(j), limits.critical(j)),
+               levelOf(m_exposure[j] / m_total, limits.warning(j), limits.critical(j)),
+               name, name, exposure / total, limits.warning(j), limits.critical(j));
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "core/IndexCalculator.hpp"
+#include "risk/AlertBus.hpp"
+#include "risk/RiskLimits.hpp"
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// 拟交易的权重变化（代码须为当前成分）
+struct WeightChange {
+    std::string_view code;
+    double delta = 0.0;
+};
+
+enum class WhatIfStatus : uint8_t {
+    Ok,
+    NoSnapshot,         // 尚无成分快照
+    TooManyChanges,     // 变化条数超过 PreTradeCheck::kMaxChanges
+    InvalidWeight       // 变更后出现负权重或总权重非正
+};
+
+// 变更后的单项越限
+struct WhatIfBreach {
+    AlertEvent event;
+    bool introduced = false;    // 当前未越限或级别较低，由本次变更引入/加重
+};
+
+// 假设检查结果（定长，调用方可在栈上或按线程复用）
+struct WhatIfResult {
+    static constexpr size_t kCapacity = 32;
+
+    WhatIfStatus status = WhatIfStatus::Ok;
+    uint64_t version = 0;       // 所依据的基准版本
+    uint32_t unmatched = 0;     // 非成分代码条数（已忽略）
+    uint32_t count = 0;         // 越限总数，超出容量部分不保存
+    WhatIfBreach breaches[kCapacity];
+
+    size_t stored() const { return count < kCapacity ? count : kCapacity; }
+    bool breached() const { return count > 0; }
+
+    // 是否存在由本次变更引入/加重的越限
+    bool introduced() const {
+        for (size_t k = 0; k < stored(); ++k) {
+            if (breaches[k].introduced) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// 交易前假设检查基准：成分权重、限额绑定与行业/区域合计的只读快照
+// 发布后不再修改，check()不分配堆内存、不加锁，可被任意线程并发调用
+// 变更后权重为 (w_i + Δ_i) / (1 + ΣΔ)；仅重算被触及的单只与限额，
+// 其余单只沿权重降序扫描至低于预警线为止，行业/区域按限额数线性重算
+class PreTradeCheck {
+public:
+    static constexpr size_t kMaxChanges = 64;
+
+    PreTradeCheck(ComponentSnapshot components, std::shared_ptr<const RiskLimitTable> limits,
+                  uint64_t version);
+
+    // 叠加权重变化并检查全部限额，越限写入result（含变更前已存在的越限）
+    void check(std::span<const WeightChange> changes, WhatIfResult& result) const;
+
+    uint64_t version() const { return m_version; }
+    const ComponentSnapshot& components() const { return m_components; }
+
+private:
+    // 代码对应的成分序号（不存在返回npos）
+    uint32_t find(std::string_view code) const;
+
+    ComponentSnapshot m_components;
+    std::shared_ptr<const RiskLimitTable> m_limits;
+    uint64_t m_version;
+
+    // 按代码排序的视图（指向快照内字符串）及对应成分序号
+    std::vector<std::string_view> m_codes;
+    std::vector<uint32_t> m_codeIndex;
+
+    std::vector<double> m_weights;
+    std::vector<uint32_t> m_byWeight;       // 按权重降序的成分序号
+    LimitBinding m_binding;
+    std::vector<double> m_exposure;
+    double m_total = 0.0;
+};
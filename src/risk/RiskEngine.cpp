@@ -1,13 +1,18 @@
 ﻿#include "RiskEngine.hpp"
 #include <algorithm>
-#include <chrono>
 #include <cmath>
 #include <iostream>
 
-RiskEngine::RiskEngine() {
-    m_alertCallback = [](const std::string& msg) {
+namespace {
+    // 假设检查基准版本（进程内全局递增，跨引擎实例唯一）
+    std::atomic<uint64_t> g_preTradeVersion{0};
+}
+
+RiskEngine::RiskEngine()
+    : m_limits(std::make_shared<const RiskLimitTable>(RiskLimitTable::fromRules(json::object()))) {
+    setAlertCallback([](const std::string& msg) {
         std::cerr << "[风险告警] " << msg << std::endl;
-    };
+    });
 }
 
 RiskEngine::~RiskEngine() {
@@ -17,6 +22,7 @@ RiskEngine::~RiskEngine() {
 }
 
 void RiskEngine::startMonitoring() {
+    std::lock_guard lock(m_mutex);
     if (!m_running) {
         m_running = true;
         m_monitoringThread = std::thread(&RiskEngine::monitoringThread, this);
@@ -24,104 +30,214 @@ void RiskEngine::startMonitoring() {
 }
 
 void RiskEngine::stopMonitoring() {
-    m_running = false;
+    {
+        std::lock_guard lock(m_mutex);
+        m_running = false;
+    }
+    m_wake.notify_all();
     if (m_monitoringThread.joinable()) {
         m_monitoringThread.join();
     }
 }
 
 void RiskEngine::monitoringThread() {
-    using namespace std::chrono_literals;
+    uint64_t evaluated = 0;
     
-    while (m_running) {
-        std::this_thread::sleep_for(1s);
-        
-        std::vector<Component> current;
+    while (true) {
         {
-            std::lock_guard lock(m_mutex);
-            if (!m_currentComponents.empty()) {
-                current = m_currentComponents;
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [&] {
+                return !m_running || m_publishedVersion != evaluated;
+            });
+            if (!m_running) {
+                return;
             }
+            evaluated = m_publishedVersion;
         }
         
-        if (!current.empty()) {
-            performRiskCheck(current);
+        ComponentSnapshot snapshot = m_snapshot.load(std::memory_order_acquire);
+        if (snapshot) {
+            publishPreTrade(snapshot);
+            evaluate(*snapshot);
         }
     }
 }
 
-void RiskEngine::setAlertCallback(AlertCallback callback) {
-    std::lock_guard lock(m_mutex);
-    m_alertCallback = callback;
+void RiskEngine::setAlertCallback(AlertCallback callback, SubscriberOptions options) {
+    std::lock_guard lock(m_callbackMutex);
+    if (m_callbackSubscription) {
+        m_alerts.unsubscribe(m_callbackSubscription);
+        m_callbackSubscription = 0;
+    }
+    if (callback) {
+        m_callbackSubscription = m_alerts.subscribe(
+            [callback = std::move(callback)](const AlertEvent& event) {
+                callback(formatAlert(event));
+            }, options);
+    }
+}
+
+uint64_t RiskEngine::subscribeAlerts(AlertBus::Handler handler, SubscriberOptions options) {
+    return m_alerts.subscribe(std::move(handler), options);
+}
+
+void RiskEngine::unsubscribeAlerts(uint64_t id) {
+    m_alerts.unsubscribe(id);
 }
 
 void RiskEngine::performRiskCheck(const std::vector<Component>& components) {
+    performRiskCheck(std::make_shared<const std::vector<Component>>(components));
+}
+
+void RiskEngine::performRiskCheck(ComponentSnapshot snapshot) {
+    m_snapshot.store(snapshot, std::memory_order_release);
+    
     {
         std::lock_guard lock(m_mutex);
-        m_currentComponents = components;
+        if (m_running) {
+            ++m_publishedVersion;
+            m_wake.notify_one();
+            return;
+        }
     }
     
-    checkPositionConcentration(components);
-    checkSectorConcentration(components);
-    checkVolatility(components);
+    publishPreTrade(snapshot);
+    evaluate(*snapshot);
 }
 
-void RiskEngine::triggerCircuitBreaker() {
-    if (m_alertCallback) {
-        m_alertCallback("系统熔断已触发！暂停所有交易操作");
+void RiskEngine::loadLimits(const json& rules) {
+    m_limits.store(std::make_shared<const RiskLimitTable>(RiskLimitTable::fromRules(rules)),
+                   std::memory_order_release);
+    m_breaker.configure(BreakerSettings::fromRules(rules));
+    
+    if (ComponentSnapshot snapshot = m_snapshot.load(std::memory_order_acquire)) {
+        publishPreTrade(std::move(snapshot));
     }
 }
 
-void RiskEngine::checkPositionConcentration(const std::vector<Component>& components) {
-    const double WARNING_THRESHOLD = 0.08;
-    const double CRITICAL_THRESHOLD = 0.1;
-    
-    for (const auto& comp : components) {
-        if (comp.weight >= CRITICAL_THRESHOLD && m_alertCallback) {
-            m_alertCallback("REIT超限警告: " + comp.reit.name + 
-                            " 权重: " + std::to_string(comp.weight * 100) + "%");
-        } else if (comp.weight >= WARNING_THRESHOLD && m_alertCallback) {
-            m_alertCallback("REIT接近超限: " + comp.reit.name + 
-                            " 权重: " + std::to_string(comp.weight * 100) + "%");
+void RiskEngine::publishPreTrade(ComponentSnapshot snapshot) {
+    auto check = std::make_shared<const PreTradeCheck>(
+        std::move(snapshot), m_limits.load(std::memory_order_acquire),
+        g_preTradeVersion.fetch_add(1, std::memory_order_relaxed) + 1);
+    m_preTrade.store(std::move(check), std::memory_order_release);
+}
+
+void RiskEngine::whatIf(std::span<const WeightChange> changes, WhatIfResult& result) const {
+    // 基准与其版本号同在一个对象内经单一原子指针发布，结果中的版本即所用基准的版本
+    std::shared_ptr<const PreTradeCheck> check = m_preTrade.load(std::memory_order_acquire);
+    if (!check) {
+        result.status = WhatIfStatus::NoSnapshot;
+        result.version = 0;
+        result.unmatched = 0;
+        result.count = 0;
+        return;
+    }
+    check->check(changes, result);
+}
+
+void RiskEngine::evaluate(const std::vector<Component>& components) {
+    checkLimits(components);
+    checkVolatility();
+}
+
+void RiskEngine::resetTickLimits(ComponentSnapshot snapshot) {
+    m_tickLimits = std::make_unique<TickLimitMonitor>(m_limits.load(std::memory_order_acquire));
+    m_transitions.clear();
+    m_tickLimits->reset(snapshot, m_transitions);
+    publishTransitions(*m_tickLimits);
+}
+
+void RiskEngine::onPriceTick(const std::string& code, double marketCap) {
+    if (!m_tickLimits) {
+        return;
+    }
+    m_transitions.clear();
+    if (m_tickLimits->onPrice(code, marketCap, m_transitions)) {
+        publishTransitions(*m_tickLimits);
+    }
+}
+
+void RiskEngine::publishTransitions(const TickLimitMonitor& monitor) {
+    for (const auto& t : m_transitions) {
+        if (t.type == AlertType::PositionConcentration) {
+            const REIT& reit = (*monitor.components())[t.index].reit;
+            m_alerts.publish(AlertEvent::make(t.type, t.level, reit.code, reit.name,
+                                              t.value, t.threshold));
+        } else {
+            const std::string& name = monitor.limits().name(t.index);
+            m_alerts.publish(AlertEvent::make(t.type, t.level, name, name, t.value, t.threshold));
         }
     }
 }
 
-void RiskEngine::checkSectorConcentration(const std::vector<Component>& components) {
-    const std::vector<std::pair<std::string, double>> LIMITS = {
-        {"物流仓储", 0.3},
-        {"产业园区", 0.25},
-        {"高速公路", 0.2},
-        {"保障房", 0.15}
-    };
+TripReason RiskEngine::onIndexTick(double level) {
+    TripReason reason = m_breaker.onTick(level);
+    if (reason == TripReason::Drawdown) {
+        m_alerts.publish(AlertEvent::make(AlertType::CircuitBreaker, AlertLevel::Critical,
+                                          "INDEX", "日内回撤", m_breaker.drawdown(),
+                                          m_breaker.settings().max_drawdown));
+    } else if (reason == TripReason::TickMove) {
+        m_alerts.publish(AlertEvent::make(AlertType::CircuitBreaker, AlertLevel::Critical,
+                                          "INDEX", "单笔跳变", m_breaker.lastMove(),
+                                          m_breaker.settings().max_tick_move));
+    }
+    return reason;
+}
+
+void RiskEngine::triggerCircuitBreaker() {
+    if (m_breaker.trip(TripReason::Manual)) {
+        m_alerts.publish(AlertEvent::make(AlertType::CircuitBreaker, AlertLevel::Critical,
+                                          "MANUAL", "人工触发", 0.0, 0.0));
+    }
+}
+
+void RiskEngine::checkLimits(const std::vector<Component>& components) {
+    std::shared_ptr<const RiskLimitTable> limits = m_limits.load(std::memory_order_acquire);
     
-    SectorMap sectorTotals;
-    for (const auto& comp : components) {
-        sectorTotals[comp.reit.sector] += comp.weight;
+    thread_local LimitBinding binding;
+    thread_local std::vector<double> weights;
+    thread_local LimitBreaches breaches;
+    limits->bind(components, binding);
+    weights.resize(components.size());
+    for (size_t i = 0; i < components.size(); ++i) {
+        weights[i] = components[i].weight;
     }
+    limits->evaluate(weights.data(), binding, breaches);
     
-    for (const auto& [sector, limit] : LIMITS) {
-        auto it = sectorTotals.find(sector);
-        if (it != sectorTotals.end() && it->second >= limit) {
-            if (m_alertCallback) {
-                m_alertCallback("行业集中度警告: " + sector + 
-                                " 总权重: " + std::to_string(it->second * 100) + "%");
+    limits->forEachBreach(breaches, weights.data(),
+        [&](AlertType type, AlertLevel level, size_t index, double value, double threshold) {
+            if (type == AlertType::PositionConcentration) {
+                const REIT& reit = components[index].reit;
+                m_alerts.publish(AlertEvent::make(type, level, reit.code, reit.name, value, threshold));
+            } else {
+                const std::string& name = limits->name(index);
+                m_alerts.publish(AlertEvent::make(type, level, name, name, value, threshold));
             }
-        }
-    }
+        });
 }
 
-void RiskEngine::checkVolatility(const std::vector<Component>& components) {
-    // 计算平均波动率（简化版）
-    double avg_volatility = 0.0;
-    for (const auto& comp : components) {
-        // 模拟波动率计算（实际应使用历史数据）
-        avg_volatility += 0.05 * (0.8 + 0.4 * (comp.weight - 0.05));
+void RiskEngine::checkVolatility() {
+    std::shared_ptr<const VolatilitySnapshot> volatility = m_volatility.load(std::memory_order_acquire);
+    if (!volatility) {
+        return;
     }
-    avg_volatility /= components.size();
+    std::shared_ptr<const RiskLimitTable> limits = m_limits.load(std::memory_order_acquire);
     
-    if (avg_volatility > 0.15 && m_alertCallback) {
-        m_alertCallback("波动率过高警告: " + 
-                        std::to_string(avg_volatility * 100) + "%");
+    // 滚动窗口未满时不告警
+    size_t window = limits->volatilityWindow();
+    if (volatility->indexObservations() < std::max<size_t>(window, 2)) {
+        return;
+    }
+    double vol = volatility->indexVolatility(window);
+    if (vol < 0.0) {
+        return;
     }
-}
\ No newline at end of file
+    
+    if (vol >= limits->volatilityCritical()) {
+        m_alerts.publish(AlertEvent::make(AlertType::Volatility, AlertLevel::Critical,
+                                          "INDEX", "指数", vol, limits->volatilityCritical()));
+    } else if (vol >= limits->volatilityWarning()) {
+        m_alerts.publish(AlertEvent::make(AlertType::Volatility, AlertLevel::Warning,
+                                          "INDEX", "指数", vol, limits->volatilityWarning()));
+    }
+}
@@ -1,8 +1,15 @@
 #pragma once
 
 #include "core/IndexCalculator.hpp"
+#include "risk/AlertBus.hpp"
+#include "risk/CircuitBreaker.hpp"
+#include "risk/PreTradeCheck.hpp"
+#include "risk/RiskLimits.hpp"
+#include "risk/TickLimitMonitor.hpp"
+#include "risk/VolatilityEngine.hpp"
 #include <vector>
 #include <atomic>
+#include <condition_variable>
 #include <functional>
 #include <thread>
 #include <mutex>
@@ -21,27 +28,89 @@ public:
     // 停止风险监控
     void stopMonitoring();
     
-    // 设置风险回调
-    void setAlertCallback(AlertCallback callback);
+    // 设置风险回调（替换上一回调，文本在分发线程格式化）
+    void setAlertCallback(AlertCallback callback, SubscriberOptions options = {});
     
-    // 手动检查风险
+    // 订阅结构化警报（可多订阅者并存）
+    uint64_t subscribeAlerts(AlertBus::Handler handler, SubscriberOptions options = {});
+    void unsubscribeAlerts(uint64_t id);
+    
+    // 等待已产生的警报全部送达
+    void flushAlerts() { m_alerts.flush(); }
+    
+    // 检查风险：监控运行时发布快照由监控线程立即评估，否则在调用线程同步评估
     void performRiskCheck(const std::vector<Component>& components);
     
+    // 发布共享快照（免复制）
+    void performRiskCheck(ComponentSnapshot snapshot);
+    
+    // 最近一次发布的成分快照
+    ComponentSnapshot currentComponents() const {
+        return m_snapshot.load(std::memory_order_acquire);
+    }
+    
+    // 加载风险限额（从规则配置编译，监控运行中亦可替换）与熔断阈值
+    void loadLimits(const json& rules);
+    
+    // 更新波动率快照（供波动率检查使用）
+    void updateVolatility(std::shared_ptr<const VolatilitySnapshot> volatility) {
+        m_volatility.store(std::move(volatility), std::memory_order_release);
+    }
+    
+    // 逐笔限额：以成分快照重建增量监控（与onPriceTick须由同一行情线程调用）
+    void resetTickLimits(ComponentSnapshot snapshot);
+    
+    // 成分最新市值：增量更新所属合计，越限级别升高时发布警报
+    void onPriceTick(const std::string& code, double marketCap);
+    
+    // 每笔指数点位：推进熔断状态机，自动触发时发布警报
+    TripReason onIndexTick(double level);
+    
+    // 交易前假设检查：在最近一次评估的成分权重上叠加权重变化，返回变更后越限
+    // 不分配堆内存，可由任意多个线程并发调用；每次调用原子取得一次当前基准
+    void whatIf(std::span<const WeightChange> changes, WhatIfResult& result) const;
+    
     // 强制熔断
     void triggerCircuitBreaker();
     
+    // 熔断器（下游循环以 halted() 检查）
+    CircuitBreaker& circuitBreaker() { return m_breaker; }
+    const CircuitBreaker& circuitBreaker() const { return m_breaker; }
+    
 private:
-    // 风险监控线程
+    // 风险监控线程：按版本唤醒，每个版本至多评估一次（积压时仅评估最新版本）
     void monitoringThread();
     
+    // 执行全部风险检查
+    void evaluate(const std::vector<Component>& components);
+    
     // 检查具体风险
-    void checkPositionConcentration(const std::vector<Component>& components);
-    void checkSectorConcentration(const std::vector<Component>& components);
-    void checkVolatility(const std::vector<Component>& components);
+    void checkLimits(const std::vector<Component>& components);
+    void checkVolatility();
+    
+    // 以成分快照与当前限额重建假设检查基准
+    void publishPreTrade(ComponentSnapshot snapshot);
+    
+    // 发布逐笔限额的越限变化
+    void publishTransitions(const TickLimitMonitor& monitor);
     
     std::thread m_monitoringThread;
     std::atomic<bool> m_running{false};
     std::mutex m_mutex;
-    AlertCallback m_alertCallback;
-    std::vector<Component> m_currentComponents;
+    std::condition_variable m_wake;
+    uint64_t m_publishedVersion = 0;
+    std::atomic<ComponentSnapshot> m_snapshot;
+    std::atomic<std::shared_ptr<const RiskLimitTable>> m_limits;
+    std::atomic<std::shared_ptr<const VolatilitySnapshot>> m_volatility;
+    
+    // 假设检查基准（版本号全局唯一，保存在基准对象内，与基准一同发布）
+    std::atomic<std::shared_ptr<const PreTradeCheck>> m_preTrade;
+    
+    std::unique_ptr<TickLimitMonitor> m_tickLimits;
+    std::vector<LimitTransition> m_transitions;
+    
+    CircuitBreaker m_breaker;
+    AlertBus m_alerts;
+    std::mutex m_callbackMutex;
+    uint64_t m_callbackSubscription = 0;
 };
\ No newline at end of file
@@ -0,0 +1,154 @@
+﻿#include "RiskLimits.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+    // 按64位字生成 values[i] >= thresholds[i] 的位图，内层无分支便于向量化
+    void compareBits(const double* values, const double* thresholds, size_t n, uint64_t* out) {
+        for (size_t word = 0; word * 64 < n; ++word) {
+            size_t base = word * 64;
+            size_t len = std::min<size_t>(64, n - base);
+            uint64_t bits = 0;
+            for (size_t b = 0; b < len; ++b) {
+                bits |= static_cast<uint64_t>(values[base + b] >= thresholds[base + b]) << b;
+            }
+            out[word] = bits;
+        }
+    }
+
+    void compareBits(const double* values, double threshold, size_t n, uint64_t* out) {
+        for (size_t word = 0; word * 64 < n; ++word) {
+            size_t base = word * 64;
+            size_t len = std::min<size_t>(64, n - base);
+            uint64_t bits = 0;
+            for (size_t b = 0; b < len; ++b) {
+                bits |= static_cast<uint64_t>(values[base + b] >= threshold) << b;
+            }
+            out[word] = bits;
+        }
+    }
+
+    size_t wordCount(size_t n) {
+        return (n + 63) / 64;
+    }
+}
+
+RiskLimitTable RiskLimitTable::fromRules(const json& rules) {
+    RiskLimitTable table;
+    json cfg = rules.value("risk_limits", json::object());
+
+    json position = cfg.value("position", json::object());
+    table.m_positionWarning = position.value("warning", table.m_positionWarning);
+    table.m_positionCritical = position.value("critical", table.m_positionCritical);
+    if (table.m_positionWarning > table.m_positionCritical) {
+        throw std::runtime_error("单只权重预警线高于严重线");
+    }
+
+    table.m_tickRefreshTolerance = cfg.value("tick_refresh_tolerance", table.m_tickRefreshTolerance);
+
+    json volatility = cfg.value("volatility", json::object());
+    table.m_volatilityWindow = volatility.value("window", table.m_volatilityWindow);
+    table.m_volatilityWarning = volatility.value("warning", table.m_volatilityWarning);
+    table.m_volatilityCritical = volatility.value("critical", table.m_volatilityCritical);
+    if (table.m_volatilityWarning > table.m_volatilityCritical) {
+        throw std::runtime_error("波动率预警线高于严重线");
+    }
+
+    json trackingError = cfg.value("tracking_error", json::object());
+    table.m_trackingErrorWarning = trackingError.value("warning", table.m_trackingErrorWarning);
+    table.m_trackingErrorCritical = trackingError.value("critical", table.m_trackingErrorCritical);
+    if (table.m_trackingErrorWarning > table.m_trackingErrorCritical) {
+        throw std::runtime_error("跟踪误差预警线高于严重线");
+    }
+
+    // 指数约束中的行业上限即严重线
+    double ratio = cfg.value("warning_ratio", 0.9);
+    json sectorLimits = rules.value("constraints", json::object())
+                             .value("sector_limits", json::object());
+    for (const auto& item : sectorLimits.items()) {
+        double limit = item.value().get<double>();
+        table.setLimit(LimitScope::Sector, item.key(), limit * ratio, limit);
+    }
+
+    // 显式配置覆盖
+    for (const auto& [key, scope] : {std::pair{"sector", LimitScope::Sector},
+                                     std::pair{"region", LimitScope::Region}}) {
+        json overrides = cfg.value(key, json::object());
+        for (const auto& item : overrides.items()) {
+            double critical = item.value().at("critical").get<double>();
+            double warning = item.value().value("warning", critical * ratio);
+            table.setLimit(scope, item.key(), warning, critical);
+        }
+    }
+    return table;
+}
+
+void RiskLimitTable::setLimit(LimitScope scope, const std::string& name,
+                              double warning, double critical) {
+    if (warning > critical) {
+        throw std::runtime_error("风险限额预警线高于严重线: " + name);
+    }
+
+    SymbolTable& symbols = scope == LimitScope::Sector ? m_sectors : m_regions;
+    std::vector<uint32_t>& index = scope == LimitScope::Sector ? m_sectorLimit : m_regionLimit;
+
+    uint32_t id = symbols.intern(name);
+    if (id >= index.size()) {
+        index.resize(id + 1, SymbolTable::npos);
+    }
+    if (index[id] != SymbolTable::npos) {
+        m_warning[index[id]] = warning;
+        m_critical[index[id]] = critical;
+        return;
+    }
+
+    index[id] = static_cast<uint32_t>(m_key.size());
+    m_key.push_back(id);
+    m_scope.push_back(scope);
+    m_warning.push_back(warning);
+    m_critical.push_back(critical);
+}
+
+const std::string& RiskLimitTable::name(size_t i) const {
+    return m_scope[i] == LimitScope::Sector ? m_sectors.name(m_key[i]) : m_regions.name(m_key[i]);
+}
+
+void RiskLimitTable::bind(const std::vector<Component>& components, LimitBinding& out) const {
+    const size_t n = components.size();
+    out.sector_limit.resize(n);
+    out.region_limit.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t sector = m_sectors.find(components[i].reit.sector);
+        uint32_t region = m_regions.find(components[i].reit.region);
+        out.sector_limit[i] = sector != SymbolTable::npos ? m_sectorLimit[sector] : SymbolTable::npos;
+        out.region_limit[i] = region != SymbolTable::npos ? m_regionLimit[region] : SymbolTable::npos;
+    }
+}
+
+void RiskLimitTable::evaluate(const double* weights, const LimitBinding& binding,
+                              LimitBreaches& out) const {
+    const size_t n = binding.sector_limit.size();
+    const size_t limits = m_key.size();
+
+    // 单趟累计：行业/区域权重直接累加到所属限额
+    out.group_exposure.assign(limits, 0.0);
+    double* exposure = out.group_exposure.data();
+    for (size_t i = 0; i < n; ++i) {
+        if (binding.sector_limit[i] != SymbolTable::npos) {
+            exposure[binding.sector_limit[i]] += weights[i];
+        }
+        if (binding.region_limit[i] != SymbolTable::npos) {
+            exposure[binding.region_limit[i]] += weights[i];
+        }
+    }
+
+    out.position_warning.resize(wordCount(n));
+    out.position_critical.resize(wordCount(n));
+    compareBits(weights, m_positionWarning, n, out.position_warning.data());
+    compareBits(weights, m_positionCritical, n, out.position_critical.data());
+
+    out.group_warning.resize(wordCount(limits));
+    out.group_critical.resize(wordCount(limits));
+    compareBits(exposure, m_warning.data(), limits, out.group_warning.data());
+    compareBits(exposure, m_critical.data(), limits, out.group_critical.data());
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "core/IndexCalculator.hpp"
+#include "data/SymbolTable.hpp"
+#include "risk/AlertBus.hpp"
+#include <bit>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+// 限额维度
+enum class LimitScope : uint8_t {
+    Sector,
+    Region
+};
+
+// 限额检查结果：按位记录越限，供调用方复用以避免重复分配
+struct LimitBreaches {
+    // 单只权重：按成分序号
+    std::vector<uint64_t> position_warning;
+    std::vector<uint64_t> position_critical;
+
+    // 行业/区域：按限额序号
+    std::vector<uint64_t> group_warning;
+    std::vector<uint64_t> group_critical;
+    std::vector<double> group_exposure;
+
+    static bool test(const std::vector<uint64_t>& bits, size_t i) {
+        return (bits[i >> 6] >> (i & 63)) & 1u;
+    }
+};
+
+// 成分到行业/区域限额序号的映射（无限额为npos），同一成分列表可对多组权重复用
+struct LimitBinding {
+    std::vector<uint32_t> sector_limit;
+    std::vector<uint32_t> region_limit;
+};
+
+// 风险限额表：由规则配置编译而成，行业/区域按驻留ID索引，阈值按列连续存放
+// 行业限额取 constraints.sector_limits 为严重线、乘以 warning_ratio 为预警线，
+// risk_limits.sector / risk_limits.region 可逐项覆盖或补充
+class RiskLimitTable {
+public:
+    // 从规则配置编译（缺省时仅含单只权重限额）
+    static RiskLimitTable fromRules(const json& rules);
+
+    // 解析成分所属限额
+    void bind(const std::vector<Component>& components, LimitBinding& out) const;
+
+    // 以给定权重（按成分序号）单趟计算全部暴露并填充越限位图，不访问成分本身
+    void evaluate(const double* weights, const LimitBinding& binding, LimitBreaches& out) const;
+
+    // 遍历越限项：visit(type, level, index, value, threshold)
+    // 单只权重index为成分序号，行业/区域为限额序号；仅遍历置位（严重线必然同时越过预警线）
+    template <typename Visit>
+    void forEachBreach(const LimitBreaches& breaches, const double* weights, Visit&& visit) const {
+        for (size_t word = 0; word < breaches.position_warning.size(); ++word) {
+            for (uint64_t bits = breaches.position_warning[word]; bits; bits &= bits - 1) {
+                size_t i = word * 64 + std::countr_zero(bits);
+                bool critical = LimitBreaches::test(breaches.position_critical, i);
+                visit(AlertType::PositionConcentration,
+                      critical ? AlertLevel::Critical : AlertLevel::Warning, i, weights[i],
+                      critical ? m_positionCritical : m_positionWarning);
+            }
+        }
+        for (size_t word = 0; word < breaches.group_warning.size(); ++word) {
+            for (uint64_t bits = breaches.group_warning[word]; bits; bits &= bits - 1) {
+                size_t j = word * 64 + std::countr_zero(bits);
+                bool critical = LimitBreaches::test(breaches.group_critical, j);
+                visit(m_scope[j] == LimitScope::Sector ? AlertType::SectorConcentration
+                                                       : AlertType::RegionConcentration,
+                      critical ? AlertLevel::Critical : AlertLevel::Warning, j,
+                      breaches.group_exposure[j], critical ? m_critical[j] : m_warning[j]);
+            }
+        }
+    }
+
+    double positionWarning() const { return m_positionWarning; }
+    double positionCritical() const { return m_positionCritical; }
+
+    // 逐笔增量监控的全量重评容差（指数总值相对变化）
+    double tickRefreshTolerance() const { return m_tickRefreshTolerance; }
+
+    // 指数年化波动率限额（window为0表示EWMA）
+    size_t volatilityWindow() const { return m_volatilityWindow; }
+    double volatilityWarning() const { return m_volatilityWarning; }
+    double volatilityCritical() const { return m_volatilityCritical; }
+
+    // 跟踪组合年化事前跟踪误差限额
+    double trackingErrorWarning() const { return m_trackingErrorWarning; }
+    double trackingErrorCritical() const { return m_trackingErrorCritical; }
+
+    size_t size() const { return m_key.size(); }
+    LimitScope scope(size_t i) const { return m_scope[i]; }
+    const std::string& name(size_t i) const;
+    double warning(size_t i) const { return m_warning[i]; }
+    double critical(size_t i) const { return m_critical[i]; }
+
+private:
+    // 添加或覆盖一条限额
+    void setLimit(LimitScope scope, const std::string& name, double warning, double critical);
+
+    double m_positionWarning = 0.08;
+    double m_positionCritical = 0.1;
+
+    double m_tickRefreshTolerance = 0.005;
+
+    size_t m_volatilityWindow = 20;
+    double m_volatilityWarning = 0.2;
+    double m_volatilityCritical = 0.3;
+
+    double m_trackingErrorWarning = 0.03;
+    double m_trackingErrorCritical = 0.05;
+
+    SymbolTable m_sectors;
+    SymbolTable m_regions;
+
+    // 驻留ID -> 限额序号；仅有限额的名称被驻留
+    std::vector<uint32_t> m_sectorLimit;
+    std::vector<uint32_t> m_regionLimit;
+
+    // 按限额序号的列式存储
+    std::vector<uint32_t> m_key;            // 驻留ID
+    std::vector<LimitScope> m_scope;
+    std::vector<double> m_warning;
+    std::vector<double> m_critical;
+};
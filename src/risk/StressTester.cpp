@@ -0,0 +1,151 @@
+﻿#include "StressTester.hpp"
+#include "core/ThreadPool.hpp"
+#include "data/SymbolTable.hpp"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+
+std::vector<StressScenario> StressScenario::fromJson(const json& scenarios) {
+    std::vector<StressScenario> result;
+    for (const auto& item : scenarios) {
+        StressScenario scenario;
+        scenario.name = item.at("name").get<std::string>();
+
+        for (const auto& def : item.at("shocks")) {
+            Shock shock;
+            if (def.contains("sector")) {
+                shock.target = ShockTarget::Sector;
+                shock.key = def["sector"].get<std::string>();
+            } else if (def.contains("region")) {
+                shock.target = ShockTarget::Region;
+                shock.key = def["region"].get<std::string>();
+            } else if (def.contains("code")) {
+                shock.target = ShockTarget::Code;
+                shock.key = def["code"].get<std::string>();
+            } else {
+                throw std::runtime_error("压力情景冲击须指定sector、region或code: " + scenario.name);
+            }
+            shock.change = def.at("change").get<double>();
+            if (shock.change <= -1.0) {
+                throw std::runtime_error("压力情景冲击幅度须大于-100%: " + scenario.name);
+            }
+            scenario.shocks.push_back(std::move(shock));
+        }
+        result.push_back(std::move(scenario));
+    }
+    return result;
+}
+
+std::vector<StressScenario> StressScenario::loadFromFile(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("无法打开压力情景文件: " + filename);
+    }
+    return fromJson(json::parse(file));
+}
+
+StressTester::StressTester(std::shared_ptr<const RiskLimitTable> limits)
+    : m_limits(std::move(limits)) {}
+
+std::vector<StressResult> StressTester::run(const ComponentSnapshot& base,
+                                            const IndexLevels& baseLevels,
+                                            const std::vector<StressScenario>& scenarios,
+                                            ThreadPool& pool) const {
+    const std::vector<Component>& components = *base;
+    const size_t n = components.size();
+
+    // 批次内共享的只读映射：成分所属行业/区域ID、代码序号、限额绑定、基础权重
+    SymbolTable sectors;
+    SymbolTable regions;
+    std::vector<uint32_t> sectorOf(n);
+    std::vector<uint32_t> regionOf(n);
+    std::unordered_map<std::string, size_t> codeIndex;
+    std::vector<double> baseWeights(n);
+    double total = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        sectorOf[i] = sectors.intern(components[i].reit.sector);
+        regionOf[i] = regions.intern(components[i].reit.region);
+        codeIndex.emplace(components[i].reit.code, i);
+        baseWeights[i] = components[i].weight;
+        total += baseWeights[i];
+    }
+    LimitBinding binding;
+    m_limits->bind(components, binding);
+
+    std::vector<StressResult> results(scenarios.size());
+
+    pool.parallelFor(0, scenarios.size(), 16, [&](size_t lo, size_t hi, size_t) {
+        std::vector<double> sectorFactor(sectors.size());
+        std::vector<double> regionFactor(regions.size());
+        std::vector<double> factor(n);
+        std::vector<double> weights(n);
+        LimitBreaches breaches;
+
+        for (size_t k = lo; k < hi; ++k) {
+            const StressScenario& scenario = scenarios[k];
+            StressResult& result = results[k];
+            result.name = scenario.name;
+
+            std::fill(sectorFactor.begin(), sectorFactor.end(), 1.0);
+            std::fill(regionFactor.begin(), regionFactor.end(), 1.0);
+            std::fill(factor.begin(), factor.end(), 1.0);
+
+            for (const auto& shock : scenario.shocks) {
+                double f = 1.0 + shock.change;
+                if (shock.target == ShockTarget::Code) {
+                    auto it = codeIndex.find(shock.key);
+                    if (it == codeIndex.end()) {
+                        ++result.unmatched_shocks;
+                    } else {
+                        factor[it->second] *= f;
+                    }
+                    continue;
+                }
+                const SymbolTable& symbols = shock.target == ShockTarget::Sector ? sectors : regions;
+                uint32_t id = symbols.find(shock.key);
+                if (id == SymbolTable::npos) {
+                    ++result.unmatched_shocks;
+                } else if (shock.target == ShockTarget::Sector) {
+                    sectorFactor[id] *= f;
+                } else {
+                    regionFactor[id] *= f;
+                }
+            }
+
+            // 重估：r_i = f_i - 1，R = Σw_i·r_i，冲击后权重 w_i·f_i / (1 + R)
+            double growth = 0.0;
+            for (size_t i = 0; i < n; ++i) {
+                factor[i] *= sectorFactor[sectorOf[i]] * regionFactor[regionOf[i]];
+                weights[i] = baseWeights[i] * factor[i];
+                growth += weights[i];
+            }
+            result.index_return = total > 0.0 ? growth / total - 1.0 : 0.0;
+            if (growth > 0.0) {
+                for (size_t i = 0; i < n; ++i) {
+                    weights[i] *= total / growth;
+                }
+            }
+
+            result.levels.price = baseLevels.price * (1.0 + result.index_return);
+            result.levels.total_return = baseLevels.total_return * (1.0 + result.index_return);
+            result.levels.net_total_return = baseLevels.net_total_return * (1.0 + result.index_return);
+
+            m_limits->evaluate(weights.data(), binding, breaches);
+            m_limits->forEachBreach(breaches, weights.data(),
+                [&](AlertType type, AlertLevel level, size_t index, double value, double threshold) {
+                    if (type == AlertType::PositionConcentration) {
+                        const REIT& reit = components[index].reit;
+                        result.breaches.push_back(
+                            AlertEvent::make(type, level, reit.code, reit.name, value, threshold));
+                    } else {
+                        const std::string& name = m_limits->name(index);
+                        result.breaches.push_back(
+                            AlertEvent::make(type, level, name, name, value, threshold));
+                    }
+                });
+        }
+    });
+
+    return results;
+}
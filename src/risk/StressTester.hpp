@@ -0,0 +1,59 @@
+#pragma once
+
+#include "core/IndexCalculator.hpp"
+#include "risk/AlertBus.hpp"
+#include "risk/RiskLimits.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+class ThreadPool;
+
+using json = nlohmann::json;
+
+// 冲击对象
+enum class ShockTarget {
+    Sector,
+    Region,
+    Code
+};
+
+// 单项冲击：对象价格变动比例（-0.2表示下跌20%）
+struct Shock {
+    ShockTarget target = ShockTarget::Sector;
+    std::string key;
+    double change = 0.0;
+};
+
+// 压力情景：同一成分命中多项冲击时按 (1+a)(1+b)-1 复合
+struct StressScenario {
+    std::string name;
+    std::vector<Shock> shocks;
+
+    // 解析情景数组：[{"name": ..., "shocks": [{"sector": "物流仓储", "change": -0.2}, ...]}]
+    static std::vector<StressScenario> fromJson(const json& scenarios);
+    static std::vector<StressScenario> loadFromFile(const std::string& filename);
+};
+
+struct StressResult {
+    std::string name;
+    double index_return = 0.0;          // 价格收益
+    IndexLevels levels;                 // 冲击后三条指数点位
+    size_t unmatched_shocks = 0;        // 未命中任何成分的冲击数
+    std::vector<AlertEvent> breaches;   // 冲击后权重下的限额越限
+};
+
+// 压力测试引擎：按情景对成分重估价格与指数点位，并以冲击后权重重跑限额检查
+class StressTester {
+public:
+    explicit StressTester(std::shared_ptr<const RiskLimitTable> limits);
+
+    // 批量并行评估；各情景只读共享基础快照，不复制成分
+    std::vector<StressResult> run(const ComponentSnapshot& base, const IndexLevels& baseLevels,
+                                  const std::vector<StressScenario>& scenarios,
+                                  ThreadPool& pool) const;
+
+private:
+    std::shared_ptr<const RiskLimitTable> m_limits;
+};
@@ -0,0 +1,132 @@
+﻿#include "TickLimitMonitor.hpp"
+#include "data/SymbolTable.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // 0为未越限，1为预警，2为严重
+    uint8_t levelOf(double value, double warning, double critical) {
+        return static_cast<uint8_t>(value >= warning) + static_cast<uint8_t>(value >= critical);
+    }
+
+    AlertLevel alertLevel(uint8_t level) {
+        return level >= 2 ? AlertLevel::Critical : AlertLevel::Warning;
+    }
+}
+
+TickLimitMonitor::TickLimitMonitor(std::shared_ptr<const RiskLimitTable> limits)
+    : m_limits(std::move(limits)) {}
+
+void TickLimitMonitor::reset(const ComponentSnapshot& components, std::vector<LimitTransition>& out) {
+    m_components = components;
+    const std::vector<Component>& comps = *m_components;
+    const size_t n = comps.size();
+
+    m_limits->bind(comps, m_binding);
+    m_index.clear();
+    m_scale.assign(n, 0.0);
+    m_value.assign(n, 0.0);
+    m_positionLevel.assign(n, 0);
+    m_group.assign(m_limits->size(), 0.0);
+    m_groupLevel.assign(m_limits->size(), 0);
+
+    for (size_t i = 0; i < n; ++i) {
+        m_index.emplace(comps[i].reit.code, i);
+        if (comps[i].reit.market_cap > 0.0) {
+            m_scale[i] = comps[i].weight / comps[i].reit.market_cap;
+        }
+        m_value[i] = comps[i].weight;
+    }
+
+    evaluateAll(out);
+}
+
+bool TickLimitMonitor::onPrice(const std::string& code, double marketCap,
+                               std::vector<LimitTransition>& out) {
+    auto it = m_index.find(code);
+    if (it == m_index.end()) {
+        return false;
+    }
+    onPrice(it->second, marketCap, out);
+    return true;
+}
+
+void TickLimitMonitor::onPrice(size_t i, double marketCap, std::vector<LimitTransition>& out) {
+    // 权重按 基准权重 × 市值/基准市值 漂移，差额计入所属合计
+    double value = m_scale[i] * marketCap;
+    double delta = value - m_value[i];
+    m_value[i] = value;
+    m_total += delta;
+
+    uint32_t sector = m_binding.sector_limit[i];
+    uint32_t region = m_binding.region_limit[i];
+    if (sector != SymbolTable::npos) {
+        m_group[sector] += delta;
+    }
+    if (region != SymbolTable::npos) {
+        m_group[region] += delta;
+    }
+
+    // 总值漂移超出容差时其余成分与限额的比例也已明显变化，全量重评并重算合计抵消累计误差
+    if (std::fabs(m_total / m_totalAtRefresh - 1.0) > m_limits->tickRefreshTolerance()) {
+        evaluateAll(out);
+        return;
+    }
+
+    evaluatePosition(i, out);
+    if (sector != SymbolTable::npos) {
+        evaluateGroup(sector, out);
+    }
+    if (region != SymbolTable::npos) {
+        evaluateGroup(region, out);
+    }
+}
+
+void TickLimitMonitor::evaluatePosition(size_t i, std::vector<LimitTransition>& out) {
+    double w = m_value[i] / m_total;
+    uint8_t level = levelOf(w, m_limits->positionWarning(), m_limits->positionCritical());
+    if (level > m_positionLevel[i]) {
+        out.push_back({AlertType::PositionConcentration, alertLevel(level), i, w,
+                       level >= 2 ? m_limits->positionCritical() : m_limits->positionWarning()});
+    }
+    m_positionLevel[i] = level;
+}
+
+void TickLimitMonitor::evaluateGroup(size_t limit, std::vector<LimitTransition>& out) {
+    double e = m_group[limit] / m_total;
+    uint8_t level = levelOf(e, m_limits->warning(limit), m_limits->critical(limit));
+    if (level > m_groupLevel[limit]) {
+        out.push_back({m_limits->scope(limit) == LimitScope::Sector ? AlertType::SectorConcentration
+                                                                    : AlertType::RegionConcentration,
+                       alertLevel(level), limit, e,
+                       level >= 2 ? m_limits->critical(limit) : m_limits->warning(limit)});
+    }
+    m_groupLevel[limit] = level;
+}
+
+void TickLimitMonitor::evaluateAll(std::vector<LimitTransition>& out) {
+    const size_t n = m_value.size();
+
+    m_total = 0.0;
+    std::fill(m_group.begin(), m_group.end(), 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        m_total += m_value[i];
+        if (m_binding.sector_limit[i] != SymbolTable::npos) {
+            m_group[m_binding.sector_limit[i]] += m_value[i];
+        }
+        if (m_binding.region_limit[i] != SymbolTable::npos) {
+            m_group[m_binding.region_limit[i]] += m_value[i];
+        }
+    }
+    if (m_total <= 0.0) {
+        m_total = 1.0;
+    }
+    m_totalAtRefresh = m_total;
+
+    for (size_t i = 0; i < n; ++i) {
+        evaluatePosition(i, out);
+    }
+    for (size_t j = 0; j < m_group.size(); ++j) {
+        evaluateGroup(j, out);
+    }
+}
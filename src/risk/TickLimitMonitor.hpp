@@ -0,0 +1,65 @@
+#pragma once
+
+#include "core/IndexCalculator.hpp"
+#include "risk/AlertBus.hpp"
+#include "risk/RiskLimits.hpp"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 越限级别变化（仅在级别升高时产生）
+struct LimitTransition {
+    AlertType type;
+    AlertLevel level;
+    size_t index;       // 单只为成分序号，行业/区域为限额序号
+    double value;
+    double threshold;
+};
+
+// 逐笔增量限额监控：成分权重随价格漂移，仅按差额调整其所属行业/区域合计，
+// 并只重评该成分及其行业、区域限额，每笔成本与成分数无关
+// 未被触及的限额随指数总值变化而漂移，累计超过 tickRefreshTolerance 时做一次全量重评
+// 非线程安全，须由单一行情线程调用
+class TickLimitMonitor {
+public:
+    explicit TickLimitMonitor(std::shared_ptr<const RiskLimitTable> limits);
+
+    // 以成分快照重建：记录基准权重与市值，全量评估并输出初始越限
+    void reset(const ComponentSnapshot& components, std::vector<LimitTransition>& out);
+
+    // 成分最新市值；越限级别升高时追加到out，未知代码返回false
+    bool onPrice(const std::string& code, double marketCap, std::vector<LimitTransition>& out);
+    void onPrice(size_t i, double marketCap, std::vector<LimitTransition>& out);
+
+    // 当前权重与限额暴露
+    double weight(size_t i) const { return m_value[i] / m_total; }
+    double exposure(size_t limit) const { return m_group[limit] / m_total; }
+
+    const ComponentSnapshot& components() const { return m_components; }
+    const RiskLimitTable& limits() const { return *m_limits; }
+
+private:
+    // 评估单只/单个限额，级别升高时输出
+    void evaluatePosition(size_t i, std::vector<LimitTransition>& out);
+    void evaluateGroup(size_t limit, std::vector<LimitTransition>& out);
+    void evaluateAll(std::vector<LimitTransition>& out);
+
+    std::shared_ptr<const RiskLimitTable> m_limits;
+
+    ComponentSnapshot m_components;
+    LimitBinding m_binding;
+    std::unordered_map<std::string, size_t> m_index;
+
+    // 按成分：基准权重/市值之比与当前未归一化权重
+    std::vector<double> m_scale;
+    std::vector<double> m_value;
+    std::vector<uint8_t> m_positionLevel;
+
+    // 按限额：未归一化暴露合计
+    std::vector<double> m_group;
+    std::vector<uint8_t> m_groupLevel;
+
+    double m_total = 1.0;
+    double m_totalAtRefresh = 1.0;
+};
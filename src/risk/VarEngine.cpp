@@ -0,0 +1,247 @@
+﻿#include "VarEngine.hpp"
+#include "core/CovarianceEngine.hpp"
+#include "core/IndexHistory.hpp"
+#include "core/LinearAlgebra.hpp"
+#include "core/Philox.hpp"
+#include "core/ThreadPool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+    // 计数器第4字区分随机流
+    const uint32_t STREAM_NORMAL = 0;
+    const uint32_t STREAM_CHI2 = 1;
+
+    Philox4x32::Counter counterOf(uint32_t index, size_t scenario, uint32_t stream) {
+        return {index, static_cast<uint32_t>(scenario),
+                static_cast<uint32_t>(static_cast<uint64_t>(scenario) >> 32), stream};
+    }
+
+    // 第s个场景的n个独立标准正态数：按块批量生成随机字，再逐对做Box-Muller变换
+    void fillNormals(size_t scenario, const Philox4x32::Key& key, double* out, size_t n) {
+        constexpr size_t LANES = 16;
+        uint32_t bits[4][LANES];
+        const size_t pairs = (n + 1) / 2;
+        for (size_t j0 = 0; j0 < pairs; j0 += LANES) {
+            Philox4x32::generateBlock(
+                counterOf(static_cast<uint32_t>(j0), scenario, STREAM_NORMAL), key, bits);
+            size_t len = std::min(LANES, pairs - j0);
+            for (size_t l = 0; l < len; ++l) {
+                Philox4x32::normalPair({bits[0][l], bits[1][l], bits[2][l], bits[3][l]},
+                                       out[2 * (j0 + l)], out[2 * (j0 + l) + 1]);
+            }
+        }
+    }
+
+    // 第s个场景的卡方(ν)随机数：2·Gamma(ν/2)，Marsaglia-Tsang拒绝采样（ν/2 > 1）
+    double chiSquare(size_t scenario, const Philox4x32::Key& key, double dof) {
+        const double d = dof / 2.0 - 1.0 / 3.0;
+        const double c = 1.0 / std::sqrt(9.0 * d);
+        for (uint32_t attempt = 0;; ++attempt) {
+            Philox4x32::Counter bits = Philox4x32::generate(
+                counterOf(attempt, scenario, STREAM_CHI2), key);
+            double z0, z1;
+            Philox4x32::normalPair(bits, z0, z1);
+            double v = 1.0 + c * z0;
+            if (v <= 0.0) {
+                continue;
+            }
+            v = v * v * v;
+            // 由z1经正态分布函数得到与z0独立的均匀数
+            double u = 0.5 * std::erfc(-z1 / std::sqrt(2.0));
+            if (u > 0.0 && std::log(u) < 0.5 * z0 * z0 + d - d * v + d * std::log(v)) {
+                return 2.0 * d * v;
+            }
+        }
+    }
+}
+
+VarSettings VarSettings::fromRules(const json& rules) {
+    VarSettings settings;
+    json cfg = rules.value("var", json::object());
+
+    settings.confidence = cfg.value("confidence", settings.confidence);
+    settings.scenarios = cfg.value("scenarios", settings.scenarios);
+    settings.window = cfg.value("window", settings.window);
+    settings.dof = cfg.value("dof", settings.dof);
+    settings.seed = cfg.value("seed", settings.seed);
+
+    std::string distribution = cfg.value("distribution", std::string("student_t"));
+    if (distribution == "normal") {
+        settings.distribution = VarDistribution::Normal;
+    } else if (distribution == "student_t") {
+        settings.distribution = VarDistribution::StudentT;
+    } else {
+        throw std::runtime_error("未知的VaR模拟分布: " + distribution);
+    }
+    return settings;
+}
+
+VarEngine::VarEngine(VarSettings settings) : m_settings(std::move(settings)) {
+    if (m_settings.confidence.empty()) {
+        throw std::runtime_error("VaR置信度不能为空");
+    }
+    for (double c : m_settings.confidence) {
+        if (c <= 0.0 || c >= 1.0) {
+            throw std::runtime_error("VaR置信度须位于(0, 1)");
+        }
+    }
+    if (m_settings.distribution == VarDistribution::StudentT && m_settings.dof <= 2.0) {
+        throw std::runtime_error("t分布自由度须大于2");
+    }
+}
+
+std::vector<VarEstimate> VarEngine::tailEstimates(double* losses, size_t count) const {
+    std::vector<VarEstimate> estimates;
+    if (count == 0) {
+        for (double c : m_settings.confidence) {
+            estimates.push_back({c, 0.0, 0.0});
+        }
+        return estimates;
+    }
+
+    auto rank = [count](double c) {
+        return std::min(count - 1, static_cast<size_t>(std::floor(c * static_cast<double>(count))));
+    };
+
+    // 仅对最低置信度以上的尾部排序
+    double lowest = *std::min_element(m_settings.confidence.begin(), m_settings.confidence.end());
+    size_t first = rank(lowest);
+    std::nth_element(losses, losses + first, losses + count);
+    std::sort(losses + first, losses + count);
+
+    for (double c : m_settings.confidence) {
+        size_t k = rank(c);
+        double tail = std::accumulate(losses + k, losses + count, 0.0);
+        estimates.push_back({c, losses[k], tail / static_cast<double>(count - k)});
+    }
+    return estimates;
+}
+
+VarResult VarEngine::historical(const IndexHistory& history,
+                                const std::vector<Component>& portfolio) const {
+    auto started = std::chrono::steady_clock::now();
+
+    std::vector<std::pair<size_t, double>> positions;
+    for (const auto& comp : portfolio) {
+        int col = history.columnOf(comp.reit.code);
+        if (col >= 0) {
+            positions.emplace_back(static_cast<size_t>(col), comp.weight);
+        }
+    }
+
+    const size_t periods = history.periodCount();
+    size_t first = 1;
+    if (m_settings.window > 0 && periods > m_settings.window + 1) {
+        first = periods - m_settings.window;
+    }
+
+    std::vector<double> losses;
+    for (size_t t = first; t < periods; ++t) {
+        const double* returns = history.returns(t);
+        double r = 0.0;
+        for (const auto& [col, weight] : positions) {
+            r += weight * returns[col];
+        }
+        losses.push_back(-r);
+    }
+
+    VarResult result;
+    result.scenarios = losses.size();
+    result.threads = 1;
+    result.estimates = tailEstimates(losses.data(), losses.size());
+    result.elapsed_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - started).count();
+    return result;
+}
+
+std::vector<VarResult> VarEngine::monteCarlo(const CovarianceSnapshot& covariance,
+                                             const std::vector<ComponentSnapshot>& portfolios,
+                                             ThreadPool& pool) const {
+    auto started = std::chrono::steady_clock::now();
+
+    // 各组合成分并集
+    std::vector<std::string> codes;
+    std::unordered_map<std::string, size_t> index;
+    for (const auto& portfolio : portfolios) {
+        for (const auto& comp : *portfolio) {
+            if (index.emplace(comp.reit.code, codes.size()).second) {
+                codes.push_back(comp.reit.code);
+            }
+        }
+    }
+    const size_t n = codes.size();
+    const size_t count = portfolios.size();
+    const size_t scenarios = m_settings.scenarios;
+
+    // Σ = L·Lᵀ；半正定时逐步加岭
+    std::vector<double> sigma = covariance.dense(codes);
+    double trace = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        trace += sigma[i * n + i];
+    }
+    std::vector<double> lower(n * n, 0.0);
+    if (trace > 0.0) {
+        double ridge = 0.0;
+        bool factored = false;
+        for (int attempt = 0; attempt < 8 && !factored; ++attempt) {
+            lower = sigma;
+            for (size_t i = 0; i < n; ++i) {
+                lower[i * n + i] += ridge;
+            }
+            factored = linalg::cholesky(lower.data(), n);
+            ridge = ridge == 0.0 ? 1e-12 * trace / static_cast<double>(n) : ridge * 10.0;
+        }
+        if (!factored) {
+            throw std::runtime_error("协方差矩阵无法分解");
+        }
+    }
+
+    // 线性组合收益 w·(L·ε) = (Lᵀw)·ε，t分布另按 sqrt((ν-2)/ν) 缩放使方差与Σ一致
+    const bool studentT = m_settings.distribution == VarDistribution::StudentT;
+    const double dof = m_settings.dof;
+    const double scale = studentT ? std::sqrt((dof - 2.0) / dof) : 1.0;
+    std::vector<double> loadings(count * n, 0.0);
+    for (size_t p = 0; p < count; ++p) {
+        double* b = &loadings[p * n];
+        for (const auto& comp : *portfolios[p]) {
+            size_t i = index[comp.reit.code];
+            const double* row = &lower[i * n];
+            for (size_t k = 0; k <= i; ++k) {
+                b[k] += scale * comp.weight * row[k];
+            }
+        }
+    }
+
+    const Philox4x32::Key key = Philox4x32::makeKey(m_settings.seed);
+    std::vector<double> losses(count * scenarios);
+
+    pool.parallelFor(0, scenarios, 4096, [&](size_t lo, size_t hi, size_t) {
+        std::vector<double> eps(n + 1);
+        for (size_t s = lo; s < hi; ++s) {
+            fillNormals(s, key, eps.data(), n);
+            double mix = studentT ? std::sqrt(dof / chiSquare(s, key, dof)) : 1.0;
+            for (size_t p = 0; p < count; ++p) {
+                losses[p * scenarios + s] = -mix * linalg::dot(&loadings[p * n], eps.data(), n);
+            }
+        }
+    });
+
+    std::vector<VarResult> results(count);
+    for (size_t p = 0; p < count; ++p) {
+        results[p].scenarios = scenarios;
+        results[p].threads = pool.size();
+        results[p].estimates = tailEstimates(&losses[p * scenarios], scenarios);
+    }
+
+    double elapsed = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - started).count();
+    for (auto& result : results) {
+        result.elapsed_ms = elapsed;
+    }
+    return results;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "core/IndexCalculator.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+class IndexHistory;
+class ThreadPool;
+struct CovarianceSnapshot;
+
+using json = nlohmann::json;
+
+// 蒙特卡洛收益分布
+enum class VarDistribution {
+    Normal,     // 相关正态
+    StudentT    // 多元t（t-copula + 同自由度t边际，按协方差缩放）
+};
+
+struct VarSettings {
+    std::vector<double> confidence = {0.95, 0.99};
+    size_t scenarios = 1000000;         // 蒙特卡洛场景数
+    size_t window = 250;                // 历史模拟期数
+    VarDistribution distribution = VarDistribution::StudentT;
+    double dof = 5.0;                   // t分布自由度（须大于2）
+    uint64_t seed = 20230101;
+
+    // 从规则配置的 "var" 节解析
+    static VarSettings fromRules(const json& rules);
+};
+
+// 单一置信度下的单期损失（收益率口径，正值为亏损）
+struct VarEstimate {
+    double confidence = 0.0;
+    double var = 0.0;
+    double cvar = 0.0;
+};
+
+struct VarResult {
+    std::vector<VarEstimate> estimates;     // 与settings.confidence一一对应
+    size_t scenarios = 0;
+    size_t threads = 0;
+    double elapsed_ms = 0.0;
+};
+
+// VaR/CVaR引擎：历史模拟与多线程蒙特卡洛
+// 蒙特卡洛第s个场景的随机数由Philox计数器(序号, s)生成，结果与线程数无关
+class VarEngine {
+public:
+    explicit VarEngine(VarSettings settings = {});
+
+    // 历史模拟：以当前权重回放最近window期的成分收益
+    VarResult historical(const IndexHistory& history, const std::vector<Component>& portfolio) const;
+
+    // 蒙特卡洛：多个组合共享同一批场景，协方差取自快照（单期口径、零均值）
+    std::vector<VarResult> monteCarlo(const CovarianceSnapshot& covariance,
+                                      const std::vector<ComponentSnapshot>& portfolios,
+                                      ThreadPool& pool) const;
+
+    const VarSettings& settings() const { return m_settings; }
+
+private:
+    // 由损失样本计算各置信度VaR/CVaR（样本会被重排）
+    std::vector<VarEstimate> tailEstimates(double* losses, size_t count) const;
+
+    VarSettings m_settings;
+};
@@ -0,0 +1,148 @@
+﻿#include "VolatilityEngine.hpp"
+#include "core/IndexHistory.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+VolatilitySettings VolatilitySettings::fromRules(const json& rules) {
+    VolatilitySettings settings;
+    json cfg = rules.value("volatility", json::object());
+
+    settings.windows = cfg.value("windows", settings.windows);
+    settings.lambda = cfg.value("lambda", settings.lambda);
+    settings.periods_per_year = cfg.value("periods_per_year", settings.periods_per_year);
+    return settings;
+}
+
+double VolatilitySnapshot::series(size_t s, size_t window) const {
+    const size_t columns = windows.size() + 1;
+    if (s >= observations.size()) {
+        return -1.0;
+    }
+    if (window == 0) {
+        return volatility[s * columns + windows.size()];
+    }
+    auto it = std::find(windows.begin(), windows.end(), window);
+    if (it == windows.end()) {
+        return -1.0;
+    }
+    return volatility[s * columns + (it - windows.begin())];
+}
+
+VolatilityEngine::VolatilityEngine(VolatilitySettings settings) : m_settings(std::move(settings)) {
+    if (m_settings.lambda <= 0.0 || m_settings.lambda >= 1.0) {
+        throw std::runtime_error("EWMA衰减因子须位于(0, 1)");
+    }
+    for (size_t window : m_settings.windows) {
+        if (window < 2) {
+            throw std::runtime_error("滚动窗口至少为2期");
+        }
+        m_maxWindow = std::max(m_maxWindow, window);
+    }
+
+    resize(1);
+    publish();
+}
+
+void VolatilityEngine::resize(size_t series) {
+    if (series <= m_series) {
+        return;
+    }
+    const size_t windows = m_settings.windows.size();
+    m_ring.resize(series * m_maxWindow, 0.0);
+    m_count.resize(series, 0);
+    m_mean.resize(series * windows, 0.0);
+    m_m2.resize(series * windows, 0.0);
+    m_ewma.resize(series, 0.0);
+    m_series = series;
+}
+
+void VolatilityEngine::observe(size_t s, double x) {
+    const size_t c = m_count[s];
+    const size_t windows = m_settings.windows.size();
+    double* ring = &m_ring[s * m_maxWindow];
+    double* mean = &m_mean[s * windows];
+    double* m2 = &m_m2[s * windows];
+
+    for (size_t k = 0; k < windows; ++k) {
+        const size_t w = m_settings.windows[k];
+        if (c < w) {
+            // Welford累加
+            double d = x - mean[k];
+            mean[k] += d / static_cast<double>(c + 1);
+            m2[k] += d * (x - mean[k]);
+        } else {
+            // 窗口已满：以新观测替换最旧观测
+            double old = ring[(c - w) % m_maxWindow];
+            double oldMean = mean[k];
+            mean[k] += (x - old) / static_cast<double>(w);
+            m2[k] += (x - old) * (x - mean[k] + old - oldMean);
+            m2[k] = std::max(m2[k], 0.0);
+        }
+    }
+    if (m_maxWindow > 0) {
+        ring[c % m_maxWindow] = x;
+    }
+
+    m_ewma[s] = c == 0 ? x * x
+                       : m_settings.lambda * m_ewma[s] + (1.0 - m_settings.lambda) * x * x;
+    m_count[s] = c + 1;
+}
+
+void VolatilityEngine::update(const IndexHistory& history, size_t t) {
+    if (t == 0 || t >= history.periodCount()) {
+        return;
+    }
+    const size_t n = history.constituentCount();
+    resize(n + 1);
+
+    const double* weights = history.weights(t - 1);
+    const double* capsBefore = history.marketCaps(t - 1);
+    const double* caps = history.marketCaps(t);
+    const double* returns = history.returns(t);
+
+    // 指数收益按上期末权重链接
+    double indexReturn = 0.0;
+    double totalWeight = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        indexReturn += weights[i] * returns[i];
+        totalWeight += weights[i];
+    }
+    if (totalWeight > 0.0) {
+        observe(0, indexReturn);
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        if (capsBefore[i] > 0.0 && caps[i] > 0.0) {
+            observe(i + 1, returns[i]);
+        }
+    }
+    publish();
+}
+
+void VolatilityEngine::publish() {
+    auto snap = std::make_shared<VolatilitySnapshot>();
+    snap->version = ++m_version;
+    snap->windows = m_settings.windows;
+    snap->observations = m_count;
+
+    const size_t windows = m_settings.windows.size();
+    const size_t columns = windows + 1;
+    const double annual = m_settings.periods_per_year;
+    snap->volatility.assign(m_series * columns, -1.0);
+
+    for (size_t s = 0; s < m_series; ++s) {
+        const size_t c = m_count[s];
+        if (c < 2) {
+            continue;
+        }
+        double* out = &snap->volatility[s * columns];
+        for (size_t k = 0; k < windows; ++k) {
+            size_t obs = std::min(c, m_settings.windows[k]);
+            out[k] = std::sqrt(m_m2[s * windows + k] / static_cast<double>(obs - 1) * annual);
+        }
+        out[windows] = std::sqrt(m_ewma[s] * annual);
+    }
+
+    m_snapshot.store(std::move(snap), std::memory_order_release);
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+class IndexHistory;
+
+using json = nlohmann::json;
+
+struct VolatilitySettings {
+    std::vector<size_t> windows = {20, 60, 250};    // 滚动窗口期数
+    double lambda = 0.94;                           // EWMA衰减因子
+    double periods_per_year = 250.0;                // 年化期数
+
+    // 从规则配置的 "volatility" 节解析
+    static VolatilitySettings fromRules(const json& rules);
+};
+
+// 只读波动率快照（年化；样本不足2期为-1）
+struct VolatilitySnapshot {
+    uint64_t version = 0;
+    std::vector<size_t> windows;
+
+    // 行：序列（0为指数，i+1为历史第i列），列：各滚动窗口 + EWMA
+    std::vector<double> volatility;
+    std::vector<size_t> observations;
+
+    // window为0时取EWMA，不在配置中的窗口返回-1
+    double indexVolatility(size_t window) const { return series(0, window); }
+    double reitVolatility(size_t column, size_t window) const { return series(column + 1, window); }
+
+    size_t indexObservations() const { return observations.empty() ? 0 : observations[0]; }
+
+private:
+    double series(size_t s, size_t window) const;
+};
+
+// 增量波动率引擎：逐序列维护各滚动窗口的Welford均值/二阶矩及EWMA方差，
+// 每期每序列O(窗口数)；成分缺席的期不计入该序列
+// update()须由单一写线程调用；snapshot()可被任意线程并发读取
+class VolatilityEngine {
+public:
+    explicit VolatilityEngine(VolatilitySettings settings = {});
+
+    // 追加指数历史第t期（t >= 1）：各REIT收益及按上期末权重链接的指数收益
+    void update(const IndexHistory& history, size_t t);
+
+    std::shared_ptr<const VolatilitySnapshot> snapshot() const {
+        return m_snapshot.load(std::memory_order_acquire);
+    }
+
+private:
+    // 扩展到s个序列
+    void resize(size_t series);
+
+    // 单序列加入一个观测
+    void observe(size_t s, double x);
+
+    void publish();
+
+    VolatilitySettings m_settings;
+    size_t m_maxWindow = 0;
+    size_t m_series = 0;
+    uint64_t m_version = 0;
+
+    // 按序列的环形缓冲（长度为最长窗口）与累计观测数
+    std::vector<double> m_ring;
+    std::vector<size_t> m_count;
+
+    // 各滚动窗口的均值与二阶中心矩：[s * 窗口数 + k]
+    std::vector<double> m_mean;
+    std::vector<double> m_m2;
+
+    // EWMA方差（零均值口径）
+    std::vector<double> m_ewma;
+
+    std::atomic<std::shared_ptr<const VolatilitySnapshot>> m_snapshot;
+};
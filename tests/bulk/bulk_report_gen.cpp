@@ -0,0 +1,75 @@
+﻿// 以同一日期、同一成分分别经批量生成与当日生成写出全部格式的报告，供CTest以cmp逐字节比对
+// 用法：bulk_report_gen <输出目录>，写出 <输出目录>/bulk.<扩展名> 与 <输出目录>/live.<扩展名>
+#include "compliance/BulkReporter.hpp"
+#include "core/IndexHistory.hpp"
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+namespace {
+    // 当日生成总是取本地当日，历史的最后一期须同日
+    int localDate() {
+        time_t now = time(nullptr);
+        tm local = *localtime(&now);
+        return (1900 + local.tm_year) * 10000 + (local.tm_mon + 1) * 100 + local.tm_mday;
+    }
+
+    REITList universe() {
+        return {
+            {"180101.SZ", "普洛斯 <仓储> & \"物流\"", "物流", "长三角", 3000001234.5, 5e7, 0.95, 0.3},
+            {"180102.SZ", "博时招商蛇口产业园,\"A\"", "产业园", "珠三角", 2.5e9, 1.2e8, 0.9, 0.1},
+            {"508000.SH", "华安张江光大园", "产业园", "长三角", 1.75e9, 6e7, 0.975, 0.2},
+            {"508001.SH", "浙商沪杭甬", "高速公路", "长三角", 4.1e9, 3.3e8, 1.0, 0.45},
+        };
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "用法: bulk_report_gen <输出目录>" << std::endl;
+        return 2;
+    }
+    try {
+        const fs::path out = argv[1];
+        const std::vector<ReportFormat> formats(std::begin(kReportFormats), std::end(kReportFormats));
+
+        REITList reits = universe();
+        std::vector<Component> components;
+        for (size_t i = 0; i < reits.size(); ++i) {
+            Component comp;
+            comp.reit = reits[i];
+            comp.weight = (i + 1) / 10.0;
+            components.push_back(std::move(comp));
+        }
+        IndexHistory history;
+        const int date = localDate();
+        history.recordSnapshot(date, reits, components);
+
+        ComplianceReporter reporter;
+        reporter.setReportPath((out / "live").string() + "/");
+
+        BulkReportSettings settings;
+        settings.output_path = (out / "bulk").string();
+        settings.formats = formats;
+        settings.threads = 2;
+        BulkReporter bulk(reporter, settings);
+        BulkReportMetrics metrics = bulk.run(history, nullptr, 0, history.periodCount());
+        if (metrics.failed > 0) {
+            throw std::runtime_error(metrics.first_error);
+        }
+
+        std::vector<std::string> live = reporter.generate(formats, history.componentsAt(0));
+        for (size_t k = 0; k < formats.size(); ++k) {
+            const std::string extension = reportExtension(formats[k]);
+            fs::copy_file(bulk.reportPath(BulkReporter::kIndexFund, date, formats[k]),
+                          out / ("bulk" + extension), fs::copy_options::overwrite_existing);
+            fs::copy_file(live[k], out / ("live" + extension), fs::copy_options::overwrite_existing);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "报告生成失败: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,136 @@
+﻿#include <gtest/gtest.h>
+#include "compliance/AuditJournal.hpp"
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+    class AuditJournalTest : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            dir = fs::temp_directory_path() /
+                  ("reits_journal_" + std::string(::testing::UnitTest::GetInstance()
+                                                      ->current_test_info()->name()));
+            fs::remove_all(dir);
+            fs::create_directories(dir);
+            settings.path = (dir / "audit.journal").string();
+            settings.fsync_batch = 1;
+        }
+        void TearDown() override { fs::remove_all(dir); }
+
+        // 追加count条记录（第k条的计算日为20240100 + k）
+        void appendRecords(size_t count) {
+            AuditJournal journal(settings);
+            REIT reit{"508000", "测试REIT", "物流", "长三角", 1e9, 4e7, 0.95, 0.3};
+            for (size_t k = 1; k <= count; ++k) {
+                double level = 1000.0 + static_cast<double>(k);
+                journal.append(20240100 + static_cast<int>(k), k, 7, {level, level, level},
+                               {{reit, 1.0}});
+            }
+        }
+
+        std::vector<AuditRecordHeader> headers() {
+            std::vector<AuditRecordHeader> out;
+            AuditJournalReader(settings.path).scan([&](const AuditRecordHeader& h) {
+                out.push_back(h);
+                return true;
+            });
+            return out;
+        }
+
+        // 在文件偏移offset处按位取反一个字节
+        void flipByte(uint64_t offset) {
+            std::fstream file(settings.path, std::ios::in | std::ios::out | std::ios::binary);
+            file.seekg(static_cast<std::streamoff>(offset));
+            char c = 0;
+            file.read(&c, 1);
+            c = static_cast<char>(~c);
+            file.seekp(static_cast<std::streamoff>(offset));
+            file.write(&c, 1);
+        }
+
+        fs::path dir;
+        AuditJournalSettings settings;
+    };
+}
+
+TEST_F(AuditJournalTest, TornTailIsTrimmedAndSequenceContinues) {
+    appendRecords(5);
+    const std::vector<AuditRecordHeader> before = headers();
+    ASSERT_EQ(before.size(), 5u);
+
+    // 掉电：最后一帧只写入了一部分
+    const uint64_t size = fs::file_size(settings.path);
+    fs::resize_file(settings.path, size - 7);
+
+    {
+        AuditJournal journal(settings);
+        EXPECT_EQ(journal.stats().recovered_bytes, size - 7 - before[4].offset);
+        EXPECT_EQ(journal.stats().last_sequence, 4u);
+        REIT reit{"508001", "续写", "物流", "长三角", 1e9, 0.0, 0.95, 0.3};
+        EXPECT_EQ(journal.append(20240199, 1, 7, {1.0, 1.0, 1.0}, {{reit, 1.0}}), 5u);
+    }
+
+    const std::vector<AuditRecordHeader> after = headers();
+    ASSERT_EQ(after.size(), 5u);
+    for (size_t k = 0; k < 4; ++k) {
+        EXPECT_EQ(after[k].sequence, before[k].sequence);
+        EXPECT_EQ(after[k].date, before[k].date);
+    }
+    EXPECT_EQ(after[4].date, 20240199);
+    EXPECT_EQ(after[4].offset, before[4].offset);
+}
+
+TEST_F(AuditJournalTest, ZeroFilledTailIsTrimmed) {
+    appendRecords(3);
+    const uint64_t size = fs::file_size(settings.path);
+    {
+        std::ofstream file(settings.path, std::ios::binary | std::ios::app);
+        const std::string zeros(4096, '\0');
+        file.write(zeros.data(), static_cast<std::streamsize>(zeros.size()));
+    }
+
+    AuditJournal journal(settings);
+    EXPECT_EQ(journal.stats().recovered_bytes, 4096u);
+    EXPECT_EQ(journal.stats().last_sequence, 3u);
+    EXPECT_EQ(fs::file_size(settings.path), size);
+}
+
+TEST_F(AuditJournalTest, MidFileCorruptionRequiresExplicitRepair) {
+    appendRecords(5);
+    const std::vector<AuditRecordHeader> before = headers();
+    const uint64_t size = fs::file_size(settings.path);
+
+    // 第2条记录载荷损坏，其后仍有有效记录：拒绝打开，不截去有效记录
+    flipByte(before[1].offset + 8 + 20);
+    EXPECT_THROW(AuditJournal journal(settings), std::runtime_error);
+    EXPECT_EQ(fs::file_size(settings.path), size);
+
+    AuditRepairResult repaired = AuditJournal::repair(settings.path);
+    EXPECT_EQ(repaired.records, 4u);
+    EXPECT_EQ(repaired.dropped_bytes, before[2].offset - before[1].offset);
+    ASSERT_FALSE(repaired.backup.empty());
+    EXPECT_EQ(fs::file_size(repaired.backup), size);
+
+    // 修复后保留原序号，可继续追加
+    const std::vector<AuditRecordHeader> after = headers();
+    ASSERT_EQ(after.size(), 4u);
+    EXPECT_EQ(after[0].sequence, 1u);
+    EXPECT_EQ(after[1].sequence, 3u);
+    EXPECT_EQ(after[3].sequence, 5u);
+
+    AuditJournal journal(settings);
+    EXPECT_EQ(journal.stats().recovered_bytes, 0u);
+    EXPECT_EQ(journal.stats().last_sequence, 5u);
+}
+
+TEST_F(AuditJournalTest, RepairLeavesIntactJournalUntouched) {
+    appendRecords(3);
+    const uint64_t size = fs::file_size(settings.path);
+    AuditRepairResult repaired = AuditJournal::repair(settings.path);
+    EXPECT_EQ(repaired.records, 3u);
+    EXPECT_EQ(repaired.dropped_bytes, 0u);
+    EXPECT_TRUE(repaired.backup.empty());
+    EXPECT_EQ(fs::file_size(settings.path), size);
+}
@@ -0,0 +1,170 @@
+﻿#include <gtest/gtest.h>
+#include "core/CovarianceEngine.hpp"
+#include "core/IndexHistory.hpp"
+#include <cmath>
+
+namespace {
+    const double NaN = std::nan("");
+
+    // 三只代码12期收益，B第5期起上市，C中间两期停牌
+    const std::vector<std::vector<double>> kReturns = {
+        { 0.010,   NaN,  0.004}, {-0.020,   NaN, -0.011}, { 0.015,   NaN,  0.006},
+        { 0.003,   NaN,    NaN}, {-0.008,  0.020,   NaN}, { 0.012, -0.015,  0.009},
+        {-0.004,  0.007, -0.002}, { 0.009,  0.011,  0.005}, {-0.013, -0.009, -0.008},
+        { 0.006,  0.004,  0.001}, { 0.002, -0.006,  0.003}, {-0.007,  0.013, -0.004},
+    };
+
+    // 暴力计算：第[from, to)期中两者均有观测的样本协方差
+    double pairwiseCovariance(size_t a, size_t b, size_t from, size_t to) {
+        std::vector<std::pair<double, double>> pairs;
+        for (size_t t = from; t < to; ++t) {
+            if (!std::isnan(kReturns[t][a]) && !std::isnan(kReturns[t][b])) {
+                pairs.emplace_back(kReturns[t][a], kReturns[t][b]);
+            }
+        }
+        if (pairs.size() < 2) {
+            return 0.0;
+        }
+        double meanA = 0.0, meanB = 0.0;
+        for (const auto& [x, y] : pairs) {
+            meanA += x;
+            meanB += y;
+        }
+        meanA /= pairs.size();
+        meanB /= pairs.size();
+        double cov = 0.0;
+        for (const auto& [x, y] : pairs) {
+            cov += (x - meanA) * (y - meanB);
+        }
+        return cov / (pairs.size() - 1);
+    }
+
+    CovarianceSettings rolling(size_t window) {
+        CovarianceSettings settings;
+        settings.method = CovarianceMethod::Rolling;
+        settings.window = window;
+        return settings;
+    }
+}
+
+TEST(CovarianceEngineTest, RollingSkipsMissingObservationsPerPair) {
+    CovarianceEngine engine({"A", "B", "C"}, rolling(50));
+    for (const auto& r : kReturns) {
+        engine.update(r.data());
+    }
+    auto snap = engine.snapshot();
+    for (size_t a = 0; a < 3; ++a) {
+        for (size_t b = a; b < 3; ++b) {
+            EXPECT_NEAR(snap->matrix.at(a, b), pairwiseCovariance(a, b, 0, kReturns.size()), 1e-15)
+                << a << "," << b;
+        }
+    }
+}
+
+TEST(CovarianceEngineTest, RollingEvictsMissingObservationsPerPair) {
+    const size_t window = 4;
+    CovarianceEngine engine({"A", "B", "C"}, rolling(window));
+    for (size_t t = 0; t < kReturns.size(); ++t) {
+        engine.update(kReturns[t].data());
+        size_t from = t + 1 > window ? t + 1 - window : 0;
+        auto snap = engine.snapshot();
+        for (size_t a = 0; a < 3; ++a) {
+            for (size_t b = a; b < 3; ++b) {
+                EXPECT_NEAR(snap->matrix.at(a, b), pairwiseCovariance(a, b, from, t + 1), 1e-15)
+                    << "t=" << t << " " << a << "," << b;
+            }
+        }
+    }
+}
+
+TEST(CovarianceEngineTest, EwmaIgnoresPreListingPeriods) {
+    // B上市前的期不影响其方差：与只见到上市后收益的引擎一致
+    CovarianceEngine full({"A", "B"});
+    CovarianceEngine listed({"B"});
+    for (const auto& r : kReturns) {
+        full.update(r.data());
+        if (!std::isnan(r[1])) {
+            listed.update(&r[1]);
+        }
+    }
+    EXPECT_GT(listed.snapshot()->matrix.at(0, 0), 0.0);
+    EXPECT_DOUBLE_EQ(full.snapshot()->matrix.at(1, 1), listed.snapshot()->matrix.at(0, 0));
+}
+
+TEST(CovarianceEngineTest, EwmaLeavesUnobservedPairsUntouched) {
+    CovarianceEngine engine({"A", "B", "C"});
+    for (size_t t = 0; t < 3; ++t) {
+        engine.update(kReturns[t].data());
+    }
+    auto before = engine.snapshot();
+
+    // C缺测：C所在的对既不更新也不衰减，A的方差照常更新
+    const double r[] = {0.02, NaN, NaN};
+    engine.update(r);
+    auto after = engine.snapshot();
+    EXPECT_EQ(after->matrix.at(2, 2), before->matrix.at(2, 2));
+    EXPECT_EQ(after->matrix.at(0, 2), before->matrix.at(0, 2));
+    EXPECT_NE(after->matrix.at(0, 0), before->matrix.at(0, 0));
+    EXPECT_EQ(after->matrix.at(1, 1), 0.0);
+}
+
+TEST(CovarianceEngineTest, AddCodesKeepsExistingState) {
+    // 先只有A、C，第5期起追加B，应与一开始就含B（此前缺测）的引擎逐位一致
+    for (CovarianceSettings settings : {CovarianceSettings{}, rolling(4)}) {
+        CovarianceEngine grown({"A", "C"}, settings);
+        CovarianceEngine complete({"A", "C", "B"}, settings);
+        for (size_t t = 0; t < kReturns.size(); ++t) {
+            const auto& r = kReturns[t];
+            if (t == 4) {
+                grown.addCodes({"A", "B"});
+                ASSERT_EQ(grown.size(), 3u);
+                EXPECT_EQ(grown.indexOf("B"), 2);
+            }
+            const double reordered[] = {r[0], r[2], r[1]};
+            grown.update(reordered);
+            complete.update(reordered);
+        }
+        auto a = grown.snapshot();
+        auto b = complete.snapshot();
+        EXPECT_EQ(*a->codes, *b->codes);
+        EXPECT_EQ(a->observations, b->observations);
+        for (size_t i = 0; i < 3; ++i) {
+            for (size_t j = i; j < 3; ++j) {
+                EXPECT_EQ(a->matrix.at(i, j), b->matrix.at(i, j)) << i << "," << j;
+            }
+        }
+    }
+}
+
+TEST(CovarianceEngineTest, HistoryMarksPeriodsOutsideTheSampleAsMissing) {
+    // B第3期纳入样本：第3期无上期市值，第4期起才有收益
+    IndexHistory history;
+    const double capsA[] = {100.0, 101.0, 99.0, 102.0, 103.0, 100.5};
+    const double capsB[] = {0.0, 0.0, 50.0, 51.0, 49.5, 50.5};
+    for (size_t t = 0; t < 6; ++t) {
+        REITList universe = {{"A", "A", "物流", "长三角", capsA[t], 0.0, 0.95, 0.3}};
+        if (capsB[t] > 0.0) {
+            universe.push_back({"B", "B", "物流", "长三角", capsB[t], 0.0, 0.95, 0.3});
+        }
+        history.recordSnapshot(20240101 + static_cast<int>(t), universe, {});
+    }
+
+    CovarianceEngine fromHistory({"A", "B"}, rolling(10));
+    CovarianceEngine manual({"A", "B"}, rolling(10));
+    for (size_t t = 1; t < history.periodCount(); ++t) {
+        fromHistory.update(history, t);
+        const double r[] = {
+            capsA[t] / capsA[t - 1] - 1.0,
+            capsB[t - 1] > 0.0 ? capsB[t] / capsB[t - 1] - 1.0 : NaN
+        };
+        manual.update(r);
+    }
+    auto a = fromHistory.snapshot();
+    auto b = manual.snapshot();
+    for (size_t i = 0; i < 2; ++i) {
+        for (size_t j = i; j < 2; ++j) {
+            EXPECT_DOUBLE_EQ(a->matrix.at(i, j), b->matrix.at(i, j)) << i << "," << j;
+        }
+    }
+    EXPECT_GT(a->matrix.at(1, 1), 0.0);
+}
@@ -0,0 +1,136 @@
+﻿#include <gtest/gtest.h>
+#include "core/IndexCalculator.hpp"
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+    // 点位计算只用到基点与分红税率
+    IndexCalculator makeCalculator(const fs::path& dir) {
+        const fs::path rules = dir / "rules.json";
+        std::ofstream(rules) << R"({"base_value": 1000.0, "total_return": {"dividend_tax_rate": 0.2}})";
+        IndexCalculator calculator;
+        calculator.loadRules(rules.string());
+        return calculator;
+    }
+
+    REIT reit(const std::string& code, double marketCap, double dividend = 0.0, int exDate = 0) {
+        REIT r{code, code, "物流", "长三角", marketCap, dividend, 0.95, 0.3};
+        r.ex_dividend_date = exDate;
+        return r;
+    }
+
+    class IndexLevelsTest : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            dir = fs::temp_directory_path() /
+                  ("reits_levels_" + std::string(::testing::UnitTest::GetInstance()
+                                                     ->current_test_info()->name()));
+            fs::remove_all(dir);
+            fs::create_directories(dir);
+        }
+        void TearDown() override { fs::remove_all(dir); }
+
+        fs::path dir;
+    };
+}
+
+TEST_F(IndexLevelsTest, FirstCalculationStartsAtBaseValue) {
+    IndexCalculator calculator = makeCalculator(dir);
+    REITList universe = {reit("A", 100.0), reit("B", 100.0)};
+    IndexLevels levels = calculator.calculateIndexLevels(
+        {{universe[0], 0.5}, {universe[1], 0.5}}, universe, 20240101);
+    EXPECT_DOUBLE_EQ(levels.price, 1000.0);
+    EXPECT_DOUBLE_EQ(levels.total_return, 1000.0);
+    EXPECT_DOUBLE_EQ(levels.net_total_return, 1000.0);
+}
+
+TEST_F(IndexLevelsTest, RemovedConstituentEarnsItsActualReturn) {
+    IndexCalculator calculator = makeCalculator(dir);
+    REITList day1 = {reit("A", 100.0), reit("B", 100.0)};
+    calculator.calculateIndexLevels({{day1[0], 0.5}, {day1[1], 0.5}}, day1, 20240101);
+
+    // B调出，当日下跌10%：收益仍按上一期权重计入，A上涨10%与之抵消
+    REITList day2 = {reit("A", 110.0), reit("B", 90.0)};
+    IndexLevels levels = calculator.calculateIndexLevels({{day2[0], 1.0}}, day2, 20240102);
+    EXPECT_NEAR(levels.price, 1000.0, 1e-9);
+
+    // 下一期只按A链接
+    REITList day3 = {reit("A", 121.0), reit("B", 45.0)};
+    levels = calculator.calculateIndexLevels({{day3[0], 1.0}}, day3, 20240103);
+    EXPECT_NEAR(levels.price, 1100.0, 1e-9);
+}
+
+TEST_F(IndexLevelsTest, RemovedConstituentDividendIsReinvested) {
+    IndexCalculator calculator = makeCalculator(dir);
+    REITList day1 = {reit("A", 100.0), reit("B", 100.0)};
+    calculator.calculateIndexLevels({{day1[0], 0.5}, {day1[1], 0.5}}, day1, 20240101);
+
+    // B于调出当日除息：价格指数只计价差，全收益计入分红，净收益扣税20%
+    REITList day2 = {reit("A", 100.0), reit("B", 96.0, 4.0, 20240102)};
+    IndexLevels levels = calculator.calculateIndexLevels({{day2[0], 1.0}}, day2, 20240102);
+    EXPECT_NEAR(levels.price, 1000.0 * (1.0 + 0.5 * -0.04), 1e-9);
+    EXPECT_NEAR(levels.total_return, 1000.0, 1e-9);
+    EXPECT_NEAR(levels.net_total_return, 1000.0 * (1.0 + 0.5 * (-0.04 + 0.04 * 0.8)), 1e-9);
+}
+
+TEST_F(IndexLevelsTest, MissingQuoteRenormalizesOverSurvivors) {
+    IndexCalculator calculator = makeCalculator(dir);
+    REITList day1 = {reit("A", 100.0), reit("B", 100.0), reit("C", 100.0)};
+    calculator.calculateIndexLevels(
+        {{day1[0], 0.5}, {day1[1], 0.25}, {day1[2], 0.25}}, day1, 20240101);
+
+    // C当日无行情：按A、B的权重2:1归一
+    REITList day2 = {reit("A", 103.0), reit("B", 94.0)};
+    IndexLevels levels = calculator.calculateIndexLevels(
+        {{day2[0], 0.6}, {day2[1], 0.4}}, day2, 20240102);
+    EXPECT_NEAR(levels.price, 1000.0 * (1.0 + (0.5 * 0.03 + 0.25 * -0.06) / 0.75), 1e-9);
+}
+
+TEST_F(IndexLevelsTest, AddedConstituentCountsFromNextPeriod) {
+    IndexCalculator calculator = makeCalculator(dir);
+    REITList day1 = {reit("A", 100.0), reit("B", 100.0)};
+    calculator.calculateIndexLevels({{day1[0], 1.0}}, day1, 20240101);
+
+    // B纳入当期的涨幅不计入指数
+    REITList day2 = {reit("A", 102.0), reit("B", 150.0)};
+    IndexLevels levels = calculator.calculateIndexLevels(
+        {{day2[0], 0.5}, {day2[1], 0.5}}, day2, 20240102);
+    EXPECT_NEAR(levels.price, 1020.0, 1e-9);
+
+    REITList day3 = {reit("A", 102.0), reit("B", 165.0)};
+    levels = calculator.calculateIndexLevels({{day3[0], 0.5}, {day3[1], 0.5}}, day3, 20240103);
+    EXPECT_NEAR(levels.price, 1020.0 * 1.05, 1e-9);
+}
+
+TEST_F(IndexLevelsTest, RestoredStateContinuesTheChain) {
+    const std::string stateFile = (dir / "index_levels.json").string();
+    REITList day1 = {reit("A", 100.0), reit("B", 100.0)};
+    REITList day2 = {reit("A", 110.0), reit("B", 105.0)};
+    REITList day3 = {reit("A", 99.0), reit("B", 105.0, 2.1, 20240103)};
+
+    IndexCalculator continuous = makeCalculator(dir);
+    continuous.calculateIndexLevels({{day1[0], 0.5}, {day1[1], 0.5}}, day1, 20240101);
+    continuous.calculateIndexLevels({{day2[0], 0.4}, {day2[1], 0.6}}, day2, 20240102);
+    continuous.saveLevelState(stateFile);
+    IndexLevels expected = continuous.calculateIndexLevels({{day3[0], 1.0}}, day3, 20240103);
+
+    // 重启：新实例恢复状态后接续点位，而不是回到基点
+    IndexCalculator restarted = makeCalculator(dir);
+    restarted.loadLevelState(stateFile);
+    IndexLevels levels = restarted.calculateIndexLevels({{day3[0], 1.0}}, day3, 20240103);
+    EXPECT_DOUBLE_EQ(levels.price, expected.price);
+    EXPECT_DOUBLE_EQ(levels.total_return, expected.total_return);
+    EXPECT_DOUBLE_EQ(levels.net_total_return, expected.net_total_return);
+    EXPECT_NE(levels.price, 1000.0);
+    EXPECT_FALSE(fs::exists(stateFile + ".tmp"));
+}
+
+TEST_F(IndexLevelsTest, CorruptStateFileIsRejected) {
+    const fs::path stateFile = dir / "index_levels.json";
+    std::ofstream(stateFile) << R"({"date": 20240101, "price": 1000.0})";
+    IndexCalculator calculator = makeCalculator(dir);
+    EXPECT_THROW(calculator.loadLevelState(stateFile.string()), std::runtime_error);
+    EXPECT_THROW(calculator.loadLevelState((dir / "missing.json").string()), std::runtime_error);
+}
@@ -0,0 +1,170 @@
+﻿#include <gtest/gtest.h>
+#include "compliance/ReportStore.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+    class ReportStoreTest : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            dir = fs::temp_directory_path() /
+                  ("reits_store_" + std::string(::testing::UnitTest::GetInstance()
+                                                    ->current_test_info()->name()));
+            fs::remove_all(dir);
+            settings.path = (dir / "store").string();
+        }
+        void TearDown() override { fs::remove_all(dir); }
+
+        static std::string text(const std::optional<StoredReport>& report) {
+            return report ? std::string(report->data) : std::string("<none>");
+        }
+
+        static ReportRecord record(int date, int hhmmss, ReportFormat format, std::string data) {
+            return {makeReportKey(date, hhmmss), format, std::move(data)};
+        }
+
+        fs::path dir;
+        ReportStoreSettings settings;
+    };
+}
+
+TEST_F(ReportStoreTest, LaterPutOverridesEarlierVersion) {
+    const ReportKey key = makeReportKey(20240115, 150000);
+    ReportStore store(settings);
+    uint64_t first = store.put({record(20240115, 150000, ReportFormat::Json, "v1"),
+                                record(20240115, 150000, ReportFormat::Csv, "csv")});
+    uint64_t second = store.put({record(20240115, 150000, ReportFormat::Json, "v2")});
+    EXPECT_GT(second, first);
+
+    // 新段覆盖同键同格式的旧版本，其他格式不受影响
+    EXPECT_EQ(text(store.get(key, ReportFormat::Json)), "v2");
+    EXPECT_EQ(text(store.get(key, ReportFormat::Csv)), "csv");
+
+    std::vector<std::string> seen;
+    store.scan(key, key, ReportFormat::Json, [&](const StoredReport& r) {
+        seen.emplace_back(r.data);
+        return true;
+    });
+    EXPECT_EQ(seen, std::vector<std::string>{"v2"});
+    EXPECT_EQ(store.stats().entries, 3u);
+}
+
+TEST_F(ReportStoreTest, LastRecordInBatchWins) {
+    ReportStore store(settings);
+    store.put({record(20240115, 150000, ReportFormat::Json, "a"),
+               record(20240115, 150000, ReportFormat::Json, "b")});
+    EXPECT_EQ(text(store.get(makeReportKey(20240115, 150000), ReportFormat::Json)), "b");
+    EXPECT_EQ(store.stats().entries, 1u);
+}
+
+TEST_F(ReportStoreTest, OverrideSurvivesReopen) {
+    {
+        ReportStore store(settings);
+        store.put({record(20240115, 150000, ReportFormat::Json, "v1")});
+        store.put({record(20240115, 150000, ReportFormat::Json, "v2")});
+        store.put({record(20240115, 160000, ReportFormat::Json, "late")});
+    }
+    ReportStore store(settings);
+    EXPECT_EQ(text(store.get(makeReportKey(20240115, 150000), ReportFormat::Json)), "v2");
+    EXPECT_EQ(text(store.latest(20240115, ReportFormat::Json)), "late");
+    EXPECT_FALSE(store.latest(20240116, ReportFormat::Json));
+}
+
+TEST_F(ReportStoreTest, CompactionMergesDueMonthsAndKeepsNewestVersions) {
+    {
+        ReportStore store(settings);
+        store.put({record(20240105, 150000, ReportFormat::Json, "jan5-v1")});
+        store.put({record(20240120, 150000, ReportFormat::Json, "jan20")});
+        store.put({record(20240105, 150000, ReportFormat::Json, "jan5-v2")});
+        store.put({record(20240210, 150000, ReportFormat::Json, "feb10")});
+        store.put({record(20240301, 150000, ReportFormat::Json, "mar1")});
+        ASSERT_EQ(store.stats().segments, 5u);
+
+        ReportCompactionStats done = store.compact(202403);
+        EXPECT_EQ(done.months, 2u);
+        EXPECT_EQ(done.segments_merged, 4u);
+        EXPECT_EQ(done.reports, 3u);
+
+        ReportStoreStats stats = store.stats();
+        EXPECT_EQ(stats.segments, 3u);
+        EXPECT_EQ(stats.archives, 2u);
+        EXPECT_EQ(stats.entries, 4u);
+        EXPECT_EQ(text(store.get(makeReportKey(20240105, 150000), ReportFormat::Json)), "jan5-v2");
+
+        // 已归档月份再写入新版本仍覆盖归档中的旧版本
+        store.put({record(20240120, 150000, ReportFormat::Json, "jan20-v2")});
+        EXPECT_EQ(text(store.get(makeReportKey(20240120, 150000), ReportFormat::Json)), "jan20-v2");
+
+        // 已压缩的月份再次压缩只合并新写入的段
+        done = store.compact(202403);
+        EXPECT_EQ(done.months, 1u);
+        EXPECT_EQ(store.stats().archives, 2u);
+    }
+
+    ReportStore store(settings);
+    EXPECT_EQ(text(store.get(makeReportKey(20240105, 150000), ReportFormat::Json)), "jan5-v2");
+    EXPECT_EQ(text(store.get(makeReportKey(20240120, 150000), ReportFormat::Json)), "jan20-v2");
+    EXPECT_EQ(text(store.get(makeReportKey(20240210, 150000), ReportFormat::Json)), "feb10");
+    EXPECT_EQ(text(store.get(makeReportKey(20240301, 150000), ReportFormat::Json)), "mar1");
+    size_t visited = store.scan(makeReportKey(20240101), makeReportKey(20240331, 235959),
+                                std::nullopt, [](const StoredReport&) { return true; });
+    EXPECT_EQ(visited, 4u);
+}
+
+TEST_F(ReportStoreTest, CompactionDefersMonthSharedWithUndueMonth) {
+    ReportStore store(settings);
+    store.put({record(20240110, 150000, ReportFormat::Json, "jan")});
+    store.put({record(20240220, 150000, ReportFormat::Json, "feb"),
+               record(20240305, 150000, ReportFormat::Json, "mar")});
+
+    // 二月的段也含三月的报告：本次只压缩一月
+    ReportCompactionStats done = store.compact(202403);
+    EXPECT_EQ(done.months, 1u);
+    EXPECT_EQ(done.segments_merged, 1u);
+    EXPECT_EQ(store.stats().archives, 1u);
+    EXPECT_EQ(text(store.get(makeReportKey(20240220, 150000), ReportFormat::Json)), "feb");
+    EXPECT_EQ(text(store.get(makeReportKey(20240305, 150000), ReportFormat::Json)), "mar");
+}
+
+TEST_F(ReportStoreTest, CorruptSegmentIsQuarantined) {
+    {
+        ReportStore store(settings);
+        store.put({record(20240101, 150000, ReportFormat::Json, "a")});
+        store.put({record(20240102, 150000, ReportFormat::Json, "b")});
+        store.put({record(20240103, 150000, ReportFormat::Json, "c")});
+    }
+
+    // 损坏第二个段尾部受CRC保护的字节
+    std::vector<fs::path> segments;
+    for (const auto& entry : fs::directory_iterator(settings.path)) {
+        if (entry.path().extension() == ".seg") {
+            segments.push_back(entry.path());
+        }
+    }
+    std::sort(segments.begin(), segments.end());
+    ASSERT_EQ(segments.size(), 3u);
+    {
+        std::fstream file(segments[1], std::ios::in | std::ios::out | std::ios::binary);
+        file.seekg(-20, std::ios::end);
+        char c = 0;
+        file.read(&c, 1);
+        c = static_cast<char>(~c);
+        file.seekp(-20, std::ios::end);
+        file.write(&c, 1);
+    }
+
+    ReportStore store(settings);
+    ASSERT_EQ(store.quarantined().size(), 1u);
+    EXPECT_EQ(store.quarantined()[0].path, segments[1].string());
+    EXPECT_TRUE(fs::exists(store.quarantined()[0].moved_to));
+    EXPECT_FALSE(fs::exists(segments[1]));
+    EXPECT_EQ(text(store.get(makeReportKey(20240101, 150000), ReportFormat::Json)), "a");
+    EXPECT_FALSE(store.get(makeReportKey(20240102, 150000), ReportFormat::Json));
+    EXPECT_EQ(text(store.get(makeReportKey(20240103, 150000), ReportFormat::Json)), "c");
+
+    // 隔离段的文件编号不再复用
+    EXPECT_EQ(store.put({record(20240104, 150000, ReportFormat::Json, "d")}), 4u);
+}
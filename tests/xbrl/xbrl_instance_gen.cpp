@@ -0,0 +1,57 @@
+﻿// 生成覆盖边界情形的XBRL实例，供CTest以xmllint按分类标准校验
+// 用法：xbrl_instance_gen <单基金实例> <多基金实例> [schemaRef]
+#include "compliance/ComplianceReporter.hpp"
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <memory>
+
+namespace {
+    Component component(REIT reit, double weight) {
+        Component comp;
+        comp.reit = std::move(reit);
+        comp.weight = weight;
+        return comp;
+    }
+
+    // 含须转义字符、XML非法控制字符与非有限数值的成分
+    std::vector<Component> edgeComponents() {
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        const double inf = std::numeric_limits<double>::infinity();
+        std::vector<Component> components;
+        components.push_back(component({"180101.SZ", "普洛斯 <仓储> & \"物流\"", "物流'仓储", "长三角",
+                                        3000001234.5, 5e7, 0.95, 0.3}, 0.1));
+        components.push_back(component({"180102.SZ", "控制\x01字符\x1f", "产业园", "珠三角",
+                                        2.5e9, 1e-7, 0.9, 0.1}, 1.0 / 3));
+        components.push_back(component({"180103.SZ", "非有限数值", "仓储", "京津冀",
+                                        nan, inf, -inf, 0.0}, 1e-20));
+        components.push_back(component({"180104.SZ", "", "", "", 0.0, 0.0, 0.0, 0.0}, 0.0));
+        return components;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "用法: xbrl_instance_gen <单基金实例> <多基金实例> [schemaRef]" << std::endl;
+        return 2;
+    }
+    try {
+        ComplianceReporter reporter;
+        reporter.setXbrlSchemaRef(argc > 3 ? argv[3] : "reits-index.xsd");
+
+        std::vector<Component> components = edgeComponents();
+        reporter.writeXbrlReport(components, argv[1], "2026-10-19");
+
+        auto snapshot = std::make_shared<const std::vector<Component>>(components);
+        std::vector<XbrlFund> funds = {
+            {"REITS50", snapshot},
+            {"FUND & <CO>", snapshot},
+            {"EMPTY", std::make_shared<const std::vector<Component>>()},
+        };
+        reporter.writeXbrlReport(funds, argv[2], "2026-10-19");
+    } catch (const std::exception& e) {
+        std::cerr << "XBRL实例生成失败: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}